@@ -7,12 +7,85 @@
 
 #include "adc.h"
 #include "app_ui.h"
+#include "app_signal.h"
 #include "htm.h"
+#include "em_core.h"
+#include "native_gecko.h"
 
 #define ADC_VALUE_TEXT 							"Single PA0:\n %5luV\n"
-#define TEST_VALUE_TEXT							"Testing: %d\n"
 
-float adc_value;
+int32_t adcMilliVolt;
+
+/* Ping-pong acquisition state */
+static LDMA_TransferCfg_t adcStreamXfer;
+static LDMA_Descriptor_t adcStreamDescr[2];
+static volatile uint32_t adcStreamReady;        /* Bit n set: half n waits for the application */
+static volatile uint32_t adcStreamOverruns;     /* Halves overwritten before being released */
+static uint32_t adcStreamFill;                  /* Half LDMA is currently writing */
+static uint32_t adcStreamNext;                  /* Next half handed to the application */
+static bool adcStreamRunning;
+
+/* Scan inputs in ADC_SCAN_CH_xxx bit order */
+static const struct
+{
+  ADC_ScanInputGroup_TypeDef group;
+  ADC_PosSel_TypeDef input;
+} adcScanInputs[ADC_SCAN_CHANNELS] =
+{
+  { adcScanInputGroup0, ADC_INPUT0 },   /* PA0 */
+  { adcScanInputGroup0, ADC_INPUT1 },   /* PA1 */
+  { adcScanInputGroup1, ADC_INPUT2 },   /* PD10 */
+  { adcScanInputGroup1, ADC_INPUT3 },   /* PD11 */
+};
+
+/* Multi-channel scan state */
+static adcRing_t adcScanRing[ADC_SCAN_CHANNELS];
+static uint8_t adcScanIdToChannel[32];          /* SCANDATAX input ID to channel index */
+static uint32_t adcScanMask;
+static uint32_t adcScanCount;                   /* Channels per scan sequence */
+
+/* RTCC CC1 trigger schedule and the delay of the conversion interrupt behind it */
+static tickSched_t adcTrigSched;
+static tickJitter_t adcTrigJitter;
+static uint32_t adcTrigPeriodMs = RTCC_WAKEUP_MS;
+static volatile uint32_t adcTrigPeriodNext;     /* Taken over by the next re-arm, 0 for none */
+
+/* Configure-once state and per-sample cycle instrumentation */
+static adcProfile_t adcProfile = adcProfileNone;
+static adcCycleStats_t adcCycleStats;
+static uint32_t adcTriggerCycles;
+
+/* Oversampling/decimation profiles for the PRS triggered acquisition. The
+ * ADC averages 2^hwLog2 conversions per trigger, the CIC then decimates by
+ * 2^swLog2. Conversions per trigger are limited so that a full four channel
+ * scan still fits into RTCC_WAKEUP_MS. */
+static const struct
+{
+  uint8_t hwLog2;               /* 0 for plain 12 bit conversions */
+  uint8_t swLog2;               /* 0 bypasses the CIC */
+  uint8_t cicOrder;
+} adcOvsProfiles[ADC_OVS_PROFILES] =
+{
+  { 0, 0, 0 },                  /* 12 bit, 100 Hz */
+  { 4, 0, 0 },                  /* 14 bit, 100 Hz */
+  { 6, 0, 0 },                  /* 15 bit, 100 Hz */
+  { 4, 2, 2 },                  /* 15 bit, 25 Hz */
+  { 6, 2, 1 }                   /* 16 bit, 25 Hz */
+};
+static uint32_t adcOvsIndex = ADC_OVS_DEFAULT;
+static adcCic_t adcCic[ADC_SCAN_CHANNELS];
+
+/* Window compare monitoring state */
+static adcExcursion_t adcWindowCapture;         /* Written by ADC0_IRQHandler while armed */
+static volatile bool adcWindowPending;          /* Capture waits for the application */
+static uint32_t adcWindowCount;                 /* Excursions since adcWindowStart() */
+
+/* Calibration coefficients used by adcToMilliVolt() */
+static adcCal_t adcCal;
+
+static void adcCyclesAdd(adcCycles_t *stats, uint32_t cycles);
+static void adcCyclesReset(adcCycles_t *stats);
+
 /**************************************************************************//**
  * @brief Setup RTCC as PRS source to trigger ADC
  *****************************************************************************/
@@ -64,6 +137,258 @@ void adcSetup(void)
   ADC0->CMPTHR = _ADC_CMPTHR_RESETVALUE;
   ADC0->CMPTHR = (ADC_CMP_GT_VALUE << _ADC_CMPTHR_ADGT_SHIFT) +
                  (ADC_CMP_LT_VALUE << _ADC_CMPTHR_ADLT_SHIFT);
+
+  /* Enable the DWT cycle counter used for per-sample instrumentation */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  adcResetCycleStats();
+
+  /* Ideal coefficients until adcCalibrate() or adcSetCalibration() */
+  adcConvDefault(&adcCal);
+}
+
+/**************************************************************************//**
+ * @brief Configure ADC0 for one of the acquisition profiles.
+ *
+ * Does nothing if the profile is already active, so the sampling path can
+ * call it unconditionally and only pays for ADC_Init()/ADC_InitSingle()
+ * when the profile actually changes.
+ * @param[in] profile
+ *   Acquisition profile to activate.
+ *****************************************************************************/
+void adcConfigure(adcProfile_t profile)
+{
+  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
+  ADC_InitSingle_TypeDef singleInit = ADC_INITSINGLE_DEFAULT;
+  ADC_InitScan_TypeDef scanInit = ADC_INITSCAN_DEFAULT;
+  uint32_t start, ch;
+
+  if (profile == adcProfile)
+  {
+    return;
+  }
+  start = DWT->CYCCNT;
+
+  /* Single-ended conversion of PA0 against VDD for all single profiles */
+  singleInit.reference = adcRefVDD;
+  singleInit.posSel = ADC_INPUT0;
+  singleInit.negSel = adcNegSelVSS;
+
+  switch (profile)
+  {
+    case adcProfileStream:
+    case adcProfileScan:
+      /* Use AUXHFRCO on demand so that conversions continue while the stack is in EM2 */
+      CMU_AUXHFRCOFreqSet(ADC_ASYNC_CLOCK);
+      init.em2ClockConfig = adcEm2ClockOnDemand;
+      init.timebase = ADC_TimebaseCalc(CMU_AUXHFRCOBandGet());
+      init.prescale = ADC_PrescaleCalc(ADC_CLOCK, CMU_AUXHFRCOBandGet());
+
+      /* Started by PRS, LDMA may wake from EM2 */
+      singleInit.prsSel = ADC_PRS_CH_SELECT;
+      singleInit.prsEnable = true;
+      singleInit.singleDmaEm2Wu = true;
+      scanInit.prsSel = ADC_PRS_CH_SELECT;
+      scanInit.prsEnable = true;
+      scanInit.scanDmaEm2Wu = true;
+
+      /* Hardware part of the selected decimation profile */
+      if (adcOvsProfiles[adcOvsIndex].hwLog2)
+      {
+        init.ovsRateSel = (ADC_OvsRateSel_TypeDef)(adcOvsProfiles[adcOvsIndex].hwLog2 - 1);
+        singleInit.resolution = adcResOVS;
+        scanInit.resolution = adcResOVS;
+      }
+      break;
+
+    case adcProfileWindow:
+      /* Same EM2 clocking, but no LDMA: the CPU only wakes on a compare match */
+      CMU_AUXHFRCOFreqSet(ADC_ASYNC_CLOCK);
+      init.em2ClockConfig = adcEm2ClockOnDemand;
+      init.timebase = ADC_TimebaseCalc(CMU_AUXHFRCOBandGet());
+      init.prescale = ADC_PrescaleCalc(ADC_CLOCK, CMU_AUXHFRCOBandGet());
+
+      /* Keep the newest samples in the FIFO as context for the excursion */
+      singleInit.prsSel = ADC_PRS_CH_SELECT;
+      singleInit.prsEnable = true;
+      singleInit.fifoOverwrite = true;
+      break;
+
+    case adcProfileSingleOvs:
+      /* Set and enable oversampling rate */
+      init.ovsRateSel = adcOvsRateSel256;
+      singleInit.resolution = adcResOVS;
+      /* Fall through */
+
+    case adcProfileSingle:
+    default:
+      init.timebase = ADC_TimebaseCalc(0);
+      init.prescale = ADC_PrescaleCalc(ADC_CLOCK, 0);
+      break;
+  }
+
+  ADC_Init(ADC0, &init);
+
+  if (profile == adcProfileScan)
+  {
+    /* Add the selected inputs and remember which scan ID belongs to which channel */
+    ADC_ScanInputClear(&scanInit);
+    for (ch = 0; ch < sizeof(adcScanIdToChannel); ch++)
+    {
+      adcScanIdToChannel[ch] = ADC_SCAN_CHANNELS;
+    }
+    for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++)
+    {
+      if (adcScanMask & (1 << ch))
+      {
+        adcScanIdToChannel[ADC_ScanSingleEndedInputAdd(&scanInit, adcScanInputs[ch].group,
+                                                       adcScanInputs[ch].input)] = ch;
+      }
+    }
+    scanInit.reference = adcRefVDD;
+    ADC_InitScan(ADC0, &scanInit);
+
+    /* One full scan sequence per LDMA request */
+    ADC0->SCANCTRLX = (ADC0->SCANCTRLX & ~_ADC_SCANCTRLX_DVL_MASK)
+                      | ((adcScanCount - 1) << _ADC_SCANCTRLX_DVL_SHIFT);
+    ADC0->SCANFIFOCLEAR = ADC_SCANFIFOCLEAR_SCANFIFOCLEAR;
+  }
+  else
+  {
+    ADC_InitSingle(ADC0, &singleInit);
+    ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+
+    if (profile == adcProfileWindow)
+    {
+      /* Low accuracy bias is enough with the VDD reference */
+      ADC0->BIASPROG = ADC_BIASPROG_GPBIASACC;
+      ADC0->SINGLECTRL |= ADC_SINGLECTRL_CMPEN;
+      ADC0->SINGLECTRLX = (ADC0->SINGLECTRLX & ~_ADC_SINGLECTRLX_DVL_MASK)
+                          | ((ADC_WINDOW_CONTEXT - 1) << _ADC_SINGLECTRLX_DVL_SHIFT);
+    }
+  }
+
+  adcProfile = profile;
+  adcCyclesAdd(&adcCycleStats.configure, DWT->CYCCNT - start);
+}
+
+/**************************************************************************//**
+ * @brief Start one software-triggered single conversion.
+ *****************************************************************************/
+void adcTrigger(void)
+{
+  adcTriggerCycles = DWT->CYCCNT;
+  ADC_Start(ADC0, adcStartSingle);
+}
+
+/**************************************************************************//**
+ * @brief Collect the conversion started by adcTrigger().
+ * @return
+ *   Raw conversion result (12 bit, or 16 bit with adcProfileSingleOvs).
+ *****************************************************************************/
+uint32_t adcRead(void)
+{
+  uint32_t sample;
+
+  /* Only the conversion time itself is spent here */
+  while (ADC0->SINGLEFIFOCOUNT == 0)
+    ;
+  sample = ADC_DataSingleGet(ADC0);
+
+  adcCycleUpdate(DWT->CYCCNT - adcTriggerCycles);
+  return sample;
+}
+
+/**************************************************************************//**
+ * @brief Accumulate the cycles spent on one operation.
+ *****************************************************************************/
+static void adcCyclesAdd(adcCycles_t *stats, uint32_t cycles)
+{
+  stats->last = cycles;
+  if (cycles < stats->min)
+  {
+    stats->min = cycles;
+  }
+  if (cycles > stats->max)
+  {
+    stats->max = cycles;
+  }
+  stats->total += cycles;
+  stats->count++;
+}
+
+/**************************************************************************//**
+ * @brief Clear the cycles of one operation.
+ *****************************************************************************/
+static void adcCyclesReset(adcCycles_t *stats)
+{
+  stats->count = 0;
+  stats->total = 0;
+  stats->last = 0;
+  stats->min = UINT32_MAX;
+  stats->max = 0;
+}
+
+/**************************************************************************//**
+ * @brief Accumulate the cycles spent on one sample.
+ *****************************************************************************/
+void adcCycleUpdate(uint32_t cycles)
+{
+  adcCyclesAdd(&adcCycleStats.sample, cycles);
+}
+
+/**************************************************************************//**
+ * @brief Read back the cycle counters of the samples and the profile changes.
+ *****************************************************************************/
+void adcGetCycleStats(adcCycleStats_t *stats)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  *stats = adcCycleStats;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Clear the cycle counters of the samples and the profile changes.
+ *****************************************************************************/
+void adcResetCycleStats(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  adcCyclesReset(&adcCycleStats.sample);
+  adcCyclesReset(&adcCycleStats.configure);
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Read back the delay from RTCC compare to the conversion interrupt.
+ *
+ * The conversion itself starts on the PRS edge, so this shows what the
+ * sample instants no longer depend on: conversion time plus interrupt
+ * latency.
+ *****************************************************************************/
+void adcGetTriggerJitter(tickJitter_t *jitter)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  *jitter = adcTrigJitter;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * @brief Clear the trigger delay statistics.
+ *****************************************************************************/
+void adcResetTriggerJitter(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  tickJitterReset(&adcTrigJitter);
+  CORE_EXIT_ATOMIC();
 }
 
 /***************************************************************************//**
@@ -78,101 +403,652 @@ void ldmaSetup(void)
 }
 
 /**************************************************************************//**
- * @brief ADC single and scan conversion example (Single-ended mode)
- * @param[in] ovs
- *   False for 12 bit ADC, True for 16 bit oversampling ADC.
+ * @brief Start PRS triggering from RTCC CC1 and LDMA into adcBuffer.
+ *
+ * adcBuffer is used as two linked halves of halfCount words. Each half
+ * raises the LDMA channel done interrupt when it is full.
+ * @param[in] signal
+ *   ADC0 single or scan LDMA request.
+ * @param[in] src
+ *   ADC0 data register read by LDMA.
+ * @param[in] halfCount
+ *   Words per half, a multiple of blockSize.
+ * @param[in] blockSize
+ *   Words moved per LDMA request (the ADC data valid level).
  *****************************************************************************/
-void adcSingleScan(bool ovs)
+static void adcAcqStart(LDMA_PeripheralSignal_t signal, volatile uint32_t *src,
+                        uint32_t halfCount, uint32_t blockSize)
 {
-/* Disable key interrupt during run */
-NVIC_DisableIRQ(GPIO_EVEN_IRQn);
-NVIC_DisableIRQ(GPIO_ODD_IRQn);
+  /* Route RTCC CC1 compare match to the ADC PRS channel */
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(RTCC_PRS_CHANNEL, PRS_CH_CTRL_SOURCESEL_RTCC,
+                           PRS_CH_CTRL_SIGSEL_RTCCCCV1);
 
+  /* Two descriptors linked to each other, each one raising the channel done flag */
+  adcStreamXfer = (LDMA_TransferCfg_t)LDMA_TRANSFER_CFG_PERIPHERAL(signal);
+  adcStreamDescr[0] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, &adcBuffer[0],
+                                                                          halfCount, 1);
+  adcStreamDescr[1] = (LDMA_Descriptor_t)LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, &adcBuffer[halfCount],
+                                                                          halfCount, -1);
+  adcStreamDescr[0].xfer.size = ldmaCtrlSizeWord;
+  adcStreamDescr[0].xfer.blockSize = blockSize - 1;
+  adcStreamDescr[0].xfer.ignoreSrec = true;
+  adcStreamDescr[1].xfer.size = ldmaCtrlSizeWord;
+  adcStreamDescr[1].xfer.blockSize = blockSize - 1;
+  adcStreamDescr[1].xfer.ignoreSrec = true;
 
-  //uint32_t id;
-  uint32_t sample, adcMax;
-  //uint32_t test;
+  adcStreamReady = 0;
+  adcStreamOverruns = 0;
+  adcStreamFill = 0;
+  adcStreamNext = 0;
 
-  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
-  ADC_InitSingle_TypeDef singleInit = ADC_INITSINGLE_DEFAULT;
-  ADC_InitScan_TypeDef scanInit = ADC_INITSCAN_DEFAULT;
+  /* Start LDMA before the first trigger */
+  CMU_ClockEnable(cmuClock_LDMA, true);
+  LDMA_StartTransfer(ADC_DMA_CHANNEL, &adcStreamXfer, &adcStreamDescr[0]);
+  LDMA_IntEnable(ADC_DMA_CH_MASK);
+
+  /* The conversion interrupt only re-arms the RTCC compare */
+  ADC_IntClear(ADC0, ADC_IF_SINGLE | ADC_IF_SCAN);
+  ADC_IntEnable(ADC0, (adcProfile == adcProfileScan) ? ADC_IEN_SCAN : ADC_IEN_SINGLE);
+  NVIC_ClearPendingIRQ(ADC0_IRQn);
+  NVIC_EnableIRQ(ADC0_IRQn);
+
+  /* The stack owns the RTCC counter, so CC1 is advanced instead of wrapping. 10 ms are 327.68
+   * ticks, the schedule alternates 327 and 328 so the rate is exact. */
+  tickSchedInit(&adcTrigSched, adcTrigPeriodMs);
+  adcTrigPeriodNext = 0;
+  tickJitterReset(&adcTrigJitter);
+  RTCC_ChannelCCVSet(RTCC_CC_CHANNEL, RTCC_CounterGet() + tickSchedNext(&adcTrigSched));
+
+  adcStreamRunning = true;
+}
+
+/**************************************************************************//**
+ * @brief Stop PRS triggered acquisition and release LDMA and PRS.
+ *****************************************************************************/
+static void adcAcqStop(void)
+{
+  NVIC_DisableIRQ(ADC0_IRQn);
+  ADC_IntDisable(ADC0, ADC_IEN_SINGLE | ADC_IEN_SCAN);
+  ADC0->SINGLECTRL &= ~ADC_SINGLECTRL_PRSEN;
+  ADC0->SCANCTRL &= ~ADC_SCANCTRL_PRSEN;
+  adcProfile = adcProfileNone;
+
+  LDMA_StopTransfer(ADC_DMA_CHANNEL);
+  LDMA_IntDisable(ADC_DMA_CH_MASK);
+  LDMA_IntClear(ADC_DMA_CH_MASK);
+  CMU_ClockEnable(cmuClock_LDMA, false);
+  CMU_ClockEnable(cmuClock_PRS, false);
+
+  adcStreamReady = 0;
+  adcStreamRunning = false;
+}
 
-  adcMax = ADC_12BIT_MAX;
-  if (ovs)
+/**************************************************************************//**
+ * @brief Start continuous single-ended acquisition on PA0.
+ *
+ * The RTCC CC1 compare output is routed over PRS to trigger one conversion
+ * every trigger period, see adcSetTriggerPeriod(). LDMA moves each result
+ * into adcBuffer, which is used as two linked halves of ADC_BUFFER_HALF
+ * samples. The application is only signalled (APP_SIGNAL_ADC_HALF) when a
+ * half is complete.
+ *****************************************************************************/
+void adcStreamStart(void)
+{
+  if (adcStreamRunning)
   {
-    adcMax = ADC_16BIT_MAX;
+    if (adcProfile == adcProfileStream)
+    {
+      return;
+    }
+    adcAcqStop();
   }
+  adcWindowStop();
+  adcCicInit(&adcCic[0], adcOvsProfiles[adcOvsIndex].cicOrder,
+             adcOvsProfiles[adcOvsIndex].swLog2);
 
+  adcConfigure(adcProfileStream);
+  adcAcqStart(ldmaPeripheralSignal_ADC0_SINGLE, &(ADC0->SINGLEDATA), ADC_BUFFER_HALF, 1);
+}
 
-  /* Init common issues for both single conversion and scan mode */
-  init.timebase = ADC_TimebaseCalc(0);
-  init.prescale = ADC_PrescaleCalc(ADC_CLOCK, 0);
-  if (ovs)
+/**************************************************************************//**
+ * @brief Stop continuous acquisition (single or scan).
+ *****************************************************************************/
+void adcStreamStop(void)
+{
+  if (!adcStreamRunning)
   {
-    /* Set oversampling rate */
-    init.ovsRateSel = adcOvsRateSel256;
+    return;
   }
-  ADC_Init(ADC0, &init);
 
-  /* Initialize for single conversion */
-  singleInit.reference = adcRefVDD;
-  singleInit.posSel = ADC_INPUT0;
-  singleInit.negSel = adcNegSelVSS;
-  if (ovs)
+  adcAcqStop();
+}
+
+/**************************************************************************//**
+ * @brief Get the oldest complete half of adcBuffer.
+ * @return
+ *   Pointer to ADC_BUFFER_HALF samples, or NULL if no half is ready. The
+ *   block stays owned by the application until adcStreamReleaseBlock().
+ *****************************************************************************/
+const uint32_t *adcStreamGetBlock(void)
+{
+  if ((adcStreamReady & (1 << adcStreamNext)) == 0)
   {
-    /* Enable oversampling rate */
-    singleInit.resolution = adcResOVS;
+    return NULL;
   }
-  ADC_InitSingle(ADC0, &singleInit);
-#ifdef TEST
-  /* Setup scan channels, define DEBUG_EFM in debug build to identify invalid channel range */
-  ADC_ScanSingleEndedInputAdd(&scanInit, adcScanInputGroup0, ADC_INPUT0);
-  ADC_ScanSingleEndedInputAdd(&scanInit, adcScanInputGroup0, ADC_INPUT1);
-  ADC_ScanSingleEndedInputAdd(&scanInit, adcScanInputGroup1, ADC_INPUT2);
-  ADC_ScanSingleEndedInputAdd(&scanInit, adcScanInputGroup1, ADC_INPUT3);
+  return &adcBuffer[adcStreamNext * ADC_BUFFER_HALF];
+}
+
+/**************************************************************************//**
+ * @brief Hand the block returned by adcStreamGetBlock() back to LDMA.
+ *****************************************************************************/
+void adcStreamReleaseBlock(void)
+{
+  CORE_DECLARE_IRQ_STATE;
 
-  /* Initialize for scan conversion */
-  scanInit.reference = adcRefVDD;
-  if (ovs)
+  CORE_ENTER_ATOMIC();
+  adcStreamReady &= ~(1 << adcStreamNext);
+  CORE_EXIT_ATOMIC();
+  adcStreamNext ^= 1;
+}
+
+/**************************************************************************//**
+ * @brief Number of halves that were refilled before the application
+ *   released them since adcStreamStart().
+ *****************************************************************************/
+uint32_t adcStreamGetOverruns(void)
+{
+  return adcStreamOverruns;
+}
+
+/**************************************************************************//**
+ * @brief Start continuous multi-channel scan acquisition.
+ *
+ * Every trigger period one PRS trigger converts all selected inputs in a
+ * single scan sequence. LDMA moves a full sequence per request into
+ * adcBuffer, and the LDMA interrupt sorts the results into one ring buffer
+ * per channel before signalling APP_SIGNAL_ADC_SCAN.
+ * @param[in] channelMask
+ *   ADC_SCAN_CH_xxx bits of the inputs to convert.
+ *****************************************************************************/
+void adcScanStart(uint32_t channelMask)
+{
+  uint32_t ch;
+
+  channelMask &= ADC_SCAN_CH_ALL;
+  if (channelMask == 0)
   {
-    /* Enable oversampling rate */
-    scanInit.resolution = adcResOVS;
+    return;
   }
-  ADC_InitScan(ADC0, &scanInit);
-#endif
+  if (adcStreamRunning)
+  {
+    adcAcqStop();
+  }
+  adcWindowStop();
 
-  /* Set scan data valid level to trigger */
-  ADC0->SCANCTRLX |= (ADC_SCAN_DVL - 1) << _ADC_SCANCTRLX_DVL_SHIFT;
+  adcScanMask = channelMask;
+  adcScanCount = 0;
+  for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++)
+  {
+    if (channelMask & (1 << ch))
+    {
+      adcScanCount++;
+    }
+    adcScanRing[ch].head = 0;
+    adcScanRing[ch].tail = 0;
+    adcScanRing[ch].drops = 0;
+    adcCicInit(&adcCic[ch], adcOvsProfiles[adcOvsIndex].cicOrder,
+               adcOvsProfiles[adcOvsIndex].swLog2);
+  }
 
-  /* Start ADC single conversion */
-  ADC_Start(ADC0, adcStartSingle);
-  while ((ADC0->IF & ADC_IF_SINGLE) == 0)
-    ;
+  adcConfigure(adcProfileScan);
+  adcAcqStart(ldmaPeripheralSignal_ADC0_SCAN, &(ADC0->SCANDATAX),
+              adcScanCount * ADC_SCAN_SEQ_PER_HALF, adcScanCount);
+}
 
-  /* Get ADC single result */
-  sample = ADC_DataSingleGet(ADC0);
-  adc_value = ((float)sample * ADC_SE_VFS)/adcMax;
-  getADCValue(sample);
-  //printf("Single PA0: %1.4fV\n",((float)sample * ADC_SE_VFS)/adcMax);
+/**************************************************************************//**
+ * @brief Channel mask of the running scan, 0 if no scan is running.
+ *****************************************************************************/
+uint32_t adcScanGetMask(void)
+{
+  return (adcProfile == adcProfileScan) ? adcScanMask : 0;
+}
 
-#ifdef TEST
-  /* Start ADC scan conversion */
-  ADC_Start(ADC0, adcStartScan);
-  while ((ADC0->IF & ADC_IF_SCAN) == 0)
-    ;
+/**************************************************************************//**
+ * @brief Pop the oldest sample of one scan channel.
+ * @param[in] channel
+ *   Scan channel index (0 = PA0, 1 = PA1, 2 = PD10, 3 = PD11).
+ * @param[out] sample
+ *   Raw conversion result.
+ * @return
+ *   False if the channel ring buffer is empty.
+ *****************************************************************************/
+bool adcScanRead(uint32_t channel, uint16_t *sample)
+{
+  adcRing_t *ring = &adcScanRing[channel];
+  uint32_t tail = ring->tail;
+
+  if (tail == ring->head)
+  {
+    return false;
+  }
+  *sample = ring->data[tail & (ADC_SCAN_RING_SIZE - 1)];
+  /* Only the application writes tail, the LDMA interrupt only writes head */
+  ring->tail = tail + 1;
+  return true;
+}
 
+/**************************************************************************//**
+ * @brief Samples dropped because a channel ring buffer was full.
+ *****************************************************************************/
+uint32_t adcScanGetDrops(uint32_t channel)
+{
+  return adcScanRing[channel].drops;
+}
 
-  /* Get ADC scan results */
-  sample = ADC_DataIdScanGet(ADC0, &id);
-  printf("Scan PA%lu: %1.4fV\n", id, ((float)(sample) * ADC_SE_VFS)/adcMax);
-  sample = ADC_DataIdScanGet(ADC0, &id);
-  printf("Scan PA%lu: %1.4fV\n", id, ((float)(sample) * ADC_SE_VFS)/adcMax);
-  sample = ADC_DataIdScanGet(ADC0, &id);
-  printf("Scan PD%lu: %1.4fV\n", id, ((float)(sample) * ADC_SE_VFS)/adcMax);
-  sample = ADC_DataIdScanGet(ADC0, &id);
-  printf("Scan PD%lu: %1.4fV\n", id, ((float)(sample) * ADC_SE_VFS)/adcMax);
-#endif
+/**************************************************************************//**
+ * @brief Select the oversampling/decimation profile.
+ *
+ * A running stream or scan is restarted so the new hardware ratio takes
+ * effect immediately.
+ * @param[in] index
+ *   Profile, 0 to ADC_OVS_PROFILES - 1.
+ * @return
+ *   False if the profile does not exist or its conversions do not fit into
+ *   the trigger period.
+ *****************************************************************************/
+bool adcOvsSelect(uint32_t index)
+{
+  adcProfile_t running;
+
+  if ((index >= ADC_OVS_PROFILES) || (adcTrigPeriodMs < adcTrigPeriodMin(index)))
+  {
+    return false;
+  }
+  if (index == adcOvsIndex)
+  {
+    return true;
+  }
+  adcOvsIndex = index;
+
+  running = adcStreamRunning ? adcProfile : adcProfileNone;
+  if (running != adcProfileNone)
+  {
+    adcAcqStop();
+  }
+  if (running == adcProfileStream)
+  {
+    adcStreamStart();
+  }
+  else if (running == adcProfileScan)
+  {
+    adcScanStart(adcScanMask);
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Get the selected oversampling/decimation profile.
+ *****************************************************************************/
+uint32_t adcOvsGetSelected(void)
+{
+  return adcOvsIndex;
+}
+
+/**************************************************************************//**
+ * @brief Describe an oversampling/decimation profile.
+ *
+ * Each doubling of the averaged conversions adds half a bit for white noise,
+ * capped at the 16 bit result width.
+ * @param[in] index
+ *   Profile, 0 to ADC_OVS_PROFILES - 1.
+ * @return
+ *   False if the profile does not exist.
+ *****************************************************************************/
+bool adcOvsGetInfo(uint32_t index, adcOvsInfo_t *info)
+{
+  uint32_t log2Total;
+
+  if (index >= ADC_OVS_PROFILES)
+  {
+    return false;
+  }
+
+  log2Total = adcOvsProfiles[index].hwLog2 + adcOvsProfiles[index].swLog2;
+  info->resolution = (uint16_t)(120 + (log2Total * 5));
+  if (info->resolution > 160)
+  {
+    info->resolution = 160;
+  }
+  info->hwRatio = 1UL << adcOvsProfiles[index].hwLog2;
+  info->swRatio = 1UL << adcOvsProfiles[index].swLog2;
+  info->rate = (1000000UL / adcTrigPeriodMs) >> adcOvsProfiles[index].swLog2;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Shortest trigger period of an oversampling/decimation profile.
+ *
+ * 64 averaged conversions of all four scan inputs fit into RTCC_WAKEUP_MS,
+ * fewer conversions allow proportionally shorter periods.
+ * @param[in] index
+ *   Profile, 0 to ADC_OVS_PROFILES - 1.
+ * @return
+ *   Period in ms.
+ *****************************************************************************/
+uint32_t adcTrigPeriodMin(uint32_t index)
+{
+  uint32_t ms;
+
+  if (index >= ADC_OVS_PROFILES)
+  {
+    return ADC_TRIG_PERIOD_MAX_MS;
+  }
+  ms = ((RTCC_WAKEUP_MS << adcOvsProfiles[index].hwLog2) + 63) / 64;
+  return (ms > 0) ? ms : 1;
+}
+
+/**************************************************************************//**
+ * @brief Change the time between PRS triggers.
+ *
+ * A running stream or scan is not restarted: the trigger already scheduled
+ * converts as planned and the next one follows at the new period, so the
+ * LDMA blocks continue without a lost or repeated sample.
+ * @param[in] ms
+ *   Period, adcTrigPeriodMin() of the selected profile to
+ *   ADC_TRIG_PERIOD_MAX_MS.
+ * @return
+ *   False if the period is out of range.
+ *****************************************************************************/
+bool adcSetTriggerPeriod(uint32_t ms)
+{
+  if ((ms < adcTrigPeriodMin(adcOvsIndex)) || (ms > ADC_TRIG_PERIOD_MAX_MS))
+  {
+    return false;
+  }
+  adcTrigPeriodMs = ms;
+  if (adcStreamRunning)
+  {
+    adcTrigPeriodNext = ms;
+  }
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Get the time between PRS triggers in ms.
+ *****************************************************************************/
+uint32_t adcGetTriggerPeriod(void)
+{
+  return adcTrigPeriodMs;
+}
+
+/**************************************************************************//**
+ * @brief Run one acquired sample through the software decimator.
+ * @param[in] channel
+ *   Channel index, 0 for the single conversion stream.
+ * @param[in] sample
+ *   Raw sample from adcStreamGetBlock() or adcScanRead().
+ * @param[out] out
+ *   Decimated sample, always scaled to 16 bit.
+ * @return
+ *   True when out holds a new output sample.
+ *****************************************************************************/
+bool adcDecimate(uint32_t channel, uint32_t sample, uint16_t *out)
+{
+  uint32_t result;
+
+  if (channel >= ADC_SCAN_CHANNELS)
+  {
+    return false;
+  }
+
+  /* Plain conversions are 12 bit, oversampled ones 16 bit */
+  if (adcOvsProfiles[adcOvsIndex].hwLog2 == 0)
+  {
+    sample <<= 4;
+  }
+  if (!adcCicPush(&adcCic[channel], sample & 0xFFFF, &result))
+  {
+    return false;
+  }
+  *out = (uint16_t)result;
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Sort one completed half of scan results into the channel rings.
+ *****************************************************************************/
+static void adcScanDemux(const uint32_t *data, uint32_t count)
+{
+  uint32_t i, id, ch, head;
+  adcRing_t *ring;
+
+  for (i = 0; i < count; i++)
+  {
+    id = (data[i] & _ADC_SCANDATAX_SCANINPUTID_MASK) >> _ADC_SCANDATAX_SCANINPUTID_SHIFT;
+    ch = adcScanIdToChannel[id];
+    if (ch >= ADC_SCAN_CHANNELS)
+    {
+      continue;
+    }
+    ring = &adcScanRing[ch];
+    head = ring->head;
+    if ((head - ring->tail) >= ADC_SCAN_RING_SIZE)
+    {
+      /* Never move tail from here, drop the new sample instead */
+      ring->drops++;
+      continue;
+    }
+    ring->data[head & (ADC_SCAN_RING_SIZE - 1)] = (uint16_t)(data[i] & _ADC_SCANDATAX_DATA_MASK);
+    ring->head = head + 1;
+  }
+}
+
+/**************************************************************************//**
+ * @brief LDMA interrupt handler, called when a ping-pong half is full.
+ *****************************************************************************/
+void LDMA_IRQHandler(void)
+{
+  uint32_t pending, half;
+
+  pending = LDMA_IntGet();
+  LDMA_IntClear(pending);
+
+  if (pending & ADC_DMA_CH_MASK)
+  {
+    if (adcProfile == adcProfileScan)
+    {
+      /* LDMA is already filling the other half */
+      half = adcScanCount * ADC_SCAN_SEQ_PER_HALF;
+      adcScanDemux(&adcBuffer[adcStreamFill * half], half);
+      adcStreamFill ^= 1;
+      gecko_external_signal(APP_SIGNAL_ADC_SCAN);
+      return;
+    }
+
+    if (adcStreamReady & (1 << adcStreamFill))
+    {
+      adcStreamOverruns++;
+    }
+    adcStreamReady |= 1 << adcStreamFill;
+    adcStreamFill ^= 1;
+    gecko_external_signal(APP_SIGNAL_ADC_HALF);
+  }
+}
+
+/**************************************************************************//**
+ * @brief ADC interrupt handler.
+ *
+ * Schedules the next PRS trigger relative to the previous compare value, so
+ * the sample period does not depend on interrupt latency. Triggers that are
+ * already over after a long stall are skipped and counted in the jitter
+ * statistics.
+ *****************************************************************************/
+void ADC0_IRQHandler(void)
+{
+  uint32_t start = DWT->CYCCNT;
+  uint32_t compare;
+  uint32_t now;
+
+  /* Read and clear interrupt flags (MSC_CTRL_IFCREADCLEAR is set in main) */
+  adcIntFlag = ADC0->IFC;
+
+  if ((adcIntFlag & ADC_IF_SINGLECMP) && (adcProfile == adcProfileWindow))
+  {
+    /* Capture the FIFO and disarm until the application has taken it */
+    adcWindowCapture.timestamp = RTCC_CounterGet();
+    adcWindowCapture.count = 0;
+    while (ADC0->SINGLEFIFOCOUNT && (adcWindowCapture.count < ADC_WINDOW_CONTEXT))
+    {
+      adcWindowCapture.data[adcWindowCapture.count++] = ADC_DataSingleGet(ADC0);
+    }
+    ADC_IntDisable(ADC0, ADC_IEN_SINGLECMP);
+    adcWindowPending = true;
+    adcWindowCount++;
+    gecko_external_signal(APP_SIGNAL_ADC_WINDOW);
+    return;
+  }
+
+  if (adcIntFlag & (ADC_IF_SINGLE | ADC_IF_SCAN))
+  {
+    compare = RTCC_ChannelCCVGet(RTCC_CC_CHANNEL);
+    now = RTCC_CounterGet();
+    tickJitterUpdate(&adcTrigJitter, (int32_t)(now - compare));
+    if (adcTrigPeriodNext != 0)
+    {
+      /* New period from the trigger that just converted on, none is lost or repeated */
+      tickSchedInit(&adcTrigSched, adcTrigPeriodNext);
+      adcTrigPeriodNext = 0;
+    }
+    /* A compare value already passed would only match after the 36 hour wrap */
+    RTCC_ChannelCCVSet(RTCC_CC_CHANNEL,
+                       tickSchedAfter(&adcTrigSched, &adcTrigJitter, compare, now));
+    adcCycleUpdate(DWT->CYCCNT - start);
+  }
+}
+
+/**************************************************************************//**
+ * @brief Average ADC_CAL_SAMPLES oversampled conversions of one input.
+ * @param[in] input
+ *   Positive input, converted single-ended against VSS.
+ * @return
+ *   Average 16 bit code.
+ *****************************************************************************/
+static uint32_t adcCalMeasure(ADC_PosSel_TypeDef input)
+{
+  uint32_t i, sum;
+
+  adcConfigure(adcProfileSingleOvs);
+  ADC0->SINGLECTRL = (ADC0->SINGLECTRL & ~_ADC_SINGLECTRL_POSSEL_MASK)
+                     | ((uint32_t)input << _ADC_SINGLECTRL_POSSEL_SHIFT);
+
+  sum = 0;
+  for (i = 0; i < ADC_CAL_SAMPLES; i++)
+  {
+    adcTrigger();
+    sum += adcRead();
+  }
+
+  /* Back to the input adcConfigure() expects */
+  ADC0->SINGLECTRL = (ADC0->SINGLECTRL & ~_ADC_SINGLECTRL_POSSEL_MASK)
+                     | ((uint32_t)ADC_INPUT0 << _ADC_SINGLECTRL_POSSEL_SHIFT);
+  return (sum + (ADC_CAL_SAMPLES / 2)) / ADC_CAL_SAMPLES;
+}
+
+/**************************************************************************//**
+ * @brief Two point offset and gain calibration.
+ *
+ * Measures the internal VSS input for the offset and AVDD, which reaches the
+ * ADC attenuated by ADC_CAL_GAIN_ATT, for the gain, so no external wiring is
+ * involved. The coefficients are only replaced if they are within the
+ * tolerances of the ADC; the caller is responsible for storing them.
+ * @return
+ *   True if new coefficients were taken.
+ *****************************************************************************/
+bool adcCalibrate(void)
+{
+  adcCal_t cal;
+  uint32_t zero, ref;
+
+  /* The acquisition profiles own ADC0 while running */
+  if (adcStreamRunning || (adcProfile == adcProfileWindow))
+  {
+    return false;
+  }
+
+  zero = adcCalMeasure(ADC_CAL_ZERO_INPUT);
+  ref = adcCalMeasure(ADC_CAL_GAIN_INPUT);
+  if (adcConvCalibrate(&cal, zero, ref, ADC_CAL_GAIN_MV) != 0)
+  {
+    return false;
+  }
+  return adcSetCalibration(&cal);
+}
+
+/**************************************************************************//**
+ * @brief Get the calibration coefficients in use.
+ *****************************************************************************/
+void adcGetCalibration(adcCal_t *cal)
+{
+  *cal = adcCal;
+}
+
+/**************************************************************************//**
+ * @brief Replace the calibration coefficients, e.g. with stored ones.
+ * @return
+ *   False if the coefficients are implausible, the current ones are kept.
+ *****************************************************************************/
+bool adcSetCalibration(const adcCal_t *cal)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (adcConvCheck(cal, ADC_CAL_MAX_OFFSET, ADC_CAL_MAX_GAIN_ERR) != 0)
+  {
+    return false;
+  }
+  CORE_ENTER_ATOMIC();
+  adcCal = *cal;
+  CORE_EXIT_ATOMIC();
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Convert a raw sample to calibrated millivolts.
+ * @param[in] bits
+ *   Resolution of the sample, 12 or 16.
+ *****************************************************************************/
+int32_t adcToMilliVolt(uint32_t sample, uint32_t bits)
+{
+  return adcConvToMilliVolt(&adcCal, sample, bits);
+}
+
+/**************************************************************************//**
+ * @brief Convert calibrated millivolts to a raw code.
+ * @param[in] bits
+ *   Resolution of the code, 12 or 16.
+ *****************************************************************************/
+uint32_t adcFromMilliVolt(int32_t milliVolt, uint32_t bits)
+{
+  return adcConvFromMilliVolt(&adcCal, milliVolt, bits);
+}
+
+/**************************************************************************//**
+ * @brief ADC single conversion (Single-ended mode)
+ * @param[in] ovs
+ *   False for 12 bit ADC, True for 16 bit oversampling ADC.
+ *****************************************************************************/
+void adcSingleScan(bool ovs)
+{
+  uint32_t sample;
+
+  /* Only reconfigures ADC0 if the resolution changed since the last call */
+  adcConfigure(ovs ? adcProfileSingleOvs : adcProfileSingle);
 
+  /* Start ADC single conversion and get the result */
+  adcTrigger();
+  sample = adcRead();
+  adcMilliVolt = adcToMilliVolt(sample, ovs ? 16 : 12);
+  getADCValue(sample);
 
   //adcReset();
 }
@@ -191,6 +1067,7 @@ void adcReset(void)
 
   /* Rest ADC registers */
   ADC_Reset(ADC0);
+  adcProfile = adcProfileNone;
 
   /* Fill buffer and clear flag */
   for (i=0; i<ADC_BUFFER_SIZE; i++)
@@ -219,133 +1096,152 @@ void adcReset(void)
 #endif
 
 /**************************************************************************//**
- * @brief ADC single conversion interrupt example
- * @param[in] emode2
- *   False to run ADC in EM1, True to run ADC in EM2.
+ * @brief Check a compare window, low below high within 12 bit.
  *****************************************************************************/
-#ifdef SingleInt
-void adcSingleInt(bool emode2)
+static bool adcWindowValid(uint32_t low, uint32_t high)
 {
-  //uint32_t i;
-
-  ADC_Init_TypeDef init = ADC_INIT_DEFAULT;
-  ADC_InitSingle_TypeDef singleInit = ADC_INITSINGLE_DEFAULT;
-
-  /* Initialize for single conversion */
-  singleInit.prsSel = ADC_PRS_CH_SELECT;
-  singleInit.reference = adcRefVDD;
-  singleInit.posSel = ADC_INPUT0;
-  singleInit.negSel = adcNegSelVSS;
-  singleInit.prsEnable = true;
-  singleInit.fifoOverwrite = true;
-  ADC_InitSingle(ADC0, &singleInit);
-
-  /* Enable single window compare */
-  ADC0->SINGLECTRL |= ADC_SINGLECTRL_CMPEN;
-
-  /* Set single data valid level (DVL) to trigger */
-  ADC0->SINGLECTRLX |= (ADC_SINGLE_DVL - 1) << _ADC_SINGLECTRLX_DVL_SHIFT;
-
-  /* Enable ADC Interrupt when reaching DVL and window compare */
-  ADC_IntEnable(ADC0, ADC_IEN_SINGLE + ADC_IEN_SINGLECMP);
+  return (low < high) && (high < ADC_12BIT_MAX);
+}
 
-  if (emode2)
+/**************************************************************************//**
+ * @brief Set the compare window.
+ *
+ * ADGT above ADLT makes the window compare fire when a result is outside
+ * [low, high], so in-window samples never wake the CPU.
+ *****************************************************************************/
+static bool adcWindowThreshold(uint32_t low, uint32_t high)
+{
+  if (!adcWindowValid(low, high))
   {
-    /* Use LOWACC if not using bandgap reference to reduce current consumption */
-    ADC0->BIASPROG = ADC_BIASPROG_GPBIASACC;
+    return false;
+  }
+  ADC0->CMPTHR = (high << _ADC_CMPTHR_ADGT_SHIFT) + (low << _ADC_CMPTHR_ADLT_SHIFT);
+  return true;
+}
 
-    /* Switch the ADCCLKMODE to ASYNC at the end of initialization */
-    init.em2ClockConfig = adcEm2ClockOnDemand;
+/**************************************************************************//**
+ * @brief Start window compare monitoring of PA0.
+ *
+ * LETIMER0 underflows every RTCC_WAKEUP_MS and triggers one conversion over
+ * PRS, so sampling runs from the LFXO without any interrupt. The ADC runs on
+ * AUXHFRCO on demand in EM2 and only raises ADC_IF_SINGLECMP when a result
+ * leaves the window; the single FIFO then holds the samples leading up to
+ * the excursion and the application gets APP_SIGNAL_ADC_WINDOW.
+ * @param[in] low
+ *   Lower window limit, 12 bit code.
+ * @param[in] high
+ *   Upper window limit, 12 bit code.
+ * @return
+ *   False if the window is invalid, a running acquisition is then left as is.
+ *****************************************************************************/
+bool adcWindowStart(uint32_t low, uint32_t high)
+{
+  LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
 
-    /* Use AUXHFRCO frequency to setup ADC if run on EM2 */
-    CMU_AUXHFRCOFreqSet(ADC_ASYNC_CLOCK);
-    init.timebase = ADC_TimebaseCalc(CMU_AUXHFRCOBandGet());
-    init.prescale = ADC_PrescaleCalc(ADC_CLOCK, CMU_AUXHFRCOBandGet());
+  if (!adcWindowValid(low, high))
+  {
+    return false;
   }
-  else
+  if (adcStreamRunning)
   {
-    /* Use HFPERCLK frequency to setup ADC if run on EM1 */
-    init.timebase = ADC_TimebaseCalc(0);
-    init.prescale = ADC_PrescaleCalc(ADC_CLOCK, 0);
+    adcAcqStop();
   }
-  /* Init common issues for both single conversion and scan mode */
-  ADC_Init(ADC0, &init);
 
-#ifdef TEST
-  /* Clear the FIFOs and pending interrupt */
-  ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+  adcConfigure(adcProfileWindow);
+  adcWindowThreshold(low, high);
+  adcWindowPending = false;
+  adcWindowCount = 0;
+
+  ADC_IntClear(ADC0, _ADC_IF_MASK);
+  ADC_IntEnable(ADC0, ADC_IEN_SINGLECMP);
   NVIC_ClearPendingIRQ(ADC0_IRQn);
   NVIC_EnableIRQ(ADC0_IRQn);
-#endif
 
-  /* Start PRS from RTCC */
-  RTCC_Enable(true);
+  /* LETIMER0 pulse on underflow, routed to the ADC PRS channel */
+  CMU_ClockEnable(cmuClock_PRS, true);
+  PRS_SourceAsyncSignalSet(RTCC_PRS_CHANNEL, ADC_WINDOW_PRS_SOURCE, ADC_WINDOW_PRS_SIGNAL);
+  CMU_ClockEnable(cmuClock_LETIMER0, true);
+  letimerInit.enable = false;
+  letimerInit.comp0Top = true;
+  letimerInit.ufoa0 = letimerUFOAPulse;
+  LETIMER_Init(LETIMER0, &letimerInit);
+  LETIMER_CompareSet(LETIMER0, 0, RTCC_WAKEUP_COUNT);
+  LETIMER_RepeatSet(LETIMER0, 0, 1);
+  LETIMER_Enable(LETIMER0, true);
+  return true;
+}
 
-  while(1)
+/**************************************************************************//**
+ * @brief Move the compare window while monitoring.
+ * @return
+ *   False if the window is invalid or monitoring is not running.
+ *****************************************************************************/
+bool adcWindowSet(uint32_t low, uint32_t high)
+{
+  if (adcProfile != adcProfileWindow)
   {
-    if (emode2)
-    {
-      EMU_EnterEM2(false);
-    }
-    else
-    {
-      EMU_EnterEM1();
-    }
-    if (adcIntFlag & ADC_IF_SINGLECMP)
-    {
-      /* Exit if ADC outside the compare window */
-      break;
-    }
+    return false;
   }
+  return adcWindowThreshold(low, high);
+}
 
-  if (emode2)
+/**************************************************************************//**
+ * @brief Stop window compare monitoring.
+ *****************************************************************************/
+void adcWindowStop(void)
+{
+  if (adcProfile != adcProfileWindow)
   {
-	   int tester;
-	    tester = 1;
-	    char testing[32];
-	    snprintf(testing, sizeof(TEST_VALUE_TEXT),TEST_VALUE_TEXT, tester);
-	    appUiWriteString(testing);
-
-#ifdef TEST
-    /* Enable GPIO clock and power on LCD display */
-    CMU_ClockEnable(PAL_SPI_USART_CLOCK, true);
-    CMU_ClockEnable(cmuClock_GPIO, true);
-    displayDevice.pDisplayPowerOn(&displayDevice, true);
-    printf("\f");
-    printf("Example %d\n", menuLevel+1);
-    printf("ADC Single Conversion\n");
-    printf("Interrupt (EM2) - Run\n\n");
-#endif
+    return;
   }
 
-  /* Print ADC value after SINGLECMP interrrupt */
-  if (ADC0->SINGLEFIFOCOUNT == 0)
-  {
+  LETIMER_Enable(LETIMER0, false);
+  CMU_ClockEnable(cmuClock_LETIMER0, false);
+  NVIC_DisableIRQ(ADC0_IRQn);
+  ADC_IntDisable(ADC0, ADC_IEN_SINGLECMP);
+  ADC0->SINGLECTRL &= ~(ADC_SINGLECTRL_PRSEN | ADC_SINGLECTRL_CMPEN);
+  adcProfile = adcProfileNone;
+  adcWindowPending = false;
 
-#ifdef TEST
-    printf("FIFO 0: %1.4fV\n", ((float)(adcBuffer[0]) * ADC_SE_VFS)/ADC_12BIT_MAX);
-    printf("FIFO 1: %1.4fV\n", ((float)(adcBuffer[1]) * ADC_SE_VFS)/ADC_12BIT_MAX);
-    printf("FIFO 2: %1.4fV\n", ((float)(adcBuffer[2]) * ADC_SE_VFS)/ADC_12BIT_MAX);
-    printf("FIFO 3: %1.4fV\n", ((float)(adcBuffer[3]) * ADC_SE_VFS)/ADC_12BIT_MAX);
-  }
-  else
+  /* ADC_InitSingle() keeps these: back to full bias accuracy and one sample per LDMA request */
+  ADC0->BIASPROG = _ADC_BIASPROG_RESETVALUE;
+  ADC0->SINGLECTRLX &= ~_ADC_SINGLECTRLX_DVL_MASK;
+
+  /* Back to the default thresholds */
+  ADC0->CMPTHR = (ADC_CMP_GT_VALUE << _ADC_CMPTHR_ADGT_SHIFT) +
+                 (ADC_CMP_LT_VALUE << _ADC_CMPTHR_ADLT_SHIFT);
+}
+
+/**************************************************************************//**
+ * @brief Take the captured excursion and re-arm the window compare.
+ * @param[out] excursion
+ *   FIFO contents at the excursion.
+ * @return
+ *   False if there was no excursion since the last call.
+ *****************************************************************************/
+bool adcWindowGetExcursion(adcExcursion_t *excursion)
+{
+  if (!adcWindowPending)
   {
-    i = 0;
-    while (ADC0->SINGLEFIFOCOUNT)
-    {
-      printf("FIFO %lu: %1.4fV\n", i, ((float)(ADC_DataSingleGet(ADC0)) * ADC_SE_VFS)/ADC_12BIT_MAX);
-      i++;
-    }
-#endif
+    return false;
   }
-   int test2;
-   test2 = 2;
-   char t[32];
-   snprintf(t, sizeof(TEST_VALUE_TEXT),TEST_VALUE_TEXT, test2);
-   appUiWriteString(t);
 
-  //adcReset();
+  *excursion = adcWindowCapture;
+  adcWindowPending = false;
+
+  /* Start over with an empty FIFO so the next capture is all new context */
+  ADC0->SINGLEFIFOCLEAR = ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR;
+  ADC_IntClear(ADC0, ADC_IF_SINGLECMP);
+  ADC_IntEnable(ADC0, ADC_IEN_SINGLECMP);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Get the number of excursions since adcWindowStart().
+ *****************************************************************************/
+uint32_t adcWindowGetCount(void)
+{
+  return adcWindowCount;
 }
-#endif
 
 
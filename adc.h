@@ -17,6 +17,10 @@
 #include "em_rtcc.h"
 #include "em_adc.h"
 #include "em_ldma.h"
+#include "em_letimer.h"
+#include "adc_conv.h"
+#include "adc_dec.h"
+#include "tick_sched.h"
 
 /* Defined for ADC */
 #define ADC_CLOCK               1000000                 /* ADC conversion clock */
@@ -27,13 +31,14 @@
 #define ADC_INPUT2              adcPosSelAPORT3XCH2     /* PD10 */
 #define ADC_INPUT3              adcPosSelAPORT3YCH3     /* PD11 */
 #define ADC_CAL_INPUT           adcPosSelAPORT3XCH8     /* PA0 */
-#define ADC_NEG_OFFSET_VALUE    0xfff0                  /* Negative offset calibration */
-#define ADC_GAIN_CAL_VALUE      0xffd0                  /* Gain calibration */
+#define ADC_NEG_OFFSET_VALUE    0xfff0                  /* ADC0->CAL negative offset value */
+#define ADC_GAIN_CAL_VALUE      0xffd0                  /* ADC0->CAL gain value */
 #define ADC_PRS_CH_SELECT       adcPRSSELCh0
 #define ADC_SINGLE_DVL          4
 #define ADC_SCAN_DVL            4
 #define ADC_SCAN_DIFF_DVL       2
 #define ADC_BUFFER_SIZE         64
+#define ADC_BUFFER_HALF         (ADC_BUFFER_SIZE / 2)   /* Ping-pong block size */
 #define ADC_VIN_ATT             9                       /* VIN attenuation factor */
 #define ADC_VREF_ATT            0                       /* VREF attenuation factor */
 #define ADC_SE_VFS              (float)3.3              /* AVDD */
@@ -43,15 +48,97 @@
 #define ADC_16BIT_MAX           65536                   /* 2^16 */
 #define ADC_CMP_GT_VALUE        3724                    /* ~3.0V for 3.3V AVDD */
 #define ADC_CMP_LT_VALUE        620                     /* ~0.5V for 3.3V AVDD */
+#define ADC_CAL_ZERO_INPUT      adcPosSelVSS            /* 0 V point of the calibration */
+#define ADC_CAL_GAIN_INPUT      adcPosSelAVDD           /* Gain point, internal like the 0 V point */
+#define ADC_CAL_GAIN_ATT        4                       /* AVDD reaches the ADC divided by 4 */
+#define ADC_CAL_GAIN_MV         (ADC_CONV_SE_VFS_MV / ADC_CAL_GAIN_ATT)  /* Gain point on the VDD scale */
+#define ADC_CAL_SAMPLES         16                      /* Oversampled conversions averaged per point */
+#define ADC_CAL_MAX_OFFSET      1024                    /* Largest plausible zero code, ~50 mV */
+#define ADC_CAL_MAX_GAIN_ERR    50                      /* Largest plausible gain error in 1/1000 */
 #define ADC_DMA_CHANNEL         0
 #define ADC_DMA_CH_MASK         (1 << ADC_DMA_CHANNEL)
 
+/* Defines for multi-channel scan acquisition */
+#define ADC_SCAN_CHANNELS       4
+#define ADC_SCAN_CH_PA0         (1 << 0)                /* ADC_INPUT0 */
+#define ADC_SCAN_CH_PA1         (1 << 1)                /* ADC_INPUT1 */
+#define ADC_SCAN_CH_PD10        (1 << 2)                /* ADC_INPUT2 */
+#define ADC_SCAN_CH_PD11        (1 << 3)                /* ADC_INPUT3 */
+#define ADC_SCAN_CH_ALL         0x0F
+#define ADC_SCAN_SEQ_PER_HALF   (ADC_BUFFER_HALF / ADC_SCAN_DVL)   /* Scan sequences per LDMA half */
+#define ADC_SCAN_RING_SIZE      32                      /* Per channel, power of 2 */
+
 /* Defines for RTCC */
 #define RTCC_CC_CHANNEL         1
 #define RTCC_PRS_CHANNEL        0                       /* =ADC_PRS_CH_SELECT */
 #define RTCC_PRS_CH_SELECT      rtccPRSCh0              /* =ADC_PRS_CH_SELECT */
 #define RTCC_WAKEUP_MS          10
 #define RTCC_WAKEUP_COUNT       (((32768 * RTCC_WAKEUP_MS) / 1000) - 1)
+#define RTCC_WAKEUP_TICKS       ((32768 * RTCC_WAKEUP_MS) / 1000)
+#define ADC_TRIG_PERIOD_MAX_MS  100                     /* Longest period of adcSetTriggerPeriod() */
+
+/* Defines for window compare monitoring */
+#define ADC_WINDOW_CONTEXT      ADC_SINGLE_DVL          /* Samples kept in the single FIFO */
+#define ADC_WINDOW_PRS_SOURCE   PRS_CH_CTRL_SOURCESEL_LETIMER0
+#define ADC_WINDOW_PRS_SIGNAL   PRS_CH_CTRL_SIGSEL_LETIMER0CH0
+
+/* Defines for the oversampling/decimation pipeline */
+#define ADC_OVS_PROFILES        5                       /* Entries in adcOvsProfiles[] */
+#define ADC_OVS_DEFAULT         0                       /* Plain 12 bit at the trigger rate */
+
+/* ADC acquisition profiles for adcConfigure() */
+typedef enum
+{
+  adcProfileNone,               /* ADC not configured */
+  adcProfileSingle,             /* 12 bit software triggered single conversion on PA0 */
+  adcProfileSingleOvs,          /* 16 bit oversampled single conversion on PA0 */
+  adcProfileStream,             /* PRS triggered single conversion on PA0 moved by LDMA */
+  adcProfileScan,               /* PRS triggered scan of the selected inputs moved by LDMA */
+  adcProfileWindow              /* PRS triggered single conversion on PA0, wake on window compare */
+} adcProfile_t;
+
+/* Result of an oversampling/decimation profile */
+typedef struct
+{
+  uint16_t resolution;          /* Effective resolution in 0.1 bit */
+  uint32_t rate;                /* Output rate per channel in mHz */
+  uint32_t hwRatio;             /* Conversions averaged by the ADC per trigger */
+  uint32_t swRatio;             /* Decimation ratio of the software CIC */
+} adcOvsInfo_t;
+
+/* Single FIFO contents captured when PA0 left the compare window */
+typedef struct
+{
+  uint32_t timestamp;           /* RTCC counter at the excursion */
+  uint32_t count;               /* Valid entries in data, oldest first */
+  uint16_t data[ADC_WINDOW_CONTEXT];
+} adcExcursion_t;
+
+/* Single producer (LDMA interrupt), single consumer (main loop) ring buffer */
+typedef struct
+{
+  volatile uint32_t head;       /* Written by the producer only */
+  volatile uint32_t tail;       /* Written by the consumer only */
+  uint32_t drops;               /* Samples dropped because the ring was full */
+  uint16_t data[ADC_SCAN_RING_SIZE];
+} adcRing_t;
+
+/* Cycles spent on one kind of operation, measured with the DWT cycle counter */
+typedef struct
+{
+  uint32_t count;               /* Operations measured */
+  uint32_t last;                /* Cycles of the last one */
+  uint32_t min;                 /* Fewest cycles of any */
+  uint32_t max;                 /* Most cycles of any */
+  uint64_t total;               /* Sum over all */
+} adcCycles_t;
+
+/* Cycles per sample, trigger to read or conversion interrupt, and per profile change */
+typedef struct
+{
+  adcCycles_t sample;
+  adcCycles_t configure;
+} adcCycleStats_t;
 
 /* Buffer for ADC interrupt flag */
 volatile uint32_t adcIntFlag;
@@ -70,6 +157,73 @@ void adcSetup(void);
 
 void ldmaSetup(void);
 
+void adcConfigure(adcProfile_t profile);
+
+void adcTrigger(void);
+
+uint32_t adcRead(void);
+
+void adcCycleUpdate(uint32_t cycles);
+
+void adcGetCycleStats(adcCycleStats_t *stats);
+
+void adcResetCycleStats(void);
+
+void adcGetTriggerJitter(tickJitter_t *jitter);
+
+void adcResetTriggerJitter(void);
+
+bool adcCalibrate(void);
+
+void adcGetCalibration(adcCal_t *cal);
+
+bool adcSetCalibration(const adcCal_t *cal);
+
+int32_t adcToMilliVolt(uint32_t sample, uint32_t bits);
+
+uint32_t adcFromMilliVolt(int32_t milliVolt, uint32_t bits);
+
+void adcStreamStart(void);
+
+void adcStreamStop(void);
+
+const uint32_t *adcStreamGetBlock(void);
+
+void adcStreamReleaseBlock(void);
+
+uint32_t adcStreamGetOverruns(void);
+
+void adcScanStart(uint32_t channelMask);
+
+uint32_t adcScanGetMask(void);
+
+bool adcScanRead(uint32_t channel, uint16_t *sample);
+
+uint32_t adcScanGetDrops(uint32_t channel);
+
+bool adcOvsSelect(uint32_t index);
+
+uint32_t adcOvsGetSelected(void);
+
+bool adcOvsGetInfo(uint32_t index, adcOvsInfo_t *info);
+
+uint32_t adcTrigPeriodMin(uint32_t index);
+
+bool adcSetTriggerPeriod(uint32_t ms);
+
+uint32_t adcGetTriggerPeriod(void);
+
+bool adcDecimate(uint32_t channel, uint32_t sample, uint16_t *out);
+
+bool adcWindowStart(uint32_t low, uint32_t high);
+
+bool adcWindowSet(uint32_t low, uint32_t high);
+
+void adcWindowStop(void);
+
+bool adcWindowGetExcursion(adcExcursion_t *excursion);
+
+uint32_t adcWindowGetCount(void);
 
 
 
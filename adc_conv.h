@@ -0,0 +1,118 @@
+/*
+ * adc_conv.h
+ *
+ *  Fixed-point (Q16) conversion of calibrated ADC codes to millivolts.
+ *  Plain C on purpose: no emlib or device headers, so the same code runs on
+ *  the target and on a host.
+ */
+
+#ifndef ADC_CONV_H_
+#define ADC_CONV_H_
+#include <stdint.h>
+
+/* Defines for fixed-point conversion */
+#define ADC_CONV_Q              16                      /* Fraction bits of adcCal_t.scale */
+#define ADC_CONV_BITS           16                      /* Code domain of the coefficients */
+#define ADC_CONV_SE_VFS_MV      3300                    /* AVDD in mV */
+
+/* Calibration coefficients, in the 16 bit (oversampled) code domain */
+typedef struct
+{
+  int32_t offset;               /* Code measured with 0 V at the input */
+  uint32_t scale;               /* mV per code, Q16, includes the gain error */
+} adcCal_t;
+
+/**************************************************************************//**
+ * @brief Ideal coefficients: no offset, full scale equals ADC_CONV_SE_VFS_MV.
+ *****************************************************************************/
+static inline void adcConvDefault(adcCal_t *cal)
+{
+  cal->offset = 0;
+  cal->scale = ((uint32_t)ADC_CONV_SE_VFS_MV << ADC_CONV_Q) >> ADC_CONV_BITS;
+}
+
+/**************************************************************************//**
+ * @brief Derive coefficients from a two point measurement.
+ * @param[in] zeroCode
+ *   16 bit code measured with 0 V at the input.
+ * @param[in] refCode
+ *   16 bit code measured with refMilliVolt at the input.
+ * @return
+ *   0 on success, -1 if the measurement can not give a positive gain.
+ *****************************************************************************/
+static inline int32_t adcConvCalibrate(adcCal_t *cal, uint32_t zeroCode,
+                                       uint32_t refCode, uint32_t refMilliVolt)
+{
+  if (refCode <= zeroCode)
+  {
+    return -1;
+  }
+  cal->offset = (int32_t)zeroCode;
+  cal->scale = (uint32_t)((((uint64_t)refMilliVolt << ADC_CONV_Q) + ((refCode - zeroCode) / 2))
+                          / (refCode - zeroCode));
+  return 0;
+}
+
+/**************************************************************************//**
+ * @brief Check coefficients against the tolerances of the ADC, so a failed
+ *   measurement or a corrupted store is not taken for a calibration.
+ * @param[in] maxOffset
+ *   Largest |offset| in 16 bit codes.
+ * @param[in] maxGainErr
+ *   Largest deviation of the scale from adcConvDefault() in 1/1000.
+ * @return
+ *   0 if plausible, -1 if not.
+ *****************************************************************************/
+static inline int32_t adcConvCheck(const adcCal_t *cal, uint32_t maxOffset, uint32_t maxGainErr)
+{
+  uint32_t ideal = ((uint32_t)ADC_CONV_SE_VFS_MV << ADC_CONV_Q) >> ADC_CONV_BITS;
+  uint32_t error = (cal->scale > ideal) ? (cal->scale - ideal) : (ideal - cal->scale);
+  uint32_t offset = (uint32_t)((cal->offset < 0) ? -cal->offset : cal->offset);
+
+  if ((offset > maxOffset) || (((uint64_t)error * 1000) > ((uint64_t)ideal * maxGainErr)))
+  {
+    return -1;
+  }
+  return 0;
+}
+
+/**************************************************************************//**
+ * @brief Convert a raw sample to millivolts, integer only.
+ * @param[in] sample
+ *   Raw ADC result.
+ * @param[in] bits
+ *   Resolution of the sample (12, or 16 for oversampled results).
+ *****************************************************************************/
+static inline int32_t adcConvToMilliVolt(const adcCal_t *cal, uint32_t sample, uint32_t bits)
+{
+  int32_t code = (int32_t)(sample << (ADC_CONV_BITS - bits)) - cal->offset;
+
+  /* Single 32x32->64 multiply (SMULL on Cortex-M4), rounded */
+  return (int32_t)(((int64_t)code * cal->scale + (1 << (ADC_CONV_Q - 1))) >> ADC_CONV_Q);
+}
+
+/**************************************************************************//**
+ * @brief Convert millivolts back to a raw sample, e.g. for compare thresholds.
+ * @param[in] bits
+ *   Resolution of the result (12, or 16 for oversampled results).
+ * @return
+ *   Raw code, clamped to the range of the resolution.
+ *****************************************************************************/
+static inline uint32_t adcConvFromMilliVolt(const adcCal_t *cal, int32_t milliVolt, uint32_t bits)
+{
+  int64_t code;
+
+  code = ((((int64_t)milliVolt << ADC_CONV_Q) + (cal->scale / 2)) / cal->scale) + cal->offset;
+  code >>= (ADC_CONV_BITS - bits);
+  if (code < 0)
+  {
+    return 0;
+  }
+  if (code >= ((int64_t)1 << bits))
+  {
+    return ((uint32_t)1 << bits) - 1;
+  }
+  return (uint32_t)code;
+}
+
+#endif /* ADC_CONV_H_ */
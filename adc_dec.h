@@ -0,0 +1,106 @@
+/*
+ * adc_dec.h
+ *
+ *  Software CIC decimator for 16 bit ADC samples. Decimation by 2^log2R
+ *  with 1 or 2 integrator/comb stages; order 1 is a plain block average.
+ *  Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef ADC_DEC_H_
+#define ADC_DEC_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines for the CIC decimator */
+#define ADC_CIC_MAX_ORDER       2
+#define ADC_CIC_MAX_GROWTH      16                      /* 16 bit input in 32 bit registers */
+
+typedef struct
+{
+  uint32_t integ[ADC_CIC_MAX_ORDER];    /* Integrator registers, wrap around on purpose */
+  uint32_t comb[ADC_CIC_MAX_ORDER];     /* Previous comb inputs */
+  uint32_t phase;                       /* Inputs since the last output */
+  uint8_t order;                        /* 0 bypasses the decimator */
+  uint8_t log2R;                        /* Decimation ratio is 1 << log2R */
+} adcCic_t;
+
+/**************************************************************************//**
+ * @brief Reset a decimator.
+ * @param[in] order
+ *   Number of integrator/comb stages, 0 to ADC_CIC_MAX_ORDER.
+ * @param[in] log2R
+ *   Decimation ratio as a power of 2. order * log2R is limited to
+ *   ADC_CIC_MAX_GROWTH so the registers can not overflow.
+ *****************************************************************************/
+static inline void adcCicInit(adcCic_t *cic, uint32_t order, uint32_t log2R)
+{
+  uint32_t i;
+
+  if (order > ADC_CIC_MAX_ORDER)
+  {
+    order = ADC_CIC_MAX_ORDER;
+  }
+  if ((order == 0) || (log2R == 0))
+  {
+    order = 0;
+    log2R = 0;
+  }
+  else if ((order * log2R) > ADC_CIC_MAX_GROWTH)
+  {
+    log2R = ADC_CIC_MAX_GROWTH / order;
+  }
+
+  for (i = 0; i < ADC_CIC_MAX_ORDER; i++)
+  {
+    cic->integ[i] = 0;
+    cic->comb[i] = 0;
+  }
+  cic->phase = 0;
+  cic->order = (uint8_t)order;
+  cic->log2R = (uint8_t)log2R;
+}
+
+/**************************************************************************//**
+ * @brief Push one sample through the decimator.
+ * @param[in] sample
+ *   16 bit input sample.
+ * @param[out] out
+ *   Decimated 16 bit sample, gain normalized to 1.
+ * @return
+ *   True every 1 << log2R inputs, when out is valid.
+ *****************************************************************************/
+static inline bool adcCicPush(adcCic_t *cic, uint32_t sample, uint32_t *out)
+{
+  uint32_t i, v, t;
+
+  if (cic->order == 0)
+  {
+    *out = sample;
+    return true;
+  }
+
+  v = sample;
+  for (i = 0; i < cic->order; i++)
+  {
+    cic->integ[i] += v;
+    v = cic->integ[i];
+  }
+  if (++cic->phase < (1UL << cic->log2R))
+  {
+    return false;
+  }
+  cic->phase = 0;
+
+  for (i = 0; i < cic->order; i++)
+  {
+    t = v;
+    v -= cic->comb[i];
+    cic->comb[i] = t;
+  }
+
+  /* Gain of the filter is R^order */
+  *out = v >> (cic->order * cic->log2R);
+  return true;
+}
+
+#endif /* ADC_DEC_H_ */
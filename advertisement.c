@@ -28,6 +28,7 @@
 /* application specific headers*/
 #include "app_ui.h"
 #include "beacon.h"
+#include "conn.h"
 
 /* Own header */
 #include "advertisement.h"
@@ -49,6 +50,11 @@
 /* Text definitions */
 #define ADV_HTMKYFOB_ADV_TEXT        "\nH T M / K E Y F O B\n\nM O D E\n"
 
+/* Connectable advertising interval in 0.625 ms units. It doubles with every open connection, so a
+ * device that already serves centrals spends less air time on finding more. */
+#define ADV_INTERVAL_MIN             160         /* 100 ms with all slots free */
+#define ADV_INTERVAL_MAX             1600        /* 1 s */
+
 /***************************************************************************************************
    Local Variables
  **************************************************************************************************/
@@ -57,18 +63,47 @@ static bool advConnectableMode = true;
 
 static bool advIsConnected = false;
 
+/** Connectable advertising interval in use, 0 while not advertising connectable. */
+static uint32_t advInterval = 0;
+
+/** Open connections when connectable advertising was last started. */
+static uint8_t advConnections = 0;
+
+/***************************************************************************************************
+   Static Function Declarations
+ **************************************************************************************************/
+
+static void advStartConnectable(uint8_t connections);
+
 /***************************************************************************************************
    Function Definitions
  **************************************************************************************************/
 void advSetup(void)
 {
+  uint8_t connections = connCount();
+
+  if (connections >= MAX_CONNECTIONS) {
+    /* No slot left for another central */
+    gecko_cmd_le_gap_stop_advertising(0);
+    advInterval = 0;
+    advConnections = connections;
+    return;
+  }
+  if (connections > 0) {
+    /* The stack stops advertising when a central connects; keep inviting more. They subscribe
+     * like the first one and get their own stream frames. */
+    advStartConnectable(connections);
+    return;
+  }
+
   if (advConnectableMode == true) {
     /* set server advertising data and start advertising */
     appUiWriteString(ADV_HTMKYFOB_ADV_TEXT);
     /* start advertising */
-    gecko_cmd_le_gap_start_advertising(0, le_gap_general_discoverable, le_gap_connectable_scannable);
+    advStartConnectable(0);
   } else {
     bcnSetupAdvBeaconing();
+    advInterval = 0;
   }
   appUiLedOff();
 
@@ -83,6 +118,7 @@ void advSwitchAdvMessage(void)
 
     /* stop advertisement*/
     gecko_cmd_le_gap_stop_advertising(0);
+    advInterval = 0;
   }
   advSetup();
 }
@@ -92,5 +128,37 @@ void advConnectionStarted(void)
   advIsConnected = true;
 }
 
+/***************************************************************************************************
+   Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Start connectable advertising at the interval for the number of open connections.
+ *  \details  Advertising that already runs at that interval is left alone.
+ **************************************************************************************************/
+static void advStartConnectable(uint8_t connections)
+{
+  uint32_t interval = (uint32_t)ADV_INTERVAL_MIN << connections;
+
+  if (interval > ADV_INTERVAL_MAX) {
+    interval = ADV_INTERVAL_MAX;
+  }
+  if (connections > advConnections) {
+    advInterval = 0; /* The stack stopped advertising when the new central connected */
+  }
+  advConnections = connections;
+  if (interval == advInterval) {
+    return;
+  }
+
+  /* Advertising has to be stopped for the new timing to take effect */
+  if (advInterval != 0) {
+    gecko_cmd_le_gap_stop_advertising(0);
+  }
+  gecko_cmd_le_gap_set_advertise_timing(0, interval, interval + (interval / 4), 0, 0);
+  gecko_cmd_le_gap_start_advertising(0, le_gap_general_discoverable, le_gap_connectable_scannable);
+  advInterval = interval;
+}
+
 /** @} (end addtogroup adv) */
 /** @} (end addtogroup Advertisement) */
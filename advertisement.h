@@ -46,6 +46,8 @@ extern "C" {
 
 /***********************************************************************************************//**
  *  \brief  Setup advertising.
+ *  \details  While connected, advertising stays connectable until all MAX_CONNECTIONS slots are
+ *  taken, at an interval that grows with every open connection.
  **************************************************************************************************/
 void advSetup(void);
 
@@ -35,7 +35,11 @@
 #include "advertisement.h"
 #include "beacon.h"
 #include "app_timer.h"
+#include "app_signal.h"
 #include "board_features.h"
+#include "conn.h"
+#include "notify.h"
+#include "ldc1612_async.h"
 
 /* Own header */
 #include "app.h"
@@ -59,6 +63,9 @@ char end[100];
  * Local Variables
  **************************************************************************************************/
 
+/** appHwInit() has run since boot. */
+static bool appHwStarted = false;
+
 /***************************************************************************************************
  * Static Function Declarations
  **************************************************************************************************/
@@ -98,8 +105,14 @@ void appInit(void)
   /* Initialize LEDs, buttons, graphics. */
   appUiInit(devId);
 
-  /* Hardware initialization. Initializes temperature sensor. */
-  appHwInit();
+  /* Hardware initialization once after boot. Sensor transfers keep running across connections,
+   * one may be in flight when the last connection closes. */
+  if (!appHwStarted) {
+    appHwInit();
+    appHwStarted = true;
+  } else {
+    appHwRestart();
+  }
 
   /* Initialize services */
   htmInit();
@@ -119,6 +132,19 @@ void appHandleEvents(struct gecko_cmd_packet *evt)
     /* Boot event and connection closed event */
     case gecko_evt_system_boot_id:
     case gecko_evt_le_connection_closed_id:
+      if (BGLIB_MSG_ID(evt->header) == gecko_evt_system_boot_id) {
+        connInit(); /* Link parameter tracking, MTU offered to clients */
+        notifyInit();
+      } else {
+        connClosed(evt->data.evt_le_connection_closed.connection);
+        notifyConnectionClosed(evt->data.evt_le_connection_closed.connection);
+        if (connCount() > 0) {
+          /* Others stay connected, only drop what belonged to this one */
+          htmConnectionClosed(evt->data.evt_le_connection_closed.connection);
+          advSetup();
+          break;
+        }
+      }
 
       /* Initialize app */
 
@@ -137,6 +163,25 @@ void appHandleEvents(struct gecko_cmd_packet *evt)
     case gecko_evt_le_connection_opened_id:
       /* Call advertisement.c connection started callback */
       advConnectionStarted();
+      /* Track the link and ask for the 2M PHY; the MTU exchange follows automatically */
+      connOpened(evt->data.evt_le_connection_opened.connection);
+      /* Keep advertising, more slowly, while connection slots are free */
+      advSetup();
+      break;
+
+    /* Connection interval, latency, timeout or data length changed */
+    case gecko_evt_le_connection_parameters_id:
+      connParameters(evt->data.evt_le_connection_parameters.connection,
+                     evt->data.evt_le_connection_parameters.interval,
+                     evt->data.evt_le_connection_parameters.latency,
+                     evt->data.evt_le_connection_parameters.timeout,
+                     evt->data.evt_le_connection_parameters.txsize);
+      break;
+
+    /* PHY changed */
+    case gecko_evt_le_connection_phy_status_id:
+      connPhyStatus(evt->data.evt_le_connection_phy_status.connection,
+                    evt->data.evt_le_connection_phy_status.phy);
       break;
 
     /* Value of attribute changed from the local database by remote GATT client */
@@ -146,6 +191,17 @@ void appHandleEvents(struct gecko_cmd_packet *evt)
         /* Write the Immediate Alert level value */
         iaImmediateAlertWrite(&evt->data.evt_gatt_server_attribute_value.value);
       }
+      /* Measurement Interval, uint16 seconds */
+      if ((gattdb_MeasInt == evt->data.evt_gatt_server_attribute_value.attribute)
+          && (evt->data.evt_gatt_server_attribute_value.value.len == 2)) {
+        htmSetMeasInterval(evt->data.evt_gatt_server_attribute_value.value.data[0]
+                           | (evt->data.evt_gatt_server_attribute_value.value.data[1] << 8));
+      }
+      /* Heart Rate Control Point commands */
+      if (gattdb_heart_rate_control_point == evt->data.evt_gatt_server_attribute_value.attribute) {
+        htmControlPointWrite(evt->data.evt_gatt_server_attribute_value.connection,
+                             &evt->data.evt_gatt_server_attribute_value.value);
+      }
       break;
 
     /* Indicates the changed value of CCC or received characteristic confirmation */
@@ -159,6 +215,52 @@ void appHandleEvents(struct gecko_cmd_packet *evt)
           evt->data.evt_gatt_server_characteristic_status.connection,
           evt->data.evt_gatt_server_characteristic_status.client_config_flags);
       }
+      /* Health Thermometer temperature, indications and their confirmations */
+      if (gattdb_temperature_measurement == evt->data.evt_gatt_server_characteristic_status.characteristic) {
+        if (evt->data.evt_gatt_server_characteristic_status.status_flags == 0x01) {
+          htmTempMeasCharStatusChange(
+            evt->data.evt_gatt_server_characteristic_status.connection,
+            evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+        } else if (evt->data.evt_gatt_server_characteristic_status.status_flags == 0x02) {
+          htmTempMeasConfirmed(evt->data.evt_gatt_server_characteristic_status.connection);
+        }
+      }
+      /* Batched sample stream */
+      if ((gattdb_sensor_stream == evt->data.evt_gatt_server_characteristic_status.characteristic)
+          && (evt->data.evt_gatt_server_characteristic_status.status_flags == 0x01)) {
+        htmStreamCharStatusChange(
+          evt->data.evt_gatt_server_characteristic_status.connection,
+          evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      }
+      /* Spectral summaries */
+      if ((gattdb_sensor_spectrum == evt->data.evt_gatt_server_characteristic_status.characteristic)
+          && (evt->data.evt_gatt_server_characteristic_status.status_flags == 0x01)) {
+        htmSpectrumCharStatusChange(
+          evt->data.evt_gatt_server_characteristic_status.connection,
+          evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      }
+      /* Newest sample of each selected ADC input */
+      if ((gattdb_sensor_channels == evt->data.evt_gatt_server_characteristic_status.characteristic)
+          && (evt->data.evt_gatt_server_characteristic_status.status_flags == 0x01)) {
+        htmChannelsCharStatusChange(
+          evt->data.evt_gatt_server_characteristic_status.connection,
+          evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      }
+      /* Window monitoring excursions */
+      if ((gattdb_sensor_excursion == evt->data.evt_gatt_server_characteristic_status.characteristic)
+          && (evt->data.evt_gatt_server_characteristic_status.status_flags == 0x01)) {
+        htmExcursionCharStatusChange(
+          evt->data.evt_gatt_server_characteristic_status.connection,
+          evt->data.evt_gatt_server_characteristic_status.client_config_flags);
+      }
+      break;
+
+    /* ATT MTU negotiated with the client */
+    case gecko_evt_gatt_mtu_exchanged_id:
+      connMtuExchanged(evt->data.evt_gatt_mtu_exchanged.connection,
+                       evt->data.evt_gatt_mtu_exchanged.mtu);
+      htmMtuExchanged(evt->data.evt_gatt_mtu_exchanged.connection,
+                      evt->data.evt_gatt_mtu_exchanged.mtu);
       break;
 
     /* Software Timer event */
@@ -171,14 +273,21 @@ void appHandleEvents(struct gecko_cmd_packet *evt)
         case ADV_TIMER: /* Advertisement Timer */
           advSetup();
           break;
-        /*case TEMP_TIMER: Temperature measurement timer */
-          /* Make a temperature measurement */
-          //htmTemperatureMeasure();
-        	//htmFrequencyMeasure();
-          //break;
+        case TEMP_TIMER: /* Si7013 measurement timer */
+          htmTempTick();
+          break;
         case MEAS_TIMER:
           measTick();
           break;
+        case NOTIFY_TIMER: /* Queued notifications, next connection event */
+          notifyDrain();
+          break;
+        case LDC_TIMER: /* LDC1612 read sequence abandoned after I2C errors */
+          ldcAsyncResume();
+          break;
+        case STREAM_TIMER: /* Partly filled stream frame past its deadline */
+          htmStreamTick();
+          break;
         #ifndef FEATURE_IOEXPANDER
         case DISP_POL_INV_TIMER:
           /*Toggle the the EXTCOMIN signal, which prevents building up a DC bias  within the
@@ -191,6 +300,34 @@ void appHandleEvents(struct gecko_cmd_packet *evt)
       }
       break;
 
+    /* External signal raised from an interrupt handler */
+    case gecko_evt_system_external_signal_id:
+      if (evt->data.evt_system_external_signal.extsignals & APP_SIGNAL_ADC_HALF) {
+        /* A half of the ADC ping-pong buffer is ready */
+        htmAdcStreamHandler();
+      }
+      if (evt->data.evt_system_external_signal.extsignals & APP_SIGNAL_ADC_SCAN) {
+        /* New samples in the per-channel scan ring buffers */
+        htmAdcScanHandler();
+      }
+      if (evt->data.evt_system_external_signal.extsignals & APP_SIGNAL_LDC_DATA) {
+        /* LDC1612 conversions read in the background */
+        htmLdcDataHandler();
+      }
+      if (evt->data.evt_system_external_signal.extsignals & APP_SIGNAL_SI7013_DATA) {
+        /* Si7013 result read in the background */
+        htmTempDataHandler();
+      }
+      if (evt->data.evt_system_external_signal.extsignals & APP_SIGNAL_ADC_WINDOW) {
+        /* PA0 left the monitoring window */
+        htmAdcWindowHandler();
+      }
+      if (evt->data.evt_system_external_signal.extsignals & APP_SIGNAL_LDC_STALL) {
+        /* Give the I2C bus a moment before reading the LDC1612 again */
+        gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(LDC_RETRY_MS), LDC_TIMER, true);
+      }
+      break;
+
     /* User write request event. Checks if the user-type OTA Control Characteristic was written.
      * If written, boots the device into Device Firmware Upgrade (DFU) mode. */
     case gecko_evt_gatt_server_user_write_request_id:
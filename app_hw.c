@@ -10,8 +10,10 @@
  **************************************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 /* BG stack headers */
 #include "bg_types.h"
+#include "native_gecko.h"
 
 /* STK header files. */
 #if defined(HAL_CONFIG)
@@ -31,10 +33,14 @@
 #include "si7013.h"
 #include "tempsens.h"
 #include "mx25flash_spi.h"
+#include "gpiointerrupt.h"
 
 /* application specific headers */
 #include "advertisement.h"
 #include "app_ui.h"
+#include "adc.h"
+#include "i2c_async.h"
+#include "ldc1612_async.h"
 
 /* Own headers*/
 #include "app_hw.h"
@@ -62,6 +68,11 @@
 #define APP_FREQ_SENSOR_ID_TEXT				"Ldc1612 sensor detected.\n DeviceID:%5d"
 #define APP_FREQ_SENSOR_ID_TEXT_DEFAULT		"Ldc1612 sensor detected.\n DeviceID:-----d"
 #define APP_FREQ_SENSOR_ID_TEXT_SIZE		(sizeof(APP_FREQ_SENSOR_ID_TEXT_DEFAULT))
+
+/* ADC calibration */
+#define APP_HW_ADC_CAL_PS_KEY           0x4000      /* Persistent store key of the coefficients */
+#define APP_HW_ADC_CAL_OK_TEXT          "ADC calibrated.\n"
+#define APP_HW_ADC_CAL_FAIL_TEXT        "ADC calibration\nfailed.\n"
 /***************************************************************************************************
  * Local Variables
  **************************************************************************************************/
@@ -69,11 +80,19 @@
 /** Status flag of the Temperature Sensor. */
 static bool si7013_status = false;
 
+/** Status flag of the inductive sensor. */
+static bool ldc1612_status = false;
+
+/** Background LDC1612 reads held by appHwFreqSensEnable(). */
+static bool ldc1612_paused = false;
+
 /***************************************************************************************************
  * Static Function Declarations
  **************************************************************************************************/
 
 static void appBtnCback(AppUiBtnEvt_t btn);
+static bool appHwLdcRead(uint8_t reg, uint16_t *value);
+static bool appHwLdcWrite(uint8_t reg, uint16_t value);
 
 /***************************************************************************************************
  * Public Function Definitions
@@ -104,15 +123,33 @@ void appHwInit(void)
 	 ******************************************************************************/
 	uint16_t deviceId = 0;
 	char deviceIdString[APP_FREQ_SENSOR_ID_TEXT_SIZE];
+	/* The blocking I2CSPM calls below must not overlap a background read. */
+	ldcAsyncStop();
+	while (i2cAsyncBusy()) ;
 	/* Initialize inductive sensor. */
-	if (!appHwInitFreqSens(&deviceId)) {
+	ldc1612_status = appHwInitFreqSens(&deviceId);
+	if (!ldc1612_status) {
 		appUiWriteString(APP_FREQ_SENSOR_FAIL_TEXT); /* Display error message on screen. */
 	}
 	else {
 		snprintf(deviceIdString, APP_FREQ_SENSOR_ID_TEXT_SIZE, APP_FREQ_SENSOR_ID_TEXT, deviceId);
 		appUiWriteString(deviceIdString);
+		/* From here on conversions are read on INTB, outside the BLE event loop. */
+		GPIOINT_Init();
+		i2cAsyncInit();
+		appHwConfigFreqChannels(LDC1612_ACQ_CHANNELS);
+		ldcAsyncStart(LDC1612_ACQ_CHANNELS);
+		ldc1612_paused = false;
 	}
 
+	/* Use the stored ADC calibration if there is one. */
+	appHwLoadAdcCal();
+}
+
+void appHwRestart(void)
+{
+  /* Sensors, I2C queue and calibration stay as set up at boot; transfers in flight complete. */
+  appHwFreqSensEnable(true);
 }
 
 int32_t appHwReadTm(int32_t* tempData, uint32_t* rhData)
@@ -141,15 +178,158 @@ int32_t appHwReadFreq(uint32_t* freqData0, uint32_t* freqData1)
   return LDC1612_ReadFreq(I2C0, LDC1612_ADDR, freqData0, freqData1);
 }
 
+bool appHwConfigFreqChannels(uint8_t channelMask)
+{
+  uint16_t config, mux;
+
+  if (!appHwLdcRead(LDC1612_REG_CONFIG, &config) || !appHwLdcRead(LDC1612_REG_MUX_CONFIG, &mux)) {
+    return false;
+  }
+
+  /* Channel selection may only change in sleep mode */
+  config |= LDC1612_CONFIG_SLEEP_MODE_EN;
+  if (!appHwLdcWrite(LDC1612_REG_CONFIG, config)) {
+    return false;
+  }
+
+  if (channelMask == (LDC1612_CH0 | LDC1612_CH1)) {
+    /* Sequenced conversion CH0, CH1; INTB fires once the sequence is complete */
+    mux |= LDC1612_MUX_AUTOSCAN_EN;
+    mux &= ~LDC1612_MUX_RR_SEQUENCE_MASK;
+  } else {
+    mux &= ~LDC1612_MUX_AUTOSCAN_EN;
+    config &= ~LDC1612_CONFIG_ACTIVE_CHAN_MASK;
+    config |= (channelMask == LDC1612_CH1) ? (1 << LDC1612_CONFIG_ACTIVE_CHAN_SHIFT) : 0;
+  }
+  config &= ~LDC1612_CONFIG_SLEEP_MODE_EN;
+  return appHwLdcWrite(LDC1612_REG_MUX_CONFIG, mux) && appHwLdcWrite(LDC1612_REG_CONFIG, config);
+}
+
+bool appHwSetFreqProfile(const ldcProfile_t *profile)
+{
+  uint16_t config;
+  uint8_t ch;
+  bool ok;
+
+  if (!ldc1612_status) {
+    return false;
+  }
+
+  /* The blocking writes below must not overlap a background read. */
+  ldcAsyncStop();
+  while (i2cAsyncBusy()) ;
+
+  ok = appHwLdcRead(LDC1612_REG_CONFIG, &config)
+       && appHwLdcWrite(LDC1612_REG_CONFIG, config | LDC1612_CONFIG_SLEEP_MODE_EN);
+  for (ch = 0; ok && (ch < LDC1612_CHANNELS); ch++) {
+    ok = appHwLdcWrite(LDC1612_REG_RCOUNT0 + ch, profile->rcount)
+         && appHwLdcWrite(LDC1612_REG_SETTLECOUNT0 + ch, profile->settleCount)
+         && appHwLdcWrite(LDC1612_REG_CLOCK_DIVIDERS0 + ch, profile->clockDividers);
+  }
+  if (ok) {
+    ok = appHwLdcWrite(LDC1612_REG_CONFIG, config & ~LDC1612_CONFIG_SLEEP_MODE_EN);
+  }
+
+  if (!ldc1612_paused) {
+    ldcAsyncStart(LDC1612_ACQ_CHANNELS);
+  }
+  return ok;
+}
+
+void appHwFreqSensEnable(bool enable)
+{
+  if (!ldc1612_status || (enable != ldc1612_paused)) {
+    return;
+  }
+  ldc1612_paused = !enable;
+  if (enable) {
+    /* The read held last may still be queued with the transfer about to be reused */
+    while (i2cAsyncBusy()) ;
+    ldcAsyncStart(LDC1612_ACQ_CHANNELS);
+  } else {
+    ldcAsyncStop();
+  }
+}
+
 int32_t appHwReadFlash(uint32_t* MX25ID)
 {
 	return MX25_RDID(MX25ID);
 }
 
+bool appHwAdcCalibrate(void)
+{
+  adcCal_t cal;
+
+  if (!adcCalibrate()) {
+    appUiWriteString(APP_HW_ADC_CAL_FAIL_TEXT);
+    return false;
+  }
+
+  adcGetCalibration(&cal);
+  gecko_cmd_flash_ps_save(APP_HW_ADC_CAL_PS_KEY, sizeof(cal), (const uint8_t *)&cal);
+  appUiWriteString(APP_HW_ADC_CAL_OK_TEXT);
+  return true;
+}
+
+bool appHwLoadAdcCal(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+  adcCal_t cal;
+
+  rsp = gecko_cmd_flash_ps_load(APP_HW_ADC_CAL_PS_KEY);
+  if ((rsp->result != 0) || (rsp->value.len != sizeof(cal))) {
+    return false;
+  }
+
+  memcpy(&cal, rsp->value.data, sizeof(cal));
+  return adcSetCalibration(&cal);
+}
+
 /***************************************************************************************************
  * Static Function Definitions
  **************************************************************************************************/
 
+/***********************************************************************************************//**
+ *  \brief  Read a LDC1612 register with a blocking transfer. The I2C queue must be idle.
+ **************************************************************************************************/
+static bool appHwLdcRead(uint8_t reg, uint16_t *value)
+{
+  I2C_TransferSeq_TypeDef seq;
+  uint8_t rx[2];
+
+  seq.addr = LDC1612_ADDR;
+  seq.flags = I2C_FLAG_WRITE_READ;
+  seq.buf[0].data = &reg;
+  seq.buf[0].len = 1;
+  seq.buf[1].data = rx;
+  seq.buf[1].len = 2;
+  if (I2CSPM_Transfer(I2C0, &seq) != i2cTransferDone) {
+    return false;
+  }
+  *value = (uint16_t)((rx[0] << 8) | rx[1]);
+  return true;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Write a LDC1612 register with a blocking transfer. The I2C queue must be idle.
+ **************************************************************************************************/
+static bool appHwLdcWrite(uint8_t reg, uint16_t value)
+{
+  I2C_TransferSeq_TypeDef seq;
+  uint8_t tx[3];
+
+  tx[0] = reg;
+  tx[1] = (uint8_t)(value >> 8);
+  tx[2] = (uint8_t)value;
+  seq.addr = LDC1612_ADDR;
+  seq.flags = I2C_FLAG_WRITE;
+  seq.buf[0].data = tx;
+  seq.buf[0].len = 3;
+  seq.buf[1].data = NULL;
+  seq.buf[1].len = 0;
+  return (I2CSPM_Transfer(I2C0, &seq) == i2cTransferDone);
+}
+
 /***********************************************************************************************//**
  *  \brief  Button press callback.
  *  \param[in]  btn  Button press length and button number
@@ -158,6 +338,9 @@ static void appBtnCback(AppUiBtnEvt_t btn)
 {
   if (APP_UI_BTN_0_SHORT == btn) {
     advSwitchAdvMessage();
+  } else if (APP_UI_BTN_1_LONG == btn) {
+    /* Internal inputs only, nothing has to be connected */
+    appHwAdcCalibrate();
   }
 }
 
@@ -18,6 +18,7 @@ extern "C" {
 
 #include "em_device.h"
 #include <stdbool.h>
+#include "ldc1612_async.h"
 
 /***********************************************************************************************//**
  * \defgroup app_hw Application Hardware Specific
@@ -44,9 +45,16 @@ extern "C" {
 
 /***********************************************************************************************//**
  *  \brief  Initialize buttons and Temperature sensor.
+ *  \details  Once after boot: also sets up the I2C queue and starts the LDC1612 reads.
  **************************************************************************************************/
 void appHwInit(void);
 
+/***********************************************************************************************//**
+ *  \brief  Resume acquisition after the last connection closed, without initializing the sensors
+ *  or the I2C queue again.
+ **************************************************************************************************/
+void appHwRestart(void);
+
 /***********************************************************************************************//**
  *  \brief  Perform a temperature & relative humidity measurement.  Return the measurement data.
  *  \param[out]  tempData  Result of temperature conversion.
@@ -65,7 +73,42 @@ bool appHwInitTempSens(void);
  ******************************************************************************/
 int32_t appHwReadFreq(uint32_t* freqData0, uint32_t* freqData1);
 bool appHwInitFreqSens(uint16_t* deviceId);
+
+/***********************************************************************************************//**
+ *  \brief  Select single channel or sequenced (autoscan) conversion of the LDC1612.
+ *  \details  Blocking; call while no background read is running.
+ *  \param[in]  channelMask  LDC1612_CHx bits, both for sequenced CH0, CH1 conversion.
+ *  \return  true if the registers were written
+ **************************************************************************************************/
+bool appHwConfigFreqChannels(uint8_t channelMask);
+
+/***********************************************************************************************//**
+ *  \brief  Write the conversion settings of an acquisition profile to both LDC1612 channels.
+ *  \details  Pauses the background reads while the registers are written.
+ *  \param[in]  profile  Profile from ldcProfileGet().
+ *  \return  true if the registers were written
+ **************************************************************************************************/
+bool appHwSetFreqProfile(const ldcProfile_t *profile);
+
+/***********************************************************************************************//**
+ *  \brief  Hold or resume the background LDC1612 reads, e.g. while only the ADC window is
+ *  monitored. A read in progress is completed and discarded.
+ *  \param[in]  enable  false to hold the reads.
+ **************************************************************************************************/
+void appHwFreqSensEnable(bool enable);
 int32_t appHwReadFlash(uint32_t* MX25ID);
+
+/***********************************************************************************************//**
+ *  \brief  Run the two point ADC calibration and store the coefficients in the persistent store.
+ *  \return  true if the calibration succeeded
+ **************************************************************************************************/
+bool appHwAdcCalibrate(void);
+
+/***********************************************************************************************//**
+ *  \brief  Load stored ADC calibration coefficients, if any.
+ *  \return  true if plausible coefficients were found and applied
+ **************************************************************************************************/
+bool appHwLoadAdcCal(void);
 /** @} (end addtogroup app_hw) */
 /** @} (end addtogroup Application) */
 
@@ -0,0 +1,63 @@
+/***********************************************************************************************//**
+ * \file   app_signal.h
+ * \brief  Application external signal header file
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef APP_SIGNAL_H
+#define APP_SIGNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup app
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+   Public Macros and Definitions
+***************************************************************************************************/
+
+/** External signal bits.
+ *  Interrupt handlers raise these with gecko_external_signal(); they are delivered to
+ *  appHandleEvents() as a gecko_evt_system_external_signal event, so all processing of the
+ *  acquired data happens in the main loop. */
+
+/** One half of the ADC ping-pong buffer has been filled by LDMA. */
+#define APP_SIGNAL_ADC_HALF             (1 << 0)
+
+/** A block of scan sequences has been sorted into the per-channel ADC ring buffers. */
+#define APP_SIGNAL_ADC_SCAN             (1 << 1)
+
+/** PA0 left the ADC compare window; the single FIFO contents have been captured. */
+#define APP_SIGNAL_ADC_WINDOW           (1 << 2)
+
+/** An LDC1612 conversion has been read after its INTB data ready edge. */
+#define APP_SIGNAL_LDC_DATA             (1 << 3)
+
+/** A Si7013 measurement read has finished, see si7013AsyncGetResult(). */
+#define APP_SIGNAL_SI7013_DATA          (1 << 4)
+
+/** An LDC1612 read sequence was abandoned after repeated I2C errors, see ldcAsyncResume(). */
+#define APP_SIGNAL_LDC_STALL            (1 << 5)
+
+/** @} (end addtogroup app) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* APP_SIGNAL_H */
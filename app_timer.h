@@ -51,6 +51,16 @@ typedef enum {
    *  This is an auto-reload timer used for timing temperature measurements. */
   TEMP_TIMER,
   MEAS_TIMER,
+  /** Notification retry timer.
+   *  This is a single-shot timer armed for the next connection event while notifications wait
+   *  for TX buffers. */
+  NOTIFY_TIMER,
+  /** LDC1612 read retry timer.
+   *  This is a single-shot timer armed when a read sequence was abandoned after I2C errors. */
+  LDC_TIMER,
+  /** Stream deadline timer.
+   *  This is a single-shot timer armed for the oldest partly filled stream frame. */
+  STREAM_TIMER,
   /** Display Polarity Inversion Timer
   * Timer for toggling the the EXTCOMIN signal, which prevents building up a DC bias
      within the Sharp memory LCD panel */
@@ -0,0 +1,246 @@
+/***********************************************************************************************//**
+ * \file   conn.c
+ * \brief  Per connection link parameters
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+/* BG stack headers */
+#include "bg_types.h"
+#include "native_gecko.h"
+
+/* Own header */
+#include "conn.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup conn
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+static connInfo_t connTable[MAX_CONNECTIONS];
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static connInfo_t *connFind(uint8_t connection);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+void connInit(void)
+{
+  memset(connTable, 0, sizeof(connTable));
+
+  /* With a maximum above 23 the stack exchanges the MTU by itself once connected */
+  gecko_cmd_gatt_set_max_mtu(CONN_MAX_MTU);
+}
+
+void connOpened(uint8_t connection)
+{
+  connInfo_t *info = connFind(connection);
+
+  if (info == NULL) {
+    info = connFind(0);
+    if (info == NULL) {
+      return;
+    }
+  }
+  info->connection = connection;
+  info->phy = CONN_PHY_1M;
+  info->mtu = CONN_DEFAULT_MTU;
+  info->txSize = CONN_DEFAULT_TX_SIZE;
+  info->interval = 0;
+  info->latency = 0;
+  info->timeout = 0;
+  info->reqInterval = 0;
+  info->reqLatency = 0;
+  info->subscriptions = 0;
+
+  /* Halves the air time of every packet. Fails on radios without 2M, the link then stays 1M. */
+  gecko_cmd_le_connection_set_phy(connection, CONN_PHY_2M);
+}
+
+void connClosed(uint8_t connection)
+{
+  connInfo_t *info = connFind(connection);
+
+  if (info != NULL) {
+    info->connection = 0;
+  }
+}
+
+void connMtuExchanged(uint8_t connection, uint16_t mtu)
+{
+  connInfo_t *info = connFind(connection);
+
+  if (info != NULL) {
+    info->mtu = mtu;
+  }
+}
+
+void connParameters(uint8_t connection, uint16_t interval, uint16_t latency, uint16_t timeout,
+                    uint16_t txSize)
+{
+  connInfo_t *info = connFind(connection);
+
+  if (info != NULL) {
+    info->interval = interval;
+    info->latency = latency;
+    info->timeout = timeout;
+    info->txSize = txSize;
+  }
+}
+
+void connPhyStatus(uint8_t connection, uint8_t phy)
+{
+  connInfo_t *info = connFind(connection);
+
+  if (info != NULL) {
+    info->phy = phy;
+  }
+}
+
+void connRequestRate(uint8_t connection, uint32_t notifyPeriodMs)
+{
+  connInfo_t *info;
+  uint16_t minInterval, maxInterval, latency, timeout;
+
+  if (connection == 0) {
+    return;
+  }
+  info = connFind(connection);
+  if (info == NULL) {
+    return;
+  }
+
+  if (notifyPeriodMs == 0) {
+    minInterval = CONN_IDLE_INTERVAL_MIN;
+    maxInterval = CONN_IDLE_INTERVAL_MAX;
+    latency = CONN_IDLE_LATENCY;
+    timeout = CONN_IDLE_TIMEOUT;
+  } else {
+    /* ms to 1.25 ms units */
+    maxInterval = (notifyPeriodMs > ((CONN_ACTIVE_INTERVAL_MAX * 5) / 4))
+                  ? CONN_ACTIVE_INTERVAL_MAX : (uint16_t)((notifyPeriodMs * 4) / 5);
+    if (maxInterval < CONN_ACTIVE_INTERVAL_MIN) {
+      maxInterval = CONN_ACTIVE_INTERVAL_MIN;
+    }
+    minInterval = CONN_ACTIVE_INTERVAL_MIN;
+    latency = 0;
+    timeout = CONN_ACTIVE_TIMEOUT;
+  }
+
+  if ((info->reqInterval == maxInterval) && (info->reqLatency == latency)) {
+    return;
+  }
+  info->reqInterval = maxInterval;
+  info->reqLatency = latency;
+  gecko_cmd_le_connection_set_parameters(connection, minInterval, maxInterval, latency, timeout);
+}
+
+void connSetSubscription(uint8_t connection, uint8_t mask, bool enable)
+{
+  connInfo_t *info;
+
+  if (connection == 0) {
+    return;
+  }
+  info = connFind(connection);
+  if (info == NULL) {
+    return;
+  }
+  if (enable) {
+    info->subscriptions |= mask;
+  } else {
+    info->subscriptions &= (uint8_t)~mask;
+  }
+}
+
+uint8_t connSubscribed(uint8_t mask)
+{
+  uint32_t i;
+  uint8_t n = 0;
+
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    if ((connTable[i].connection != 0) && (connTable[i].subscriptions & mask)) {
+      n++;
+    }
+  }
+  return n;
+}
+
+uint8_t connCount(void)
+{
+  uint32_t i;
+  uint8_t n = 0;
+
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    if (connTable[i].connection != 0) {
+      n++;
+    }
+  }
+  return n;
+}
+
+const connInfo_t *connAt(uint32_t index)
+{
+  if ((index >= MAX_CONNECTIONS) || (connTable[index].connection == 0)) {
+    return NULL;
+  }
+  return &connTable[index];
+}
+
+const connInfo_t *connGet(uint8_t connection)
+{
+  if (connection == 0) {
+    return NULL;
+  }
+  return connFind(connection);
+}
+
+uint16_t connPayloadLen(uint8_t connection)
+{
+  const connInfo_t *info = connGet(connection);
+
+  return (uint16_t)(((info != NULL) ? info->mtu : CONN_DEFAULT_MTU) - 3);
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Find the entry of a connection, or a free entry when called with 0.
+ **************************************************************************************************/
+static connInfo_t *connFind(uint8_t connection)
+{
+  uint32_t i;
+
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    if (connTable[i].connection == connection) {
+      return &connTable[i];
+    }
+  }
+  return NULL;
+}
+
+/** @} (end addtogroup conn) */
+/** @} (end addtogroup Application) */
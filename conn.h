@@ -0,0 +1,187 @@
+/***********************************************************************************************//**
+ * \file   conn.h
+ * \brief  Per connection link parameters
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef CONN_H
+#define CONN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup conn Connections
+ * \brief Negotiates and tracks ATT MTU, data length, PHY and subscriptions of every connection.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup conn
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/** Simultaneous connections, also sizes the stack heap in main.c. */
+#ifndef MAX_CONNECTIONS
+#define MAX_CONNECTIONS                 4
+#endif
+
+/** Largest ATT MTU offered to clients. 247 fills one 251 byte LL PDU with DLE. */
+#define CONN_MAX_MTU                    247
+
+/** ATT MTU before the exchange, from the Bluetooth core specification. */
+#define CONN_DEFAULT_MTU                23
+
+/** LL payload before a data length update. */
+#define CONN_DEFAULT_TX_SIZE            27
+
+/** PHY values of le_connection_set_phy and le_connection_phy_status. */
+#define CONN_PHY_1M                     1
+#define CONN_PHY_2M                     2
+
+/** Characteristics a connection has enabled notifications or indications of,
+ *  connInfo_t.subscriptions bits. */
+#define CONN_SUB_HRM                    (1 << 0)    /* Heart Rate Measurement */
+#define CONN_SUB_STREAM                 (1 << 1)    /* Sensor Stream */
+#define CONN_SUB_SPECTRUM               (1 << 2)    /* Sensor Spectrum */
+#define CONN_SUB_TEMP                   (1 << 3)    /* Temperature Measurement, indicated */
+#define CONN_SUB_CHANNELS               (1 << 4)    /* Sensor Channels */
+#define CONN_SUB_EXCURSION              (1 << 5)    /* Sensor Excursion */
+
+/** Connection parameters requested by connRequestRate(). Intervals in 1.25 ms units, timeouts in
+ *  10 ms units. The supervision timeout has to exceed 2 * (1 + latency) * interval. */
+#define CONN_ACTIVE_INTERVAL_MIN        6           /* 7.5 ms, the shortest allowed */
+#define CONN_ACTIVE_INTERVAL_MAX        80          /* 100 ms */
+#define CONN_ACTIVE_TIMEOUT             200         /* 2 s */
+#define CONN_IDLE_INTERVAL_MIN          80          /* 100 ms */
+#define CONN_IDLE_INTERVAL_MAX          160         /* 200 ms */
+#define CONN_IDLE_LATENCY               4           /* Up to 1 s between connection events */
+#define CONN_IDLE_TIMEOUT               500         /* 5 s */
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** Link parameters of one connection. */
+typedef struct {
+  uint8_t connection;                   /**< Connection handle, 0 if the entry is free */
+  uint8_t phy;                          /**< CONN_PHY_xx */
+  uint16_t mtu;                         /**< ATT MTU */
+  uint16_t txSize;                      /**< LL TX payload in bytes */
+  uint16_t interval;                    /**< Connection interval, 1.25 ms units */
+  uint16_t latency;                     /**< Slave latency, in connection intervals */
+  uint16_t timeout;                     /**< Supervision timeout, 10 ms units */
+  uint16_t reqInterval;                 /**< Maximum interval last requested, 0 if none */
+  uint16_t reqLatency;                  /**< Slave latency last requested */
+  uint8_t subscriptions;                /**< CONN_SUB_xx */
+} connInfo_t;
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Forget all connections and offer CONN_MAX_MTU in the MTU exchange.
+ **************************************************************************************************/
+void connInit(void);
+
+/***********************************************************************************************//**
+ *  \brief  Start tracking a new connection and ask for the 2M PHY.
+ *  \param[in]  connection  Connection handle.
+ **************************************************************************************************/
+void connOpened(uint8_t connection);
+
+/***********************************************************************************************//**
+ *  \brief  Stop tracking a connection.
+ *  \param[in]  connection  Connection handle.
+ **************************************************************************************************/
+void connClosed(uint8_t connection);
+
+/***********************************************************************************************//**
+ *  \brief  Record the result of the MTU exchange.
+ **************************************************************************************************/
+void connMtuExchanged(uint8_t connection, uint16_t mtu);
+
+/***********************************************************************************************//**
+ *  \brief  Record new connection parameters, including the data length.
+ **************************************************************************************************/
+void connParameters(uint8_t connection, uint16_t interval, uint16_t latency, uint16_t timeout,
+                    uint16_t txSize);
+
+/***********************************************************************************************//**
+ *  \brief  Record a PHY change.
+ **************************************************************************************************/
+void connPhyStatus(uint8_t connection, uint8_t phy);
+
+/***********************************************************************************************//**
+ *  \brief  Fit the connection parameters to the traffic of a connection.
+ *  \details  With notifications every notifyPeriodMs the interval is kept below that period, so
+ *  every notification leaves at the next connection event. Without regular traffic the interval
+ *  is long and the slave may skip events. Nothing is sent if the request does not change.
+ *  \param[in]  connection  Connection handle.
+ *  \param[in]  notifyPeriodMs  Time between notifications, 0 when idle or reporting by exception.
+ **************************************************************************************************/
+void connRequestRate(uint8_t connection, uint32_t notifyPeriodMs);
+
+/***********************************************************************************************//**
+ *  \brief  Record that a connection enabled or disabled notifications.
+ *  \param[in]  connection  Connection handle.
+ *  \param[in]  mask  CONN_SUB_xx.
+ *  \param[in]  enable  true if enabled.
+ **************************************************************************************************/
+void connSetSubscription(uint8_t connection, uint8_t mask, bool enable);
+
+/***********************************************************************************************//**
+ *  \brief  Number of connections subscribed to any of mask.
+ **************************************************************************************************/
+uint8_t connSubscribed(uint8_t mask);
+
+/***********************************************************************************************//**
+ *  \brief  Number of open connections.
+ **************************************************************************************************/
+uint8_t connCount(void);
+
+/***********************************************************************************************//**
+ *  \brief  Walk the connection table.
+ *  \param[in]  index  0 to MAX_CONNECTIONS - 1.
+ *  \return  Link parameters of the connection in that entry, NULL if the entry is free.
+ **************************************************************************************************/
+const connInfo_t *connAt(uint32_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Look up a connection.
+ *  \param[in]  connection  Connection handle.
+ *  \return  Its link parameters, or NULL if it is not open.
+ **************************************************************************************************/
+const connInfo_t *connGet(uint8_t connection);
+
+/***********************************************************************************************//**
+ *  \brief  Largest notification payload of a connection, ATT MTU minus the 3 byte header.
+ **************************************************************************************************/
+uint16_t connPayloadLen(uint8_t connection);
+
+/** @} (end addtogroup conn) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* CONN_H */
@@ -0,0 +1,81 @@
+/*
+ * deadband.h
+ *
+ *  Report by exception: a value is reported when it has moved more than a
+ *  threshold from the value last reported, or when the last report is older
+ *  than the heartbeat interval so the receiver knows the sender is alive.
+ *  Times are in any unit that wraps at 2^32, like the RTCC counter.
+ *  Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef DEADBAND_H_
+#define DEADBAND_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+  uint32_t threshold;           /* Change that is reported, 0 reports every value */
+  uint32_t heartbeat;           /* Longest time between reports */
+  int32_t last;                 /* Value last reported */
+  uint32_t lastTime;            /* Time of the last report */
+  bool valid;                   /* false until the first report */
+} deadband_t;
+
+/**************************************************************************//**
+ * @brief Configure a deadband, the next value is reported.
+ * @param[in] threshold
+ *   A value is reported once |value - last reported| exceeds it, 0 to report
+ *   every value.
+ * @param[in] heartbeat
+ *   Longest time between reports.
+ *****************************************************************************/
+static inline void deadbandInit(deadband_t *db, uint32_t threshold, uint32_t heartbeat)
+{
+  db->threshold = threshold;
+  db->heartbeat = heartbeat;
+  db->last = 0;
+  db->lastTime = 0;
+  db->valid = false;
+}
+
+/**************************************************************************//**
+ * @brief Report the next value regardless of its change, for example for a
+ *   new receiver.
+ *****************************************************************************/
+static inline void deadbandRestart(deadband_t *db)
+{
+  db->valid = false;
+}
+
+/**************************************************************************//**
+ * @brief Whether values are filtered at all.
+ *****************************************************************************/
+static inline bool deadbandActive(const deadband_t *db)
+{
+  return db->threshold != 0;
+}
+
+/**************************************************************************//**
+ * @brief Decide whether to report a value and remember it if so.
+ * @param[in] force
+ *   Report regardless of the value, for example when a status changed.
+ * @return
+ *   true if the value is to be reported.
+ *****************************************************************************/
+static inline bool deadbandCheck(deadband_t *db, int32_t value, uint32_t now, bool force)
+{
+  uint32_t change = (uint32_t)((value > db->last) ? (value - db->last) : (db->last - value));
+
+  if (!force && db->valid && (db->threshold != 0) && (change <= db->threshold)
+      && ((now - db->lastTime) < db->heartbeat))
+  {
+    return false;
+  }
+  db->last = value;
+  db->lastTime = now;
+  db->valid = true;
+  return true;
+}
+
+#endif /* DEADBAND_H_ */
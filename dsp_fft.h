@@ -0,0 +1,253 @@
+/*
+ * dsp_fft.h
+ *
+ *  q15 real FFT for spectral summaries: a radix-2 complex FFT of N / 2
+ *  points over the even and odd samples, then the split into the N / 2 + 1
+ *  bins of the real input, the same scheme as arm_rfft_q15() of CMSIS-DSP.
+ *  Every stage halves, so the bins come out divided by N and cannot
+ *  overflow for inputs within +-2^14. Also the Hann window, the power per
+ *  bin and a log2 for levels. Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef DSP_FFT_H_
+#define DSP_FFT_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Transform lengths, limited by the resolution of the sine table */
+#define DSP_FFT_MIN_LEN         16
+#define DSP_FFT_MAX_LEN         128
+
+/* Largest input magnitude that cannot overflow */
+#define DSP_FFT_INPUT_MAX       ((1 << 14) - 1)
+
+/* sin(2 pi i / 256) in q15 for i = 0..64 */
+static const int16_t dspFftSinTable[65] =
+{
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+  6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767,
+};
+
+/**************************************************************************//**
+ * @brief sin(2 pi i / 256) in q15 for any i.
+ *****************************************************************************/
+static inline int32_t dspFftSin(uint32_t i)
+{
+  i &= 255;
+  if (i <= 64)
+  {
+    return dspFftSinTable[i];
+  }
+  if (i <= 128)
+  {
+    return dspFftSinTable[128 - i];
+  }
+  if (i <= 192)
+  {
+    return -dspFftSinTable[i - 128];
+  }
+  return -dspFftSinTable[256 - i];
+}
+
+/**************************************************************************//**
+ * @brief cos(2 pi i / 256) in q15 for any i.
+ *****************************************************************************/
+static inline int32_t dspFftCos(uint32_t i)
+{
+  return dspFftSin(i + 64);
+}
+
+/**************************************************************************//**
+ * @brief Check a transform length.
+ *****************************************************************************/
+static inline bool dspFftLenValid(uint32_t n)
+{
+  return (n >= DSP_FFT_MIN_LEN) && (n <= DSP_FFT_MAX_LEN) && ((n & (n - 1)) == 0);
+}
+
+/**************************************************************************//**
+ * @brief Hann window coefficient, sin^2(pi i / n) in q15.
+ * @param[in] n
+ *   Window length, see dspFftLenValid().
+ *****************************************************************************/
+static inline int16_t dspFftHann(uint32_t i, uint32_t n)
+{
+  int32_t s = dspFftSin((i * 128) / n);
+
+  return (int16_t)((s * s) >> 15);
+}
+
+/**************************************************************************//**
+ * @brief In place complex FFT, decimation in time, halving every stage.
+ * @param[in,out] buf
+ *   m complex values as re, im pairs, in order in and out.
+ * @param[in] m
+ *   Number of complex values, a power of 2 up to DSP_FFT_MAX_LEN / 2.
+ *****************************************************************************/
+static inline void dspCfftQ15(int16_t *buf, uint32_t m)
+{
+  uint32_t i, j, k, bit, half, step;
+  int32_t c, s, tr, ti, ar, ai;
+  int16_t t;
+
+  /* Bit reversed order */
+  for (i = 1, j = 0; i < m; i++)
+  {
+    for (bit = m >> 1; j & bit; bit >>= 1)
+    {
+      j ^= bit;
+    }
+    j |= bit;
+    if (i < j)
+    {
+      t = buf[2 * i];
+      buf[2 * i] = buf[2 * j];
+      buf[2 * j] = t;
+      t = buf[(2 * i) + 1];
+      buf[(2 * i) + 1] = buf[(2 * j) + 1];
+      buf[(2 * j) + 1] = t;
+    }
+  }
+
+  /* Butterflies with twiddle exp(-j 2 pi k / (2 half)) */
+  for (half = 1; half < m; half <<= 1)
+  {
+    step = 128 / half;
+    for (k = 0; k < half; k++)
+    {
+      c = dspFftCos(k * step);
+      s = dspFftSin(k * step);
+      for (i = k; i < m; i += 2 * half)
+      {
+        j = i + half;
+        tr = ((c * buf[2 * j]) + (s * buf[(2 * j) + 1])) >> 15;
+        ti = ((c * buf[(2 * j) + 1]) - (s * buf[2 * j])) >> 15;
+        ar = buf[2 * i];
+        ai = buf[(2 * i) + 1];
+        buf[2 * i] = (int16_t)((ar + tr) >> 1);
+        buf[(2 * i) + 1] = (int16_t)((ai + ti) >> 1);
+        buf[2 * j] = (int16_t)((ar - tr) >> 1);
+        buf[(2 * j) + 1] = (int16_t)((ai - ti) >> 1);
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @brief One bin of the split step, X[k] / 2 from Z[k] and conj(Z[m - k]).
+ *****************************************************************************/
+static inline void dspRfftSplit(int32_t zr, int32_t zi, int32_t wr, int32_t wi, uint32_t k,
+                                uint32_t n, int16_t *out)
+{
+  int32_t er = zr + wr;                 /* 2 E, even samples */
+  int32_t ei = zi - wi;
+  int32_t or_ = zi + wi;                /* 2 O = -j (Z[k] - conj(Z[m - k])) */
+  int32_t oi = wr - zr;
+  int32_t c = dspFftCos((k * 256) / n);
+  int32_t s = dspFftSin((k * 256) / n);
+
+  out[0] = (int16_t)((er + (((c * or_) + (s * oi)) >> 15)) >> 2);
+  out[1] = (int16_t)((ei + (((c * oi) - (s * or_)) >> 15)) >> 2);
+}
+
+/**************************************************************************//**
+ * @brief In place real FFT.
+ * @param[in,out] buf
+ *   n real samples within +-DSP_FFT_INPUT_MAX in, n / 2 + 1 bins X[k] / n as
+ *   re, im pairs out, so buf holds n + 2 values.
+ * @param[in] n
+ *   Transform length, see dspFftLenValid().
+ *****************************************************************************/
+static inline void dspRfftQ15(int16_t *buf, uint32_t n)
+{
+  uint32_t m = n / 2;
+  uint32_t k;
+  int32_t ar, ai, br, bi;
+  int16_t x[2];
+
+  /* x[2i] + j x[2i + 1] as m complex values, transformed */
+  dspCfftQ15(buf, m);
+
+  /* DC and Nyquist from Z[0] */
+  ar = buf[0];
+  ai = buf[1];
+  buf[0] = (int16_t)((ar + ai) >> 1);
+  buf[1] = 0;
+  buf[2 * m] = (int16_t)((ar - ai) >> 1);
+  buf[(2 * m) + 1] = 0;
+
+  /* Bins k and m - k from Z[k] and Z[m - k] */
+  for (k = 1; k <= m / 2; k++)
+  {
+    ar = buf[2 * k];
+    ai = buf[(2 * k) + 1];
+    br = buf[2 * (m - k)];
+    bi = buf[(2 * (m - k)) + 1];
+    dspRfftSplit(ar, ai, br, bi, k, n, x);
+    if (k != m - k)
+    {
+      dspRfftSplit(br, bi, ar, ai, m - k, n, &buf[2 * (m - k)]);
+    }
+    buf[2 * k] = x[0];
+    buf[(2 * k) + 1] = x[1];
+  }
+}
+
+/**************************************************************************//**
+ * @brief Power of bin k of dspRfftQ15() output, re^2 + im^2.
+ *****************************************************************************/
+static inline uint32_t dspFftPower(const int16_t *buf, uint32_t k)
+{
+  int32_t re = buf[2 * k];
+  int32_t im = buf[(2 * k) + 1];
+
+  return (uint32_t)(re * re) + (uint32_t)(im * im);
+}
+
+/**************************************************************************//**
+ * @brief log2(x) in Q8, 0 for x = 0.
+ *****************************************************************************/
+static inline int32_t dspLog2Q8(uint64_t x)
+{
+  int32_t result = 0;
+  uint32_t mant, i;
+
+  if (x == 0)
+  {
+    return 0;
+  }
+  while (x >= (1ULL << 32))
+  {
+    x >>= 1;
+    result += 256;
+  }
+  mant = (uint32_t)x;
+  while (mant < 0x80000000UL)
+  {
+    mant <<= 1;
+    result -= 256;
+  }
+  result += 31 * 256;
+
+  /* Fraction bit by bit: squaring a mantissa in [1, 2) crosses 2 when the next bit is 1 */
+  mant >>= 16;                          /* [1, 2) in Q15 */
+  for (i = 0; i < 8; i++)
+  {
+    mant = (mant * mant) >> 15;
+    if (mant >= 0x10000)
+    {
+      mant >>= 1;
+      result += 128 >> i;
+    }
+  }
+  return result;
+}
+
+#endif /* DSP_FFT_H_ */
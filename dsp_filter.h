@@ -0,0 +1,209 @@
+/*
+ * dsp_filter.h
+ *
+ *  Sample by sample q31 filter kernels: direct form I biquad cascade, FIR
+ *  and a running median for spike rejection. Coefficient layout, sign
+ *  convention and postShift follow arm_biquad_cascade_df1_q31() and
+ *  arm_fir_q31() of CMSIS-DSP, so the tables work with either.
+ *  Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef DSP_FILTER_H_
+#define DSP_FILTER_H_
+#include <stdint.h>
+
+/* Kernel sizes */
+#define DSP_BIQUAD_MAX_STAGES   2
+#define DSP_FIR_MAX_TAPS        16
+#define DSP_MEDIAN_MAX          5
+
+/* Biquad cascade. Per stage the coefficients are {b0, b1, b2, a1, a2},
+ * scaled by 2^-postShift, with
+ * y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2],
+ * that is the feedback coefficients negated against the usual notation. */
+typedef struct
+{
+  const int32_t *coeffs;
+  uint8_t numStages;                    /* 0 passes samples through */
+  uint8_t postShift;
+  int32_t state[4 * DSP_BIQUAD_MAX_STAGES];  /* x[n-1], x[n-2], y[n-1], y[n-2] per stage */
+} dspBiquadQ31_t;
+
+/* FIR, coefficients in q31 in time order h[0] first */
+typedef struct
+{
+  const int32_t *coeffs;
+  uint8_t numTaps;                      /* 0 passes samples through */
+  uint8_t pos;                          /* Where the next input goes */
+  int32_t state[DSP_FIR_MAX_TAPS];
+} dspFirQ31_t;
+
+/* Running median of the last len inputs */
+typedef struct
+{
+  uint8_t len;                          /* Odd, 1 passes samples through */
+  uint8_t pos;
+  uint8_t fill;
+  int32_t hist[DSP_MEDIAN_MAX];
+} dspMedian_t;
+
+/**************************************************************************//**
+ * @brief Saturate a 64 bit accumulator to q31.
+ *****************************************************************************/
+static inline int32_t dspSatQ31(int64_t acc)
+{
+  if (acc > INT32_MAX)
+  {
+    return INT32_MAX;
+  }
+  if (acc < INT32_MIN)
+  {
+    return INT32_MIN;
+  }
+  return (int32_t)acc;
+}
+
+/**************************************************************************//**
+ * @brief Reset a biquad cascade.
+ * @param[in] numStages
+ *   Second order sections, limited to DSP_BIQUAD_MAX_STAGES.
+ * @param[in] coeffs
+ *   5 * numStages coefficients, kept by reference.
+ * @param[in] postShift
+ *   Coefficient scaling, 1 allows feedback coefficients up to 2.
+ *****************************************************************************/
+static inline void dspBiquadQ31Init(dspBiquadQ31_t *bq, uint32_t numStages, const int32_t *coeffs,
+                                    uint32_t postShift)
+{
+  uint32_t i;
+
+  bq->coeffs = coeffs;
+  bq->numStages = (uint8_t)((numStages > DSP_BIQUAD_MAX_STAGES) ? DSP_BIQUAD_MAX_STAGES : numStages);
+  bq->postShift = (uint8_t)postShift;
+  for (i = 0; i < (4 * DSP_BIQUAD_MAX_STAGES); i++)
+  {
+    bq->state[i] = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Filter one sample through the cascade.
+ *****************************************************************************/
+static inline int32_t dspBiquadQ31(dspBiquadQ31_t *bq, int32_t x)
+{
+  const int32_t *c = bq->coeffs;
+  int32_t *s = bq->state;
+  int64_t acc;
+  int32_t y;
+  uint32_t stage;
+
+  for (stage = 0; stage < bq->numStages; stage++, c += 5, s += 4)
+  {
+    acc = ((int64_t)c[0] * x) + ((int64_t)c[1] * s[0]) + ((int64_t)c[2] * s[1])
+          + ((int64_t)c[3] * s[2]) + ((int64_t)c[4] * s[3]);
+    y = dspSatQ31(acc >> (31 - bq->postShift));
+    s[1] = s[0];
+    s[0] = x;
+    s[3] = s[2];
+    s[2] = y;
+    x = y;
+  }
+  return x;
+}
+
+/**************************************************************************//**
+ * @brief Reset a FIR filter.
+ * @param[in] numTaps
+ *   Filter length, limited to DSP_FIR_MAX_TAPS.
+ * @param[in] coeffs
+ *   numTaps coefficients, kept by reference.
+ *****************************************************************************/
+static inline void dspFirQ31Init(dspFirQ31_t *fir, uint32_t numTaps, const int32_t *coeffs)
+{
+  uint32_t i;
+
+  fir->coeffs = coeffs;
+  fir->numTaps = (uint8_t)((numTaps > DSP_FIR_MAX_TAPS) ? DSP_FIR_MAX_TAPS : numTaps);
+  fir->pos = 0;
+  for (i = 0; i < DSP_FIR_MAX_TAPS; i++)
+  {
+    fir->state[i] = 0;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Filter one sample.
+ *****************************************************************************/
+static inline int32_t dspFirQ31(dspFirQ31_t *fir, int32_t x)
+{
+  int64_t acc = 0;
+  uint32_t k, i;
+
+  if (fir->numTaps == 0)
+  {
+    return x;
+  }
+  fir->state[fir->pos] = x;
+
+  /* h[0] meets the newest input */
+  i = fir->pos;
+  for (k = 0; k < fir->numTaps; k++)
+  {
+    acc += (int64_t)fir->coeffs[k] * fir->state[i];
+    i = (i == 0) ? (uint32_t)(fir->numTaps - 1) : (i - 1);
+  }
+  fir->pos = (uint8_t)((fir->pos + 1 == fir->numTaps) ? 0 : (fir->pos + 1));
+  return dspSatQ31(acc >> 31);
+}
+
+/**************************************************************************//**
+ * @brief Reset a running median.
+ * @param[in] len
+ *   Window, made odd and limited to DSP_MEDIAN_MAX.
+ *****************************************************************************/
+static inline void dspMedianInit(dspMedian_t *med, uint32_t len)
+{
+  if (len > DSP_MEDIAN_MAX)
+  {
+    len = DSP_MEDIAN_MAX;
+  }
+  med->len = (uint8_t)((len == 0) ? 1 : (len | 1));
+  med->pos = 0;
+  med->fill = 0;
+}
+
+/**************************************************************************//**
+ * @brief Median of the last len inputs including x, delays by len / 2.
+ *   Until the window has filled the median of the inputs so far.
+ *****************************************************************************/
+static inline int32_t dspMedian(dspMedian_t *med, int32_t x)
+{
+  int32_t sorted[DSP_MEDIAN_MAX];
+  int32_t v;
+  uint32_t i, j;
+
+  if (med->len <= 1)
+  {
+    return x;
+  }
+  med->hist[med->pos] = x;
+  med->pos = (uint8_t)((med->pos + 1 == med->len) ? 0 : (med->pos + 1));
+  if (med->fill < med->len)
+  {
+    med->fill++;
+  }
+
+  /* Insertion sort, at most DSP_MEDIAN_MAX values */
+  for (i = 0; i < med->fill; i++)
+  {
+    v = med->hist[i];
+    for (j = i; (j > 0) && (sorted[j - 1] > v); j--)
+    {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = v;
+  }
+  return sorted[med->fill / 2];
+}
+
+#endif /* DSP_FILTER_H_ */
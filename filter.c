@@ -0,0 +1,209 @@
+/***********************************************************************************************//**
+ * \file   filter.c
+ * \brief  Filtering of the acquired ADC and LDC1612 samples
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "em_device.h"
+
+/* application specific files */
+#include "dsp_filter.h"
+
+/* Own header */
+#include "filter.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup filter
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Macros and Definitions
+ **************************************************************************************************/
+
+/** Biquad coefficients are halved so feedback coefficients up to 2 fit into q31. */
+#define FILTER_POST_SHIFT               1
+
+/** Mid scale of a LDC1612 code shifted to q31, and the largest code. */
+#define FILTER_LDC_OFFSET               0x40000000L
+#define FILTER_LDC_MAX                  0x0FFFFFFFUL
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** Filter state of one channel. */
+typedef struct {
+  dspMedian_t median;
+  dspBiquadQ31_t biquad;
+  dspFirQ31_t fir;
+} filterChannel_t;
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+/* Butterworth low pass, 2nd order at fs / 10. {b0, b1, b2, -a1, -a2} / 2. */
+static const int32_t filterIir2Coeffs[5] = {
+  72429549, 144859098, 72429549, 1227265970, -443242341
+};
+
+/* Butterworth low pass, 4th order at fs / 20, as two sections. */
+static const int32_t filterIir4Coeffs[10] = {
+  20440642, 40881285, 20440642, 1588788093, -596808838,
+  23497607, 46995214, 23497607, 1826396550, -846645154
+};
+
+/* Linear phase low pass, 15 taps, Hamming windowed sinc at fs / 8, unity gain at DC. */
+static const int32_t filterFir15Coeffs[15] = {
+  -5535346, -14333369, -24526606, 0, 103707424, 283166010, 462278908, 537969606,
+  462278908, 283166010, 103707424, 0, -24526606, -14333369, -5535346
+};
+
+static const filterSet_t filterSets[FILTER_SETS] = {
+  { "off",          1, 0, 0,  NULL },
+  { "median 3",     3, 0, 0,  NULL },
+  { "IIR2 fs/10",   3, 1, 0,  filterIir2Coeffs },   /* 10 Hz at 100 Hz */
+  { "IIR4 fs/20",   5, 2, 0,  filterIir4Coeffs },   /* 5 Hz at 100 Hz, strongest smoothing */
+  { "FIR15 fs/8",   3, 0, 15, filterFir15Coeffs }   /* 12.5 Hz at 100 Hz, 7 samples delay */
+};
+
+static filterChannel_t filterChannels[FILTER_CHANNELS];
+static uint8_t filterSelected = FILTER_SET_DEFAULT;
+static filterCycleStats_t filterCycleStats;
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static int32_t filterRun(uint32_t channel, int32_t x);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+const filterSet_t *filterSetGet(uint8_t index)
+{
+  if (index >= FILTER_SETS) {
+    return NULL;
+  }
+  return &filterSets[index];
+}
+
+bool filterSelect(uint8_t index)
+{
+  if (index >= FILTER_SETS) {
+    return false;
+  }
+  filterSelected = index;
+  filterReset();
+  filterResetCycleStats();
+  return true;
+}
+
+uint8_t filterGetSelected(void)
+{
+  return filterSelected;
+}
+
+void filterReset(void)
+{
+  const filterSet_t *set = &filterSets[filterSelected];
+  uint32_t ch;
+
+  for (ch = 0; ch < FILTER_CHANNELS; ch++) {
+    dspMedianInit(&filterChannels[ch].median, set->medianLen);
+    dspBiquadQ31Init(&filterChannels[ch].biquad, set->numStages, set->coeffs, FILTER_POST_SHIFT);
+    dspFirQ31Init(&filterChannels[ch].fir, set->numTaps, set->coeffs);
+  }
+}
+
+uint16_t filterAdc(uint16_t sample)
+{
+  int32_t y;
+
+  if (filterSelected == FILTER_SET_OFF) {
+    return sample;
+  }
+
+  /* Offset binary to q31 and back */
+  y = filterRun(FILTER_CH_ADC, ((int32_t)sample - 32768) * 65536);
+  return (uint16_t)(((uint32_t)y + 0x80000000UL) >> 16);
+}
+
+uint32_t filterLdc(uint32_t channel, uint32_t code)
+{
+  int32_t y;
+
+  if ((filterSelected == FILTER_SET_OFF) || (channel > 1)) {
+    return code;
+  }
+
+  /* 28 bit code to q31 around 0, with one bit of headroom for overshoot, and back */
+  y = filterRun(FILTER_CH_LDC0 + channel, (int32_t)(code << 3) - FILTER_LDC_OFFSET);
+  if (y < -FILTER_LDC_OFFSET) {
+    return 0;
+  }
+  if (y >= FILTER_LDC_OFFSET) {
+    return FILTER_LDC_MAX;
+  }
+  return (uint32_t)(y + FILTER_LDC_OFFSET) >> 3;
+}
+
+void filterGetCycleStats(filterCycleStats_t *stats)
+{
+  *stats = filterCycleStats;
+}
+
+void filterResetCycleStats(void)
+{
+  memset(&filterCycleStats, 0, sizeof(filterCycleStats));
+  filterCycleStats.min = UINT32_MAX;
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Run a q31 sample through the median and the IIR or FIR of a channel.
+ *  \details  Counts the cycles spent with the DWT cycle counter enabled by adcInit().
+ **************************************************************************************************/
+static int32_t filterRun(uint32_t channel, int32_t x)
+{
+  filterChannel_t *state = &filterChannels[channel];
+  uint32_t start = DWT->CYCCNT;
+  uint32_t cycles;
+
+  x = dspMedian(&state->median, x);
+  x = dspBiquadQ31(&state->biquad, x);
+  x = dspFirQ31(&state->fir, x);
+
+  cycles = DWT->CYCCNT - start;
+  filterCycleStats.last = cycles;
+  if (cycles < filterCycleStats.min) {
+    filterCycleStats.min = cycles;
+  }
+  if (cycles > filterCycleStats.max) {
+    filterCycleStats.max = cycles;
+  }
+  filterCycleStats.total += cycles;
+  filterCycleStats.count++;
+  return x;
+}
+
+/** @} (end addtogroup filter) */
+/** @} (end addtogroup Application) */
@@ -0,0 +1,133 @@
+/***********************************************************************************************//**
+ * \file   filter.h
+ * \brief  Filtering of the acquired ADC and LDC1612 samples
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup filter Filter
+ * \brief Median, IIR and FIR filters between acquisition and the notifications.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup filter
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/** Coefficient sets. Cutoffs are relative to the sample rate of each channel. */
+#define FILTER_SETS                     5
+#define FILTER_SET_OFF                  0
+#define FILTER_SET_DEFAULT              FILTER_SET_OFF
+
+/** Filtered channels, each with its own state. */
+#define FILTER_CH_ADC                   0           /* PA0 */
+#define FILTER_CH_LDC0                  1           /* LDC1612 CH0 */
+#define FILTER_CH_LDC1                  2           /* LDC1612 CH1 */
+#define FILTER_CHANNELS                 3
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** A coefficient set. The median runs first, then the IIR or the FIR. */
+typedef struct {
+  const char *name;                     /**< Shown on the display */
+  uint8_t medianLen;                    /**< Median window, 1 for none */
+  uint8_t numStages;                    /**< Biquad sections, 0 for none */
+  uint8_t numTaps;                      /**< FIR taps, 0 for none */
+  const int32_t *coeffs;                /**< q31, see dsp_filter.h */
+} filterSet_t;
+
+/** Cycles spent per filtered sample, measured with the DWT cycle counter. */
+typedef struct {
+  uint32_t count;                       /**< Samples measured */
+  uint32_t last;                        /**< Cycles of the last sample */
+  uint32_t min;                         /**< Fewest cycles of any sample */
+  uint32_t max;                         /**< Most cycles of any sample */
+  uint64_t total;                       /**< Sum over all samples */
+} filterCycleStats_t;
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Look up a coefficient set.
+ *  \param[in]  index  Set index, 0 to FILTER_SETS - 1.
+ *  \return  The set, or NULL if it does not exist.
+ **************************************************************************************************/
+const filterSet_t *filterSetGet(uint8_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Switch all channels to a coefficient set, with cleared state.
+ *  \return  false if the set does not exist.
+ **************************************************************************************************/
+bool filterSelect(uint8_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Index of the selected coefficient set.
+ **************************************************************************************************/
+uint8_t filterGetSelected(void);
+
+/***********************************************************************************************//**
+ *  \brief  Clear the state of all channels, for example when the sample rate changed.
+ **************************************************************************************************/
+void filterReset(void);
+
+/***********************************************************************************************//**
+ *  \brief  Filter a PA0 sample.
+ *  \param[in]  sample  16 bit ADC sample.
+ *  \return  Filtered 16 bit sample.
+ **************************************************************************************************/
+uint16_t filterAdc(uint16_t sample);
+
+/***********************************************************************************************//**
+ *  \brief  Filter a LDC1612 conversion.
+ *  \param[in]  channel  0 or 1.
+ *  \param[in]  code  28 bit conversion result.
+ *  \return  Filtered 28 bit code.
+ **************************************************************************************************/
+uint32_t filterLdc(uint32_t channel, uint32_t code);
+
+/***********************************************************************************************//**
+ *  \brief  Read back the per-sample cycle counters.
+ **************************************************************************************************/
+void filterGetCycleStats(filterCycleStats_t *stats);
+
+/***********************************************************************************************//**
+ *  \brief  Clear the per-sample cycle counters.
+ **************************************************************************************************/
+void filterResetCycleStats(void);
+
+/** @} (end addtogroup filter) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* FILTER_H */
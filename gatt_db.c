@@ -52,16 +52,64 @@ GATT_DATA(const uint8_t bg_gattdb_data_uuidtable_128_map [])=
 {
 0xf0, 0x19, 0x21, 0xb4, 0x47, 0x8f, 0xa4, 0xbf, 0xa1, 0x4f, 0x63, 0xfd, 0xee, 0xd6, 0x14, 0x1d, 
 0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7, 
+0x11, 0x0a, 0x9f, 0x5e, 0x6a, 0x2b, 0x1d, 0x8c, 0x3e, 0x4f, 0x5b, 0x9a, 0x28, 0x7c, 0x0e, 0x4d, 
+0x11, 0x0a, 0x9f, 0x5e, 0x6a, 0x2b, 0x1d, 0x8c, 0x3e, 0x4f, 0x5b, 0x9a, 0x29, 0x7c, 0x0e, 0x4d, 
+0x11, 0x0a, 0x9f, 0x5e, 0x6a, 0x2b, 0x1d, 0x8c, 0x3e, 0x4f, 0x5b, 0x9a, 0x2a, 0x7c, 0x0e, 0x4d, 
+0x11, 0x0a, 0x9f, 0x5e, 0x6a, 0x2b, 0x1d, 0x8c, 0x3e, 0x4f, 0x5b, 0x9a, 0x2b, 0x7c, 0x0e, 0x4d, 
 };
 
 
 
 
-uint8_t bg_gattdb_data_attribute_field_36_data[1]={0x00,};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_47 ) = {
+	.properties=0x10,
+	.index=14,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_46 ) = {
+	.len=19,
+	.data={0x10,0x30,0x00,0x11,0x0a,0x9f,0x5e,0x6a,0x2b,0x1d,0x8c,0x3e,0x4f,0x5b,0x9a,0x2b,0x7c,0x0e,0x4d,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_44 ) = {
+	.properties=0x10,
+	.index=13,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_43 ) = {
+	.len=19,
+	.data={0x10,0x2d,0x00,0x11,0x0a,0x9f,0x5e,0x6a,0x2b,0x1d,0x8c,0x3e,0x4f,0x5b,0x9a,0x2a,0x7c,0x0e,0x4d,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_41 ) = {
+	.properties=0x10,
+	.index=12,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_40 ) = {
+	.len=19,
+	.data={0x10,0x2a,0x00,0x11,0x0a,0x9f,0x5e,0x6a,0x2b,0x1d,0x8c,0x3e,0x4f,0x5b,0x9a,0x29,0x7c,0x0e,0x4d,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_38 ) = {
+	.properties=0x10,
+	.index=11,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_37 ) = {
+	.len=19,
+	.data={0x10,0x27,0x00,0x11,0x0a,0x9f,0x5e,0x6a,0x2b,0x1d,0x8c,0x3e,0x4f,0x5b,0x9a,0x28,0x7c,0x0e,0x4d,}
+};
+uint8_t bg_gattdb_data_attribute_field_36_data[22]={0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,};
 GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_36 ) = {
 	.properties=0x08,
 	.index=10,
-	.max_len=1,
+	.max_len=20,
 	.data=bg_gattdb_data_attribute_field_36_data,
 };
 
@@ -81,11 +129,11 @@ GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_
 	.len=5,
 	.data={0x02,0x23,0x00,0x38,0x2a,}
 };
-uint8_t bg_gattdb_data_attribute_field_31_data[8]={0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,};
+uint8_t bg_gattdb_data_attribute_field_31_data[22]={0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,};
 GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_31 ) = {
 	.properties=0x10,
 	.index=8,
-	.max_len=8,
+	.max_len=20,
 	.data=bg_gattdb_data_attribute_field_31_data,
 };
 
@@ -264,12 +312,24 @@ GATT_DATA(const struct bg_gattdb_attribute bg_gattdb_data_attributes_map[])={
     {.uuid=0x8001,.permissions=0x802,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_28},
     {.uuid=0x0000,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_29},
     {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_30},
-    {.uuid=0x0010,.permissions=0x800,.caps=0xffff,.datatype=0x01,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_31},
+    {.uuid=0x0010,.permissions=0x800,.caps=0xffff,.datatype=0x02,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_31},
     {.uuid=0x0011,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x08,.clientconfig_index=0x03}},
     {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_33},
     {.uuid=0x0012,.permissions=0x801,.caps=0xffff,.datatype=0x01,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_34},
     {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_35},
-    {.uuid=0x0013,.permissions=0x802,.caps=0xffff,.datatype=0x01,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_36},
+    {.uuid=0x0013,.permissions=0x802,.caps=0xffff,.datatype=0x02,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_36},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_37},
+    {.uuid=0x8002,.permissions=0x800,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_38},
+    {.uuid=0x0011,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x0b,.clientconfig_index=0x04}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_40},
+    {.uuid=0x8003,.permissions=0x800,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_41},
+    {.uuid=0x0011,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x0c,.clientconfig_index=0x05}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_43},
+    {.uuid=0x8004,.permissions=0x800,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_44},
+    {.uuid=0x0011,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x0d,.clientconfig_index=0x06}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_46},
+    {.uuid=0x8005,.permissions=0x800,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_47},
+    {.uuid=0x0011,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x0e,.clientconfig_index=0x07}},
 };
 
 GATT_DATA(const uint16_t bg_gattdb_data_attributes_dynamic_mapping_map[])={
@@ -284,18 +344,22 @@ GATT_DATA(const uint16_t bg_gattdb_data_attributes_dynamic_mapping_map[])={
 	0x0020,
 	0x0023,
 	0x0025,
+	0x0027,
+	0x002a,
+	0x002d,
+	0x0030,
 };
 
 GATT_DATA(const uint8_t bg_gattdb_data_adv_uuid16_map[])={0x09, 0x18, 0x02, 0x18, 0x0d, 0x18, };
 GATT_DATA(const uint8_t bg_gattdb_data_adv_uuid128_map[])={0x0};
 GATT_HEADER(const struct bg_gattdb_def bg_gattdb_data)={
     .attributes=bg_gattdb_data_attributes_map,
-    .attributes_max=37,
+    .attributes_max=49,
     .uuidtable_16_size=22,
     .uuidtable_16=bg_gattdb_data_uuidtable_16_map,
-    .uuidtable_128_size=2,
+    .uuidtable_128_size=6,
     .uuidtable_128=bg_gattdb_data_uuidtable_128_map,
-    .attributes_dynamic_max=11,
+    .attributes_dynamic_max=15,
     .attributes_dynamic_mapping=bg_gattdb_data_attributes_dynamic_mapping_map,
     .adv_uuid16=bg_gattdb_data_adv_uuid16_map,
     .adv_uuid16_num=3,
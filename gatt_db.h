@@ -16,11 +16,16 @@ extern const struct bg_gattdb_def bg_gattdb_data;
 #define gattdb_service_changed_char             3
 #define gattdb_device_name                      7
 #define gattdb_temperature_measurement         15
+#define gattdb_intermediate_temperature         20
 #define gattdb_MeasInt                         23
 #define gattdb_alert_level                     26
 #define gattdb_ota_control                     29
 #define gattdb_heart_rate_measurement          32
 #define gattdb_body_sensor_location            35
 #define gattdb_heart_rate_control_point         37
+#define gattdb_sensor_stream                   39
+#define gattdb_sensor_spectrum                 42
+#define gattdb_sensor_channels                 45
+#define gattdb_sensor_excursion                48
 
 #endif
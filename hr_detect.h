@@ -0,0 +1,443 @@
+/*
+ * hr_detect.h
+ *
+ *  Streaming heart beat detector for the pulse signal on PA0. A band-pass
+ *  removes baseline drift and noise, beats are the maxima of the pulses that
+ *  cross an adaptive threshold. While no regular beats are found the rate is
+ *  taken from the autocorrelation of the last seconds instead. Integer
+ *  arithmetic only. Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef HR_DETECT_H_
+#define HR_DETECT_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Detector parameters */
+#define HR_DETECT_MIN_BPM       30
+#define HR_DETECT_MAX_BPM       220
+#define HR_DETECT_HP_DHZ        5                       /* Band-pass corners in 0.1 Hz */
+#define HR_DETECT_LP_DHZ        40
+#define HR_DETECT_MIN_AMP       (64L << 8)              /* Smallest pulse, 16 bit LSBs in Q8 */
+#define HR_DETECT_RR_TOL_LOG2   2                       /* Beats within 1/4 of the mean RR count */
+#define HR_DETECT_RELOCK        3                       /* Rejected beats in a row before relocking */
+#define HR_DETECT_LOST_S        3                       /* Seconds without a beat until unlocked */
+#define HR_DETECT_RR_MAX        9                       /* RR intervals kept until taken */
+
+/* Autocorrelation fallback, on the band-pass output decimated to about 25 Hz */
+#define HR_DETECT_ACF_HZ        25
+#define HR_DETECT_ACF_LEN       256                     /* Power of 2, 10 s at 25 Hz */
+#define HR_DETECT_ACF_MIN_Q15   16384                   /* Normalized correlation of a valid rate */
+
+/* Events of hrDetectPush() */
+#define HR_DETECT_EVT_BEAT      (1 << 0)                /* Beat accepted, RR interval queued */
+#define HR_DETECT_EVT_RATE      (1 << 1)                /* Rate estimated by autocorrelation */
+#define HR_DETECT_EVT_LOST      (1 << 2)                /* No regular beats any more */
+
+/* 2 * pi in Q15 */
+#define HR_DETECT_TWO_PI_Q15    205887L
+
+typedef struct
+{
+  /* Band-pass */
+  uint32_t rate;                        /* Input samples per second */
+  int32_t aHp, aLp;                     /* One pole coefficients in Q15 */
+  int32_t base;                         /* Baseline, input in Q8 */
+  int32_t lp[2];                        /* Two low pass poles, input in Q8 */
+  int32_t prev;                         /* Previous band-pass output */
+
+  /* Peak detection */
+  uint32_t n;                           /* Samples since hrDetectInit() */
+  int32_t env;                          /* Envelope of the accepted pulse maxima */
+  bool inPulse;
+  bool wantNext;                        /* Sample after the maximum still to come */
+  int32_t pulseMax, maxPrev, maxNext;   /* Pulse maximum and its neighbours */
+  uint32_t pulseAt;                     /* Sample index of the maximum */
+  bool haveBeat;
+  uint32_t lastBeat;                    /* Time of the previous beat in 1/16 samples */
+  uint32_t lastAccepted;                /* Sample index of the last accepted beat */
+  uint32_t rrMean;                      /* Mean RR in 1/16 samples, 0 while unlocked */
+  uint8_t rejects;
+
+  /* Autocorrelation */
+  int16_t acf[HR_DETECT_ACF_LEN];
+  uint32_t acfPos, acfFill;
+  uint32_t acfDecim, acfPhase;
+  int32_t acfSum;
+  uint32_t acfNext;                     /* Sample index of the next evaluation */
+
+  /* Results */
+  bool locked;                          /* Regular beats found */
+  bool contact;                         /* locked, or a valid autocorrelation rate */
+  uint16_t bpm;                         /* 0 if unknown */
+  uint16_t rr[HR_DETECT_RR_MAX];        /* RR intervals in 1/1024 s, oldest first */
+  uint8_t rrCount;
+} hrDetect_t;
+
+/**************************************************************************//**
+ * @brief One pole low pass coefficient, w / (1 + w) with w = 2 pi fc / fs.
+ *****************************************************************************/
+static inline int32_t hrDetectCoef(uint32_t cornerDHz, uint32_t rate)
+{
+  int32_t w = (int32_t)((HR_DETECT_TWO_PI_Q15 * (int32_t)cornerDHz) / (int32_t)(10 * rate));
+
+  return (int32_t)(((int64_t)w << 15) / (32768 + w));
+}
+
+/**************************************************************************//**
+ * @brief Reset a detector.
+ * @param[in] rate
+ *   Input samples per second.
+ *****************************************************************************/
+static inline void hrDetectInit(hrDetect_t *det, uint32_t rate)
+{
+  uint32_t i;
+  uint8_t *p = (uint8_t *)det;
+
+  for (i = 0; i < sizeof(*det); i++)
+  {
+    p[i] = 0;
+  }
+  if (rate == 0)
+  {
+    rate = 1;
+  }
+  det->rate = rate;
+  det->aHp = hrDetectCoef(HR_DETECT_HP_DHZ, rate);
+  det->aLp = hrDetectCoef(HR_DETECT_LP_DHZ, rate);
+  det->acfDecim = (rate > HR_DETECT_ACF_HZ) ? (rate / HR_DETECT_ACF_HZ) : 1;
+  det->acfNext = rate;
+}
+
+/**************************************************************************//**
+ * @brief Step of a one pole low pass in place.
+ *****************************************************************************/
+static inline int32_t hrDetectPole(int32_t *y, int32_t x, int32_t a)
+{
+  *y += (int32_t)(((int64_t)(x - *y) * a) >> 15);
+  return *y;
+}
+
+/**************************************************************************//**
+ * @brief Queue a RR interval, the oldest is dropped when full.
+ *****************************************************************************/
+static inline void hrDetectQueueRr(hrDetect_t *det, uint32_t rr16)
+{
+  uint32_t i;
+  uint32_t rr = ((rr16 * 1024) + (8 * det->rate)) / (16 * det->rate);
+
+  if (det->rrCount == HR_DETECT_RR_MAX)
+  {
+    for (i = 1; i < HR_DETECT_RR_MAX; i++)
+    {
+      det->rr[i - 1] = det->rr[i];
+    }
+    det->rrCount--;
+  }
+  det->rr[det->rrCount++] = (uint16_t)((rr > 0xFFFF) ? 0xFFFF : rr);
+}
+
+/**************************************************************************//**
+ * @brief Judge the maximum of a finished pulse.
+ * @return
+ *   HR_DETECT_EVT_BEAT if it was accepted as a beat.
+ *****************************************************************************/
+static inline uint32_t hrDetectPulse(hrDetect_t *det)
+{
+  int32_t den = det->maxPrev - (2 * det->pulseMax) + det->maxNext;
+  int32_t offs = 0;
+  uint32_t t, rr;
+  uint32_t minRr = (16 * 60 * det->rate) / HR_DETECT_MAX_BPM;
+  uint32_t maxRr = (16 * 60 * det->rate) / HR_DETECT_MIN_BPM;
+  uint32_t diff;
+
+  /* Parabola through the maximum and its neighbours, in 1/16 samples */
+  if (den < 0)
+  {
+    offs = (int32_t)(((int64_t)(det->maxPrev - det->maxNext) * 8) / den);
+    offs = (offs > 8) ? 8 : ((offs < -8) ? -8 : offs);
+  }
+  t = (det->pulseAt << 4) + (uint32_t)offs;
+
+  if (!det->haveBeat)
+  {
+    det->haveBeat = true;
+    det->lastBeat = t;
+    det->env = det->pulseMax;
+    return 0;
+  }
+  rr = t - det->lastBeat;
+  if ((rr < minRr)
+      || (det->locked && (rr < (det->rrMean - (det->rrMean >> HR_DETECT_RR_TOL_LOG2)))))
+  {
+    return 0;                           /* Dicrotic wave or noise before the next beat */
+  }
+  det->lastBeat = t;
+  det->env += (det->pulseMax - det->env) >> 2;
+
+  if (rr > maxRr)
+  {
+    det->rejects++;                     /* Missed beats in between */
+  }
+  else if (det->rrMean == 0)
+  {
+    det->rrMean = rr;
+    det->rejects = 0;
+  }
+  else
+  {
+    diff = (rr > det->rrMean) ? (rr - det->rrMean) : (det->rrMean - rr);
+    if (diff <= (det->rrMean >> HR_DETECT_RR_TOL_LOG2))
+    {
+      det->rrMean = (uint32_t)((int32_t)det->rrMean + (((int32_t)rr - (int32_t)det->rrMean) >> 2));
+      det->rejects = 0;
+      det->locked = true;
+      det->contact = true;
+      det->lastAccepted = det->n;
+      det->bpm = (uint16_t)(((16 * 60 * det->rate) + (det->rrMean / 2)) / det->rrMean);
+      hrDetectQueueRr(det, rr);
+      return HR_DETECT_EVT_BEAT;
+    }
+    det->rejects++;
+  }
+
+  if (det->rejects >= HR_DETECT_RELOCK)
+  {
+    det->rrMean = (rr > maxRr) ? 0 : rr;
+    det->rejects = 0;
+    det->locked = false;
+  }
+  return 0;
+}
+
+/**************************************************************************//**
+ * @brief Autocorrelation of the decimated history at a lag, scaled as if
+ *   all HR_DETECT_ACF_LEN products were summed.
+ *****************************************************************************/
+static inline int64_t hrDetectAcfAt(const hrDetect_t *det, uint32_t lag)
+{
+  uint32_t i, start = det->acfPos;
+  int64_t sum = 0;
+
+  for (i = 0; (i + lag) < HR_DETECT_ACF_LEN; i++)
+  {
+    sum += (int32_t)det->acf[(start + i) & (HR_DETECT_ACF_LEN - 1)]
+           * det->acf[(start + i + lag) & (HR_DETECT_ACF_LEN - 1)];
+  }
+  return (sum * HR_DETECT_ACF_LEN) / (HR_DETECT_ACF_LEN - lag);
+}
+
+/**************************************************************************//**
+ * @brief Estimate the rate from the shortest autocorrelation peak that is
+ *   nearly as strong as the strongest lag.
+ * @return
+ *   HR_DETECT_EVT_RATE if the correlation is strong enough.
+ *****************************************************************************/
+static inline uint32_t hrDetectAcf(hrDetect_t *det)
+{
+  uint32_t acfRate = det->rate / det->acfDecim;
+  uint32_t minLag = (60 * acfRate) / HR_DETECT_MAX_BPM;
+  uint32_t maxLag = (60 * acfRate) / HR_DETECT_MIN_BPM;
+  uint32_t lag, best, i;
+  int64_t r0, r, rMax = 0, rBest, rPrev, rNext, den, recent = 0;
+  int32_t offs = 0;
+  uint32_t lag16;
+
+  if (minLag < 2)
+  {
+    minLag = 2;
+  }
+  if (maxLag > (HR_DETECT_ACF_LEN / 2))
+  {
+    maxLag = HR_DETECT_ACF_LEN / 2;
+  }
+  r0 = hrDetectAcfAt(det, 0);
+  if (r0 <= 0)
+  {
+    return 0;
+  }
+
+  /* A pulse that stopped still fills most of the history, it has to be in the last second too */
+  for (i = 1; i <= acfRate; i++)
+  {
+    r = det->acf[(det->acfPos - i) & (HR_DETECT_ACF_LEN - 1)];
+    recent += r * r;
+  }
+  if ((recent * HR_DETECT_ACF_LEN * 8) < (r0 * acfRate))
+  {
+    return 0;
+  }
+  for (lag = minLag; lag <= maxLag; lag++)
+  {
+    r = hrDetectAcfAt(det, lag);
+    rMax = (r > rMax) ? r : rMax;
+  }
+
+  /* Every multiple of the period correlates nearly as well as the period itself, take the first
+   * maximum inside the range that comes close to the strongest lag */
+  rPrev = hrDetectAcfAt(det, minLag);
+  rBest = hrDetectAcfAt(det, minLag + 1);
+  for (best = minLag + 1; best < maxLag; best++)
+  {
+    rNext = hrDetectAcfAt(det, best + 1);
+    if ((rBest > rPrev) && (rBest >= rNext) && ((rBest * 5) >= (rMax * 4)))
+    {
+      break;
+    }
+    rPrev = rBest;
+    rBest = rNext;
+  }
+  if ((best == maxLag) || (rMax <= 0))
+  {
+    return 0;                           /* No maximum inside the range */
+  }
+  if ((rBest * 32768) < (r0 * HR_DETECT_ACF_MIN_Q15))
+  {
+    return 0;
+  }
+
+  rPrev = hrDetectAcfAt(det, best - 1);
+  rNext = hrDetectAcfAt(det, best + 1);
+  den = rPrev - (2 * rBest) + rNext;
+  if (den < 0)
+  {
+    offs = (int32_t)(((rPrev - rNext) * 8) / den);
+    offs = (offs > 8) ? 8 : ((offs < -8) ? -8 : offs);
+  }
+  lag16 = (best << 4) + (uint32_t)offs;
+  det->bpm = (uint16_t)(((16 * 60 * det->rate) + ((lag16 * det->acfDecim) / 2))
+                        / (lag16 * det->acfDecim));
+  det->contact = true;
+  return HR_DETECT_EVT_RATE;
+}
+
+/**************************************************************************//**
+ * @brief Push one sample through the detector.
+ * @param[in] sample
+ *   16 bit ADC sample, at the rate given to hrDetectInit().
+ * @return
+ *   HR_DETECT_EVT_xx bits.
+ *****************************************************************************/
+static inline uint32_t hrDetectPush(hrDetect_t *det, uint16_t sample)
+{
+  int32_t x = (int32_t)sample << 8;
+  int32_t y, thr, v;
+  uint32_t events = 0;
+
+  /* Band-pass: two low pass poles minus the baseline */
+  if (det->n == 0)
+  {
+    det->base = det->lp[0] = det->lp[1] = x;
+  }
+  hrDetectPole(&det->base, x, det->aHp);
+  hrDetectPole(&det->lp[0], x, det->aLp);
+  y = hrDetectPole(&det->lp[1], det->lp[0], det->aLp) - det->base;
+
+  /* Pulses cross half the envelope, which fades within seconds without beats */
+  det->env -= det->env / (int32_t)det->rate;
+  thr = det->env / 2;
+  if (thr < HR_DETECT_MIN_AMP)
+  {
+    thr = HR_DETECT_MIN_AMP;
+  }
+  if (det->wantNext)
+  {
+    det->maxNext = y;
+    det->wantNext = false;
+  }
+  if (!det->inPulse)
+  {
+    if (y > thr)
+    {
+      det->inPulse = true;
+      det->pulseMax = y;
+      det->pulseAt = det->n;
+      det->maxPrev = det->prev;
+      det->wantNext = true;
+    }
+  }
+  else if (y > det->pulseMax)
+  {
+    det->pulseMax = y;
+    det->pulseAt = det->n;
+    det->maxPrev = det->prev;
+    det->wantNext = true;
+  }
+  else if ((y < (thr / 2)) || (y < (det->pulseMax / 2)))
+  {
+    det->inPulse = false;
+    events |= hrDetectPulse(det);
+  }
+  det->prev = y;
+
+  if (det->locked && ((det->n - det->lastAccepted) > (HR_DETECT_LOST_S * det->rate)))
+  {
+    det->locked = false;
+    det->contact = false;
+    det->rrMean = 0;
+    det->bpm = 0;
+    events |= HR_DETECT_EVT_LOST;
+  }
+
+  /* Decimated history, in 16 bit LSBs */
+  det->acfSum += y >> 8;
+  if (++det->acfPhase >= det->acfDecim)
+  {
+    v = det->acfSum / (int32_t)det->acfDecim;
+    det->acf[det->acfPos] = (int16_t)((v > 32767) ? 32767 : ((v < -32768) ? -32768 : v));
+    det->acfPos = (det->acfPos + 1) & (HR_DETECT_ACF_LEN - 1);
+    if (det->acfFill < HR_DETECT_ACF_LEN)
+    {
+      det->acfFill++;
+    }
+    det->acfSum = 0;
+    det->acfPhase = 0;
+  }
+
+  /* Without regular beats, estimate the rate once per second */
+  if (!det->locked && (det->acfFill == HR_DETECT_ACF_LEN) && ((int32_t)(det->n - det->acfNext) >= 0))
+  {
+    det->acfNext = det->n + det->rate;
+    if (hrDetectAcf(det))
+    {
+      events |= HR_DETECT_EVT_RATE;
+    }
+    else if (det->contact)
+    {
+      det->contact = false;
+      det->bpm = 0;
+      events |= HR_DETECT_EVT_LOST;
+    }
+  }
+
+  det->n++;
+  return events;
+}
+
+/**************************************************************************//**
+ * @brief Take the queued RR intervals.
+ * @param[out] rr
+ *   RR intervals in 1/1024 s, oldest first.
+ * @param[in] max
+ *   Room in rr; older intervals that do not fit are dropped.
+ * @return
+ *   Number of intervals written.
+ *****************************************************************************/
+static inline uint32_t hrDetectTakeRr(hrDetect_t *det, uint16_t *rr, uint32_t max)
+{
+  uint32_t i, skip = 0;
+
+  if (det->rrCount > max)
+  {
+    skip = det->rrCount - max;
+  }
+  for (i = skip; i < det->rrCount; i++)
+  {
+    rr[i - skip] = det->rr[i];
+  }
+  i = det->rrCount - skip;
+  det->rrCount = 0;
+  return i;
+}
+
+#endif /* HR_DETECT_H_ */
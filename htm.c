@@ -14,6 +14,8 @@
 #include <stdbool.h>
 #include <time.h>
 
+#include "em_rtcc.h"
+
 /* BG stack headers */
 #include "bg_types.h"
 #include "gatt_db.h"
@@ -30,6 +32,16 @@
 
 /* Additional headers */
 #include "adc.h"
+#include "ldc1612_async.h"
+#include "ldc_conv.h"
+#include "stream.h"
+#include "conn.h"
+#include "notify.h"
+#include "hr_detect.h"
+#include "filter.h"
+#include "spectrum.h"
+#include "deadband.h"
+#include "si7013_async.h"
 
 
 /***********************************************************************************************//**
@@ -108,15 +120,141 @@
 #define ATT_DEFAULT_PAYLOAD_LEN             20
 /** Temperature measurement period in ms. */
 #define HTM_TEMP_IND_TIMEOUT               	10
+/** Si7013 measurement period in ms. */
+#define HTM_SI7013_PERIOD_MS                1000
+/** Delay before fetching a Si7013 result again when the conversion was not finished, in ms. */
+#define HTM_SI7013_RETRY_MS                 2
+/** RTCC ticks per second. */
+#define HTM_RTCC_HZ                         32768
 /** Indicates currently there is no active connection using this service. */
 #define HTM_NO_CONNECTION                   0xFF
 
-#define HTM_FREQ_VALUE_TEXT                 "CH0 Freq:\n %7lu.%1dHz\nCH1 Freq:\n %7lu.%1dHz\nret:%5d"
-#define HTM_FREQ_VALUE_TEXT_DEFAULT         "CH0 Freq:\n -------.-Hz\nCH1 Freq:\n -------.-Hz\nret:-----"
-#define HTM_FREQ_VALUE_TEXT_SIZE            (sizeof(HTM_FREQ_VALUE_TEXT_DEFAULT))
+/** Sensor frequency and coil inductance of the newest LDC1612 conversion. */
+#define HTM_LDC_TEXT \
+  "CH0 %7lu.%1lu Hz\n %lu.%03lu uH\nCH1 %7lu.%1lu Hz\n %lu.%03lu uH\n"
+#define HTM_LDC_TEXT_SIZE                   80
 #define HTM_TIME_VALUE_TEXT					"Time:%5lu\n"
 
-#define HRM_FLAG_HR_UINT_16                 0x19
+/* Heart Rate Measurement flags */
+#define HRM_FLAG_HR_UINT16                  0x01  /* Heart rate as uint16, else uint8 */
+#define HRM_FLAG_CONTACT_DETECTED           0x02
+#define HRM_FLAG_CONTACT_SUPPORTED          0x04
+#define HRM_FLAG_RR_INTERVAL                0x10  /* RR intervals in 1/1024 s follow */
+
+/** Default heart rate measurement period in ms, beats in between are sent as RR intervals. The
+ *  Measurement Interval characteristic changes it in whole seconds. */
+#define HTM_HRM_PERIOD_MS                   1000
+/** Longest Measurement Interval in s, longer ones are clamped. */
+#define HTM_MEAS_INTERVAL_MAX_S             120
+/** RR intervals that fit into one notification next to flags and a uint8 heart rate. */
+#define HTM_HRM_RR_MAX                      ((ATT_DEFAULT_PAYLOAD_LEN - 2) / 2)
+
+/* Heart Rate Control Point opcodes. 0x01 is defined by the Heart Rate profile, the others are
+ * vendor specific. Multi-byte parameters are little endian. */
+/** Reset Energy Expended. Not supported, energy expended is never reported. */
+#define HTM_CP_RESET_ENERGY_EXPENDED        0x01
+/** Start window monitoring of PA0. Parameters: low limit (mV, uint16), high limit (mV, uint16).
+ *  Excursions are notified on Sensor Excursion to the writer. */
+#define HTM_CP_MONITOR_START                0x80
+/** Move the window while monitoring. Same parameters as HTM_CP_MONITOR_START. */
+#define HTM_CP_MONITOR_WINDOW               0x81
+/** Stop window monitoring. */
+#define HTM_CP_MONITOR_STOP                 0x82
+/** Select the ADC oversampling/decimation profile. Parameter: profile index (uint8). */
+#define HTM_CP_ADC_PROFILE                  0x83
+/** Select the LDC1612 acquisition profile. Parameter: profile index (uint8). */
+#define HTM_CP_LDC_PROFILE                  0x84
+/** Set the latency deadline of batched stream frames. Parameter: ms (uint16). */
+#define HTM_CP_STREAM_DEADLINE              0x85
+/** Select what a full notification queue drops. Parameter: NOTIFY_DROP_xx (uint8). */
+#define HTM_CP_NOTIFY_POLICY                0x86
+/** Select the stream frame format. Parameter: STREAM_FORMAT_xx (uint8). */
+#define HTM_CP_STREAM_FORMAT                0x87
+/** Show the MEAS_TIMER and ADC trigger jitter on the LCD and restart it. No parameters. */
+#define HTM_CP_SHOW_JITTER                  0x88
+/** Select the filter coefficient set. Parameter: set index (uint8). */
+#define HTM_CP_FILTER_SET                   0x89
+/** Show the cycles spent per filtered sample on the LCD and restart the count. No parameters. */
+#define HTM_CP_SHOW_FILTER                  0x8A
+/** Configure the Sensor Spectrum frames. Parameters: source (SPECTRUM_SRC_xx, uint8), mode
+ *  (SPECTRUM_MODE_xx, uint8), band or peak count (uint8), in bands mode count + 1 band edge bins
+ *  (uint8 each), see spectrumConfigure(). */
+#define HTM_CP_SPECTRUM                     0x8B
+/** Report heart rate measurements by exception. Parameters: change in BPM that is reported (uint8,
+ *  0 reports every measurement interval), longest time between reports in s (uint16). */
+#define HTM_CP_DEADBAND                     0x8C
+/** Change the PA0 sample period without interrupting the acquisition. Parameter: period in ms
+ *  (uint16), see adcSetTriggerPeriod(). */
+#define HTM_CP_SAMPLE_PERIOD                0x8D
+/** Show the cycles spent per ADC sample and per ADC profile change on the LCD and restart the
+ *  count. No parameters. */
+#define HTM_CP_SHOW_ADC_CYCLES              0x8E
+/** Select the ADC inputs acquired while running, see htmSetAdcChannels(). Parameter:
+ *  ADC_SCAN_CH_xx bits (uint8). */
+#define HTM_CP_ADC_CHANNELS                 0x8F
+/** Show the newest LDC1612 conversion as frequency and inductance on the LCD. No parameters. */
+#define HTM_CP_SHOW_LDC                     0x90
+/** Show the notification, stream, LDC1612 and ADC loss counters on the LCD. No parameters. */
+#define HTM_CP_SHOW_STATS                   0x91
+/** Length of the window parameters. */
+#define HTM_CP_WINDOW_LEN                   5
+/** Length of the deadband parameters. */
+#define HTM_CP_DEADBAND_LEN                 4
+
+/** Longest time between heart rate measurements reported by exception until configured, in s. */
+#define HTM_DEADBAND_HEARTBEAT_S            30
+
+/** Persistent store key of the selected ADC oversampling/decimation profile. */
+#define HTM_ADC_PROFILE_PS_KEY              0x4001
+#define HTM_ADC_PROFILE_TEXT                "ADC profile %u:\n %2u.%1u bit\n %3lu.%03lu Hz\n"
+#define HTM_ADC_PROFILE_TEXT_SIZE           48
+
+/** Persistent store key of the selected LDC1612 acquisition profile. */
+#define HTM_LDC_PROFILE_PS_KEY              0x4002
+#define HTM_LDC_PROFILE_TEXT                "LDC profile %u:\n %s\n %lu us\n"
+#define HTM_LDC_PROFILE_TEXT_SIZE           48
+
+/** Persistent store key of the selected filter coefficient set. */
+#define HTM_FILTER_PS_KEY                   0x4003
+#define HTM_FILTER_TEXT                     "Filter %u:\n %s\n%lu cyc avg\n%lu cyc max\n"
+#define HTM_FILTER_TEXT_SIZE                64
+
+/** Persistent store key of the PA0 sample period. */
+#define HTM_SAMPLE_PERIOD_PS_KEY            0x4004
+#define HTM_SAMPLE_PERIOD_TEXT              "Sample period:\n %lu ms\n %3lu.%03lu Hz\n"
+#define HTM_SAMPLE_PERIOD_TEXT_SIZE         48
+
+/** Cycles per ADC sample from trigger to read or in the conversion interrupt, then per ADC profile
+ *  change. */
+#define HTM_ADC_CYCLES_TEXT \
+  "ADC sample cyc:\n %lu avg %lu max\nConfigure cyc:\n %lu avg %lu max\n"
+#define HTM_ADC_CYCLES_TEXT_SIZE            96
+
+/** Persistent store key of the Measurement Interval. */
+#define HTM_MEAS_INTERVAL_PS_KEY            0x4005
+
+/** Persistent store key of the ADC inputs acquired while running. */
+#define HTM_ADC_CHANNELS_PS_KEY             0x4006
+
+/** Longest Sensor Channels notification: ADC_SCAN_CH_xx bits, then the newest sample of each
+ *  input in the mask. */
+#define HTM_CHANNELS_LEN                    (1 + (2 * ADC_SCAN_CHANNELS))
+
+/** Earliest and latest MEAS_TIMER expiry and ADC conversion interrupt against their schedule,
+ *  then after + the periods skipped by stalls. */
+#define HTM_JITTER_TEXT \
+  "Tick jitter us:\n %ld..%ld +%lu\nADC irq us:\n %ld..%ld +%lu\n"
+#define HTM_JITTER_TEXT_SIZE                96
+
+/** Notifications sent, queued for lack of TX buffers and dropped or failed; stream samples the
+ *  writer lost; LDC1612 conversions lost and I2C errors; ADC samples lost per scan input. */
+#define HTM_STATS_TEXT \
+  "Notify %lu sent\n %lu retry %lu drop\nStream %lu drop\nLDC %lu drop\n %lu I2C err\n" \
+  "ADC drop %lu %lu\n %lu %lu\n"
+#define HTM_STATS_TEXT_SIZE                 160
+
+/** Length of an excursion report: count, RTCC timestamp, FIFO samples. */
+#define HTM_EXCURSION_LEN                   (1 + 4 + (2 * ADC_WINDOW_CONTEXT))
 /***************************************************************************************************
  * Local Type Definitions
  **************************************************************************************************/
@@ -132,7 +270,7 @@ typedef struct {
   uint8_t tm_mday;  /**< Day */
   uint8_t tm_hour;  /**< Hour */
   uint8_t tm_min;   /**< Minutes */
-  uint8_t tm_sec;   /**< Milliseconds */
+  uint8_t tm_sec;   /**< Seconds */
 } htmDateTime_t;
 
 /** Temperature measurement structure. */
@@ -141,21 +279,18 @@ typedef struct {
   uint32_t temperature;    /**< Temperature */
   uint8_t flags;           /**< Flags */
   uint8_t tempType;        /**< Temperature type */
-  uint16_t period; /**< Measurement timer expiration period in seconds */
+  uint16_t period; /**< LDC1612 conversion period in ms, one stream sample each */
 } htmTempMeas_t;
 
 /** Heart rate measurement structure. */
 typedef struct {
   uint8_t flags;           /**< Flags */
-  uint16_t hr;			   /**< Heart rate */
-  uint16_t bit;
-  uint16_t adc;
-  //uint16_t time;
-  //uint16_t combo;
+  uint16_t hr;			   /**< Heart rate in BPM, 0 if unknown */
+  uint16_t adc;            /**< Newest PA0 sample, streamed with the LDC1612 conversions */
+  uint8_t rrCount;         /**< RR intervals since the last measurement */
+  uint16_t rr[HTM_HRM_RR_MAX]; /**< RR intervals in 1/1024 s, oldest first */
 } hrMeas_t;
 
-float testprint;
-
 
 /***************************************************************************************************
  * Local Variables
@@ -166,16 +301,11 @@ static htmTempMeas_t htmTempMeas = {
   .period = HTM_TEMP_IND_TIMEOUT
 };
 static hrMeas_t hrMeas = {
-  .hr = 72,
-  .flags =  HRM_FLAG_HR_UINT_16
+  .flags = HRM_FLAG_CONTACT_SUPPORTED
 };
-static uint8_t sps = 0;
-//static uint16_t idx = 0;
-static uint16_t millisec = 0;
-
-//static int32_t data[1000] = {0};
-//static int32_t xcorrData[1000] = {0};
-//static int32_t offset = 0;
+static hrDetect_t htmHrDetect;                       /* Beat detector on the PA0 samples */
+static deadband_t htmHrDeadband;                     /* Heart rate report by exception */
+static uint16_t htmHrHeartbeatS;                     /* Longest time between those reports */
 
 /* timestamp */
 static htmDateTime_t htmDateTime = { 2018, /*! Year, 0 means not known */
@@ -186,13 +316,65 @@ static htmDateTime_t htmDateTime = { 2018, /*! Year, 0 means not known */
                                      0     /*! Seconds */
 };
 
-static uint8_t htmClientConnection = HTM_NO_CONNECTION; /* Current connection or 0xFF if invalid */
+static uint32_t htmMeasPeriodMs = HTM_HRM_PERIOD_MS; /* Measurement Interval */
+static tickSched_t htmMeasSched;                     /* MEAS_TIMER period in exact RTCC ticks */
+static uint32_t htmMeasDue;                          /* RTCC time MEAS_TIMER is due */
+static uint32_t htmMeasLast;                         /* RTCC time MEAS_TIMER was last due */
+static tickJitter_t htmMeasJitter;                   /* MEAS_TIMER lateness against htmMeasDue */
+static uint32_t htmClockLast = 0;                    /* RTCC counter at the last clock update */
+static uint32_t htmClockTicks = 0;                   /* RTCC ticks not yet counted in htmDateTime */
+
+
+static bool htmMeasRunning = false;                  /* Measurement notifications enabled */
+static uint32_t htmAdcChannels = ADC_SCAN_CH_PA0;     /* ADC inputs acquired while running */
+static uint16_t htmAdcScanLatest[ADC_SCAN_CHANNELS]; /* Newest decimated sample of each input */
+static uint8_t htmMonitorConnection = HTM_NO_CONNECTION; /* Receiver of excursion reports */
+static ldcSample_t htmLdcLatest;                     /* Newest LDC1612 conversion */
+static uint32_t htmLdcRate;                          /* LDC1612 conversion sequences in mHz */
+static bool htmTempConverting = false;               /* Si7013 converting, TEMP_TIMER fetches */
+static uint8_t htmStreamFormat = STREAM_FORMAT_RAW;   /* Stream frame format, STREAM_FORMAT_xx */
+static bool htmStreamTimerArmed = false;             /* STREAM_TIMER runs for a partial frame */
+static uint32_t htmTempIndicating = 0;               /* Indication unconfirmed, bit per connection */
 
 /***************************************************************************************************
  * Static Function Declarations
  **************************************************************************************************/
 static uint8_t htmBuildTempMeas(uint8_t *pBuf, htmTempMeas_t *pTempMeas);
-static uint8_t htmProcMsg(uint8_t *buf);
+static void htmAdcStart(void);
+static void htmHrDetectStart(void);
+static void htmHrSample(uint16_t sample);
+static void htmUpdateMeasurement(void);
+static void htmMeasStop(void);
+static void htmMonitorStop(void);
+static void htmUpdateLink(void);
+static void htmIndicateTemp(uint8_t len, const uint8_t *value);
+static void htmNotifySubscribers(uint8_t mask, uint16_t characteristic, uint8_t len,
+                                 const uint8_t *value);
+static bool htmStreamSend(uint8_t connection, const uint8_t *frame, uint16_t len);
+static void htmStreamArm(void);
+static void htmStreamSample(const ldcSample_t *ldc);
+static void htmSpectrumRate(void);
+static void htmSpectrumSample(uint8_t source, uint32_t sample);
+static void htmChannelsSend(void);
+static void htmSetDeadband(uint8_t thresholdBpm, uint16_t heartbeatS);
+static void htmClockUpdate(void);
+static void htmMeasStart(void);
+static void htmMeasArm(uint32_t now);
+static void htmShowJitter(void);
+static void htmDateTimeAdvance(uint32_t seconds);
+static void htmLoadAdcProfile(void);
+static void htmApplyStreamFormat(void);
+static void htmApplyLdcProfile(uint8_t index);
+static void htmLoadLdcProfile(void);
+static void htmLoadFilter(void);
+static void htmShowFilter(void);
+static void htmShowAdcCycles(void);
+static void htmShowLdc(void);
+static void htmShowStats(uint8_t connection);
+static void htmLoadSamplePeriod(void);
+static uint16_t htmApplyMeasInterval(uint16_t seconds);
+static void htmLoadMeasInterval(void);
+static void htmLoadAdcChannels(void);
 
 /***************************************************************************************************
  * Public Function Definitions
@@ -203,11 +385,26 @@ static uint8_t htmProcMsg(uint8_t *buf);
  **************************************************************************************************/
 void htmInit(void)
 {
-  htmClientConnection = HTM_NO_CONNECTION; /* Initially no connection is set. */
-  //gecko_cmd_hardware_set_soft_timer(TIMER_STOP, TEMP_TIMER, true);/* Initially stop the timer. */
-  gecko_cmd_hardware_set_soft_timer(TIMER_STOP, MEAS_TIMER, false);
+  streamInit(); /* Subscriptions are tracked per connection in conn.c */
+  spectrumInit();
+  gecko_cmd_hardware_set_soft_timer(TIMER_STOP, TEMP_TIMER, true);/* Initially stop the timer. */
+  htmTempConverting = false;
+  gecko_cmd_hardware_set_soft_timer(TIMER_STOP, MEAS_TIMER, true);
+  adcStreamStop();
+  adcWindowStop(); /* LDC1612 reads held for it are resumed by appHwRestart() */
+  htmMeasRunning = false;
+  htmMonitorConnection = HTM_NO_CONNECTION;
+  htmTempIndicating = 0;
+  htmSetDeadband(0, HTM_DEADBAND_HEARTBEAT_S);
+  htmLoadAdcProfile();
+  htmLoadSamplePeriod();
+  htmApplyStreamFormat();
+  htmLoadLdcProfile();
+  htmLoadFilter();
+  htmLoadMeasInterval();
+  htmLoadAdcChannels();
   //start = clock();
-  millisec = 0;
+  htmClockUpdate(); /* Keeps counting across reinitializations */
   //hrMeas.time = 0;
 }
 
@@ -217,21 +414,95 @@ void htmInit(void)
  **************************************************************************************************/
 void htmTemperatureCharStatusChange(uint8_t connection, uint16_t clientConfig)
 {
-  /* If the new value of Client Characteristic Config is not 0 (either indication or
-   * notification enabled) update connection ID and start temp. measurement */
-  if (clientConfig) {
-    htmClientConnection = connection; /* Save connection ID */
-    //htmTemperatureMeasure(); /* Make an initial measurement */
-    //start = clock();
-    //htmFrequencyMeasure();
-	//measTick();
-	gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(htmTempMeas.period), MEAS_TIMER, false);
+  /* Every connection that enabled notifications receives the measurements */
+  connSetSubscription(connection, CONN_SUB_HRM, clientConfig != 0);
+  if (clientConfig != 0) {
+    deadbandRestart(&htmHrDeadband); /* The new subscriber gets the current rate right away */
+  }
+  htmUpdateMeasurement();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Temperature Measurement CCCD has changed. The characteristic is indicated only.
+ **************************************************************************************************/
+void htmTempMeasCharStatusChange(uint8_t connection, uint16_t clientConfig)
+{
+  connSetSubscription(connection, CONN_SUB_TEMP, (clientConfig & gatt_indication) != 0);
+  htmTempIndicating &= ~(1UL << connection);
+  htmUpdateMeasurement();
+}
+
+/***********************************************************************************************//**
+ *  \brief  The client confirmed the last temperature indication, the next one may be sent.
+ **************************************************************************************************/
+void htmTempMeasConfirmed(uint8_t connection)
+{
+  htmTempIndicating &= ~(1UL << connection);
+}
 
+/***********************************************************************************************//**
+ *  \brief  Sensor Stream CCCD has changed. Every subscriber gets its own frames.
+ **************************************************************************************************/
+void htmStreamCharStatusChange(uint8_t connection, uint16_t clientConfig)
+{
+  if (clientConfig) {
+    connSetSubscription(connection, CONN_SUB_STREAM,
+                        streamSubscribe(connection, connPayloadLen(connection)));
   } else {
-    //gecko_cmd_hardware_set_soft_timer(TIMER_STOP, TEMP_TIMER, true);
-	gecko_cmd_hardware_set_soft_timer(TIMER_STOP, MEAS_TIMER, false);
+    streamUnsubscribe(connection);
+    connSetSubscription(connection, CONN_SUB_STREAM, false);
+  }
+  htmUpdateMeasurement();
+}
 
+/***********************************************************************************************//**
+ *  \brief  Sensor Spectrum CCCD has changed. Every subscriber gets the same frames.
+ **************************************************************************************************/
+void htmSpectrumCharStatusChange(uint8_t connection, uint16_t clientConfig)
+{
+  connSetSubscription(connection, CONN_SUB_SPECTRUM, clientConfig != 0);
+  htmUpdateMeasurement();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Sensor Channels CCCD has changed. Every subscriber gets the same values.
+ **************************************************************************************************/
+void htmChannelsCharStatusChange(uint8_t connection, uint16_t clientConfig)
+{
+  connSetSubscription(connection, CONN_SUB_CHANNELS, clientConfig != 0);
+  htmUpdateMeasurement();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Sensor Excursion CCCD has changed. Only the connection that started the window
+ *  monitoring gets the reports.
+ **************************************************************************************************/
+void htmExcursionCharStatusChange(uint8_t connection, uint16_t clientConfig)
+{
+  connSetSubscription(connection, CONN_SUB_EXCURSION, clientConfig != 0);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Size stream frames to the MTU negotiated with the client.
+ **************************************************************************************************/
+void htmMtuExchanged(uint8_t connection, uint16_t mtu)
+{
+  (void)mtu;
+  streamSetPayloadLen(connection, connPayloadLen(connection));
+  htmUpdateLink();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Forget what belonged to a closed connection while others stay connected.
+ **************************************************************************************************/
+void htmConnectionClosed(uint8_t connection)
+{
+  streamUnsubscribe(connection);
+  htmTempIndicating &= ~(1UL << connection);
+  if (connection == htmMonitorConnection) {
+    htmMonitorStop();
   }
+  htmUpdateMeasurement();
 }
 
 /***********************************************************************************************//**
@@ -264,6 +535,563 @@ void htmTemperatureCharStatusChange(uint8_t connection, uint16_t clientConfig)
  * Static Function Definitions
  **************************************************************************************************/
 
+/***********************************************************************************************//**
+ *  \brief  Run the measurements while heart rate, stream, spectrum or channel notifications or
+ *  temperature indications are enabled.
+ *  \details  Window monitoring runs alone, the measurements resume when it stops.
+ **************************************************************************************************/
+static void htmUpdateMeasurement(void)
+{
+  bool wanted = (htmMonitorConnection == HTM_NO_CONNECTION)
+                && (connSubscribed(CONN_SUB_HRM | CONN_SUB_STREAM | CONN_SUB_SPECTRUM | CONN_SUB_TEMP
+                                   | CONN_SUB_CHANNELS) > 0);
+
+  if (wanted && !htmMeasRunning) {
+    htmMeasStart();
+    htmMeasRunning = true;
+    htmAdcStart();
+    htmTempTick(); /* Si7013 runs on the I2C queue next to the LDC1612 */
+  } else if (!wanted && htmMeasRunning) {
+    htmMeasStop();
+  }
+  htmUpdateLink();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Stop MEAS_TIMER, the Si7013 cycle and the ADC stream.
+ *  \details  A Si7013 transfer already queued completes, htmTempDataHandler() drops its result.
+ **************************************************************************************************/
+static void htmMeasStop(void)
+{
+  gecko_cmd_hardware_set_soft_timer(TIMER_STOP, TEMP_TIMER, true);
+  gecko_cmd_hardware_set_soft_timer(TIMER_STOP, MEAS_TIMER, true);
+  htmTempConverting = false;
+  htmMeasRunning = false;
+  adcStreamStop();
+}
+
+/***********************************************************************************************//**
+ *  \brief  End window monitoring and resume the measurements for the clients still subscribed.
+ **************************************************************************************************/
+static void htmMonitorStop(void)
+{
+  adcWindowStop();
+  if (htmMonitorConnection == HTM_NO_CONNECTION) {
+    return;
+  }
+  htmMonitorConnection = HTM_NO_CONNECTION;
+  appHwFreqSensEnable(true);
+  htmUpdateMeasurement();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Fit the connection parameters of the receivers to the notification rate.
+ *  \details  Heart rate measurements and channel values go out every measurement interval, stream
+ *  frames once full or at their deadline, spectrum frames every SPECTRUM_HOP samples. Window
+ *  monitoring and heart rate measurements reported by exception count as idle.
+ **************************************************************************************************/
+static void htmUpdateLink(void)
+{
+  const connInfo_t *info;
+  uint32_t i, notifyMs, streamMs, spectrumMs;
+
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    info = connAt(i);
+    if (info == NULL) {
+      continue;
+    }
+    notifyMs = 0;
+    if (htmMeasRunning && (((info->subscriptions & CONN_SUB_HRM) && !deadbandActive(&htmHrDeadband))
+                           || (info->subscriptions & CONN_SUB_CHANNELS))) {
+      notifyMs = htmMeasPeriodMs;
+    }
+    if (htmMeasRunning && (info->subscriptions & CONN_SUB_STREAM)) {
+      streamMs = streamFramePeriodMs(info->connection, htmTempMeas.period);
+      if ((notifyMs == 0) || ((streamMs != 0) && (streamMs < notifyMs))) {
+        notifyMs = streamMs;
+      }
+    }
+    if (htmMeasRunning && (info->subscriptions & CONN_SUB_SPECTRUM)) {
+      spectrumMs = spectrumFramePeriodMs();
+      if ((notifyMs == 0) || ((spectrumMs != 0) && (spectrumMs < notifyMs))) {
+        notifyMs = spectrumMs;
+      }
+    }
+    connRequestRate(info->connection, notifyMs);
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Send a notification to every connection subscribed to mask.
+ **************************************************************************************************/
+static void htmNotifySubscribers(uint8_t mask, uint16_t characteristic, uint8_t len,
+                                 const uint8_t *value)
+{
+  const connInfo_t *info;
+  uint32_t i;
+
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    info = connAt(i);
+    if ((info != NULL) && (info->subscriptions & mask)) {
+      notifySend(info->connection, characteristic, len, value);
+    }
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Indicate a temperature measurement to every subscribed connection.
+ *  \details  Only one indication may wait for its confirmation. A connection that has not confirmed
+ *  the previous one skips this measurement and gets the next.
+ **************************************************************************************************/
+static void htmIndicateTemp(uint8_t len, const uint8_t *value)
+{
+  const connInfo_t *info;
+  uint32_t i;
+
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    info = connAt(i);
+    if ((info == NULL) || !(info->subscriptions & CONN_SUB_TEMP)
+        || (htmTempIndicating & (1UL << info->connection))) {
+      continue;
+    }
+    if (gecko_cmd_gatt_server_send_characteristic_notification(
+          info->connection, gattdb_temperature_measurement, len, value)->result == 0) {
+      htmTempIndicating |= (1UL << info->connection);
+    }
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Send a stream frame, see streamSendFn_t.
+ *  \details  Frames bypass the notification queue: a frame the stack has no buffer for stays with
+ *  its subscriber, which keeps collecting samples in the stream ring meanwhile.
+ **************************************************************************************************/
+static bool htmStreamSend(uint8_t connection, const uint8_t *frame, uint16_t len)
+{
+  uint16_t result;
+
+  result = gecko_cmd_gatt_server_send_characteristic_notification(
+    connection, gattdb_sensor_stream, (uint8_t)len, frame)->result;
+  return result != bg_err_out_of_memory;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Add a LDC1612 conversion and the newest ADC value to the stream and send the frame once
+ *  complete.
+ *  \details  The sample is stamped with the RTCC capture of the data ready edge, not the time it
+ *  is processed at.
+ **************************************************************************************************/
+static void htmStreamSample(const ldcSample_t *ldc)
+{
+  uint8_t sample[STREAM_SAMPLE_LEN];
+  uint8_t *p = sample;
+
+  UINT32_TO_BITSTREAM(p, ldc->data[0]);
+  UINT32_TO_BITSTREAM(p, ldc->data[1]);
+  UINT16_TO_BITSTREAM(p, hrMeas.adc);
+
+  streamAdd(ldc->timestamp, sample);
+  streamService(htmStreamSend);
+  htmStreamArm();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Arm STREAM_TIMER for the oldest partly filled stream frame.
+ *  \details  Without it a frame is only closed by the next sample, which at low conversion rates
+ *  arrives long after the latency deadline. Soft timer ticks are RTCC ticks.
+ **************************************************************************************************/
+static void htmStreamArm(void)
+{
+  uint32_t ticks;
+
+  if (!htmStreamTimerArmed && streamNextDeadline(RTCC_CounterGet(), &ticks)) {
+    gecko_cmd_hardware_set_soft_timer(ticks, STREAM_TIMER, true);
+    htmStreamTimerArmed = true;
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Pass the sample rate of the analysed channel to the spectrum.
+ **************************************************************************************************/
+static void htmSpectrumRate(void)
+{
+  adcOvsInfo_t info;
+
+  if (spectrumGetSource() != SPECTRUM_SRC_ADC) {
+    spectrumSetRate(htmLdcRate);
+  } else if (adcOvsGetInfo(adcOvsGetSelected(), &info)) {
+    spectrumSetRate(info.rate);
+  }
+  htmUpdateLink();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Add an unfiltered sample to the spectrum and send each completed frame.
+ *  \details  Each subscriber gets as many bands or peaks as fit into its payload.
+ **************************************************************************************************/
+static void htmSpectrumSample(uint8_t source, uint32_t sample)
+{
+  uint8_t frame[SPECTRUM_FRAME_MAX];
+  const connInfo_t *info;
+  uint32_t i;
+  uint8_t len;
+
+  if (!htmMeasRunning || (spectrumGetSource() != source) || (connSubscribed(CONN_SUB_SPECTRUM) == 0)
+      || !spectrumAdd(sample)) {
+    return;
+  }
+  for (i = 0; i < MAX_CONNECTIONS; i++) {
+    info = connAt(i);
+    if ((info != NULL) && (info->subscriptions & CONN_SUB_SPECTRUM)) {
+      len = spectrumFrame(frame, connPayloadLen(info->connection));
+      notifySend(info->connection, gattdb_sensor_spectrum, len, frame);
+    }
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Notify the newest decimated sample of each acquired ADC input.
+ **************************************************************************************************/
+static void htmChannelsSend(void)
+{
+  uint8_t value[HTM_CHANNELS_LEN];
+  uint8_t *p = value;
+  uint32_t ch;
+
+  if (connSubscribed(CONN_SUB_CHANNELS) == 0) {
+    return;
+  }
+  UINT8_TO_BITSTREAM(p, (uint8_t)htmAdcChannels);
+  for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++) {
+    if (htmAdcChannels & (1UL << ch)) {
+      UINT16_TO_BITSTREAM(p, htmAdcScanLatest[ch]);
+    }
+  }
+  htmNotifySubscribers(CONN_SUB_CHANNELS, gattdb_sensor_channels, (uint8_t)(p - value), value);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Configure the heart rate report by exception.
+ *  \param[in]  thresholdBpm  Change that is reported, 0 to report every measurement interval.
+ *  \param[in]  heartbeatS  Longest time between reports in s.
+ **************************************************************************************************/
+static void htmSetDeadband(uint8_t thresholdBpm, uint16_t heartbeatS)
+{
+  uint32_t heartbeat, margin;
+
+  if (heartbeatS == 0) {
+    heartbeatS = HTM_DEADBAND_HEARTBEAT_S;
+  }
+  htmHrHeartbeatS = heartbeatS;
+  /* Half a period short, so MEAS_TIMER jitter cannot delay the heartbeat by a whole period */
+  heartbeat = heartbeatS * HTM_RTCC_HZ;
+  margin = (htmMeasPeriodMs * HTM_RTCC_HZ) / 2000;
+  heartbeat = (heartbeat > margin) ? (heartbeat - margin) : 0;
+  deadbandInit(&htmHrDeadband, thresholdBpm, heartbeat);
+  htmUpdateLink();
+}
+
+/***********************************************************************************************//**
+ *  \brief  (Re)start MEAS_TIMER at the measurement interval from now.
+ **************************************************************************************************/
+static void htmMeasStart(void)
+{
+  uint32_t now = RTCC_CounterGet();
+
+  tickSchedInit(&htmMeasSched, htmMeasPeriodMs);
+  tickJitterReset(&htmMeasJitter);
+  htmMeasLast = now;
+  htmMeasDue = now + tickSchedNext(&htmMeasSched);
+  htmMeasArm(now);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Arm MEAS_TIMER as a single shot expiring at htmMeasDue.
+ **************************************************************************************************/
+static void htmMeasArm(uint32_t now)
+{
+  uint32_t delay = htmMeasDue - now;
+
+  /* 0 would stop the timer */
+  gecko_cmd_hardware_set_soft_timer((delay > 0) ? delay : 1, MEAS_TIMER, true);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Show how far MEAS_TIMER and the ADC conversion interrupt trail their schedule, then
+ *  restart the statistics.
+ **************************************************************************************************/
+static void htmShowJitter(void)
+{
+  tickJitter_t tick = htmMeasJitter;
+  tickJitter_t adc;
+  char text[HTM_JITTER_TEXT_SIZE];
+
+  adcGetTriggerJitter(&adc);
+  if (tick.count == 0) {
+    tick.min = tick.max = 0;
+  }
+  if (adc.count == 0) {
+    adc.min = adc.max = 0;
+  }
+  snprintf(text, sizeof(text), HTM_JITTER_TEXT,
+           (long)tickToMicroSec(tick.min), (long)tickToMicroSec(tick.max),
+           (unsigned long)tick.skipped,
+           (long)tickToMicroSec(adc.min), (long)tickToMicroSec(adc.max),
+           (unsigned long)adc.skipped);
+  appUiWriteString(text);
+
+  adcResetTriggerJitter();
+  tickJitterReset(&htmMeasJitter);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Advance htmDateTime by the RTCC time elapsed since the last call.
+ *  \details  The 32 bit counter wraps after 36 hours, the Si7013 cycle calls this every second.
+ **************************************************************************************************/
+static void htmClockUpdate(void)
+{
+  uint32_t now = RTCC_CounterGet();
+
+  htmClockTicks += now - htmClockLast;
+  htmClockLast = now;
+  htmDateTimeAdvance(htmClockTicks / HTM_RTCC_HZ);
+  htmClockTicks %= HTM_RTCC_HZ;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Add seconds to htmDateTime, carrying into minutes, hours, days, months and years.
+ **************************************************************************************************/
+static void htmDateTimeAdvance(uint32_t seconds)
+{
+  static const uint8_t daysInMonth[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  uint32_t t;
+  uint8_t days;
+
+  t = htmDateTime.tm_sec + seconds;
+  htmDateTime.tm_sec = (uint8_t)(t % 60);
+  t = htmDateTime.tm_min + (t / 60);
+  htmDateTime.tm_min = (uint8_t)(t % 60);
+  t = htmDateTime.tm_hour + (t / 60);
+  htmDateTime.tm_hour = (uint8_t)(t % 24);
+
+  for (t /= 24; t > 0; t--) {
+    days = daysInMonth[(htmDateTime.tm_mon - 1) % 12];
+    if ((htmDateTime.tm_mon == 2) && ((htmDateTime.tm_year % 4) == 0)
+        && (((htmDateTime.tm_year % 100) != 0) || ((htmDateTime.tm_year % 400) == 0))) {
+      days++;
+    }
+    if (++htmDateTime.tm_mday > days) {
+      htmDateTime.tm_mday = 1;
+      if (++htmDateTime.tm_mon > 12) {
+        htmDateTime.tm_mon = 1;
+        htmDateTime.tm_year++;
+      }
+    }
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Start ADC acquisition for the selected inputs.
+ *  \details  PA0 alone uses the single conversion stream, any other selection a scan sequence.
+ **************************************************************************************************/
+static void htmAdcStart(void)
+{
+  htmHrDetectStart();
+  if (htmAdcChannels == ADC_SCAN_CH_PA0) {
+    adcStreamStart();
+  } else {
+    adcScanStart(htmAdcChannels);
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Restart the beat detector at the output rate of the selected ADC profile.
+ **************************************************************************************************/
+static void htmHrDetectStart(void)
+{
+  adcOvsInfo_t info;
+
+  if (!adcOvsGetInfo(adcOvsGetSelected(), &info)) {
+    return;
+  }
+  hrDetectInit(&htmHrDetect, (info.rate + 500) / 1000);
+  hrMeas.hr = 0;
+  hrMeas.rrCount = 0;
+  htmSpectrumRate();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Analyse the spectrum of a decimated PA0 sample, filter it, keep it for the stream and run
+ *  it through the beat detector.
+ **************************************************************************************************/
+static void htmHrSample(uint16_t sample)
+{
+  htmSpectrumSample(SPECTRUM_SRC_ADC, sample);
+  sample = filterAdc(sample);
+  getADCValue(sample);
+  hrDetectPush(&htmHrDetect, sample);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Apply the ADC oversampling/decimation profile stored in the persistent store, if any.
+ **************************************************************************************************/
+static void htmLoadAdcProfile(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+
+  rsp = gecko_cmd_flash_ps_load(HTM_ADC_PROFILE_PS_KEY);
+  if ((rsp->result == 0) && (rsp->value.len == 1)) {
+    adcOvsSelect(rsp->value.data[0]);
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Pass the stream format and the zero ADC LSBs of the selected profile to the stream.
+ *  \details  adcDecimate() scales plain 12 bit conversions to 16 bit, so their 4 LSBs are zero
+ *  unless averaging or filtering filled them.
+ **************************************************************************************************/
+static void htmApplyStreamFormat(void)
+{
+  adcOvsInfo_t info;
+  uint8_t adcShift = 0;
+
+  if (adcOvsGetInfo(adcOvsGetSelected(), &info) && (info.hwRatio == 1) && (info.swRatio == 1)
+      && (filterGetSelected() == FILTER_SET_OFF)) {
+    adcShift = 4;
+  }
+  streamSetFormat(htmStreamFormat, adcShift);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Apply a LDC1612 acquisition profile.
+ **************************************************************************************************/
+static void htmApplyLdcProfile(uint8_t index)
+{
+  const ldcProfile_t *profile = ldcProfileGet(index);
+  uint32_t convUs, periodMs;
+
+  if (profile == NULL) {
+    return;
+  }
+  appHwSetFreqProfile(profile);
+
+  /* One stream sample per conversion sequence */
+  convUs = ldcProfileConvTimeUs(profile, LDC1612_ACQ_CHANNELS);
+  periodMs = (convUs + 999) / 1000;
+  htmTempMeas.period = (uint16_t)((periodMs > 0) ? periodMs : 1);
+  htmLdcRate = (convUs > 0) ? (1000000000UL / convUs) : 0;
+  htmSpectrumRate();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Apply the LDC1612 acquisition profile stored in the persistent store, or the default.
+ **************************************************************************************************/
+static void htmLoadLdcProfile(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+
+  rsp = gecko_cmd_flash_ps_load(HTM_LDC_PROFILE_PS_KEY);
+  if ((rsp->result == 0) && (rsp->value.len == 1)) {
+    htmApplyLdcProfile(rsp->value.data[0]);
+  } else {
+    htmApplyLdcProfile(LDC_PROFILE_DEFAULT);
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Select the filter coefficient set stored in the persistent store, if any.
+ **************************************************************************************************/
+static void htmLoadFilter(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+
+  rsp = gecko_cmd_flash_ps_load(HTM_FILTER_PS_KEY);
+  if ((rsp->result == 0) && (rsp->value.len == 1) && filterSelect(rsp->value.data[0])) {
+    htmApplyStreamFormat();
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Apply the PA0 sample period stored in the persistent store, if any.
+ **************************************************************************************************/
+static void htmLoadSamplePeriod(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+
+  rsp = gecko_cmd_flash_ps_load(HTM_SAMPLE_PERIOD_PS_KEY);
+  if ((rsp->result == 0) && (rsp->value.len == 2)) {
+    adcSetTriggerPeriod(rsp->value.data[0] | (rsp->value.data[1] << 8));
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Apply the Measurement Interval stored in the persistent store, or the default.
+ **************************************************************************************************/
+static void htmLoadMeasInterval(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+
+  rsp = gecko_cmd_flash_ps_load(HTM_MEAS_INTERVAL_PS_KEY);
+  if ((rsp->result == 0) && (rsp->value.len == 2)) {
+    htmApplyMeasInterval(rsp->value.data[0] | (rsp->value.data[1] << 8));
+  } else {
+    htmApplyMeasInterval(HTM_HRM_PERIOD_MS / 1000);
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Select the ADC inputs stored in the persistent store, if any.
+ *  \details  Called before the measurements start, htmAdcStart() picks the selection up.
+ **************************************************************************************************/
+static void htmLoadAdcChannels(void)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+
+  rsp = gecko_cmd_flash_ps_load(HTM_ADC_CHANNELS_PS_KEY);
+  if ((rsp->result == 0) && (rsp->value.len == 1) && ((rsp->value.data[0] & ADC_SCAN_CH_ALL) != 0)) {
+    htmAdcChannels = rsp->value.data[0] & ADC_SCAN_CH_ALL;
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  Show the cycles spent per filtered sample, then restart the count.
+ **************************************************************************************************/
+static void htmShowFilter(void)
+{
+  filterCycleStats_t stats;
+  char text[HTM_FILTER_TEXT_SIZE];
+  uint8_t index = filterGetSelected();
+
+  filterGetCycleStats(&stats);
+  if (stats.count == 0) {
+    stats.max = 0;
+  }
+  snprintf(text, sizeof(text), HTM_FILTER_TEXT, index, filterSetGet(index)->name,
+           (unsigned long)((stats.count > 0) ? (stats.total / stats.count) : 0),
+           (unsigned long)stats.max);
+  appUiWriteString(text);
+  filterResetCycleStats();
+}
+
+/***********************************************************************************************//**
+ *  \brief  Show the cycles spent per ADC sample and per ADC profile change, then restart the count.
+ **************************************************************************************************/
+static void htmShowAdcCycles(void)
+{
+  adcCycleStats_t stats;
+  char text[HTM_ADC_CYCLES_TEXT_SIZE];
+
+  adcGetCycleStats(&stats);
+  snprintf(text, sizeof(text), HTM_ADC_CYCLES_TEXT,
+           (unsigned long)((stats.sample.count > 0) ? (stats.sample.total / stats.sample.count) : 0),
+           (unsigned long)stats.sample.max,
+           (unsigned long)((stats.configure.count > 0)
+                           ? (stats.configure.total / stats.configure.count) : 0),
+           (unsigned long)stats.configure.max);
+  appUiWriteString(text);
+  adcResetCycleStats();
+}
+
 /***********************************************************************************************//**
  *  \brief  Build a temperature measurement characteristic.
  *  \param[in]  pBuf  Pointer to buffer to hold the built temperature measurement characteristic.
@@ -274,7 +1102,7 @@ static uint8_t htmBuildTempMeas(uint8_t *pBuf, htmTempMeas_t *pTempMeas)
 {
   uint8_t *p = pBuf;
   uint8_t flags = pTempMeas->flags;
-#ifdef need
+
   /* Convert HTM flags to bitstream and append them in the HTM temperature data buffer */
   UINT8_TO_BITSTREAM(p, flags);
 
@@ -288,37 +1116,55 @@ static uint8_t htmBuildTempMeas(uint8_t *pBuf, htmTempMeas_t *pTempMeas)
     UINT8_TO_BITSTREAM(p, pTempMeas->timestamp.tm_mday);
     UINT8_TO_BITSTREAM(p, pTempMeas->timestamp.tm_hour);
     UINT8_TO_BITSTREAM(p, pTempMeas->timestamp.tm_min);
-    UINT16_TO_BITSTREAM(p, pTempMeas->timestamp.tm_sec);
+    UINT8_TO_BITSTREAM(p, pTempMeas->timestamp.tm_sec);
   }
 
   /* If temperature type field present, convert type to bitstream */
   if (flags & HTM_FLAG_TEMP_TYPE_PRESENT) {
     UINT8_TO_BITSTREAM(p, pTempMeas->tempType);
   }
-#endif
 
   /* Return length of data to be sent */
   return (uint8_t)(p - pBuf);
 }
 
+/***********************************************************************************************//**
+ *  \brief  Build a heart rate measurement characteristic.
+ *  \param[in]  pBuf  Buffer of ATT_DEFAULT_PAYLOAD_LEN bytes.
+ *  \param[in]  pHrMeas  Heart rate measurement values.
+ *  \return  Length of pBuf in bytes.
+ **************************************************************************************************/
 static uint8_t hrmBuildHrMeas(uint8_t *pBuf, hrMeas_t *pHrMeas)
 {
   uint8_t *p = pBuf;
+  uint8_t flags = pHrMeas->flags;
+  uint32_t i, rrCount = pHrMeas->rrCount;
+
+  if (pHrMeas->hr > 0xFF) {
+    flags |= HRM_FLAG_HR_UINT16;
+    /* The uint16 heart rate takes the room of one RR interval, the newest ones are kept */
+    if (rrCount == HTM_HRM_RR_MAX) {
+      rrCount--;
+    }
+  }
+  if (rrCount > 0) {
+    flags |= HRM_FLAG_RR_INTERVAL;
+  }
 
-  /* Convert HTM flags to bitstream and append them in the HTM temperature data buffer */
-  UINT8_TO_BITSTREAM(p, pHrMeas->flags);
-
-  /* Convert temperature measurement value to bitstream */
-  UINT16_TO_BITSTREAM(p, pHrMeas->hr);
-
-  /* Convert second variable to bitstream */
-  UINT16_TO_BITSTREAM(p, pHrMeas->bit);
+  /* Convert HRM flags to bitstream */
+  UINT8_TO_BITSTREAM(p, flags);
 
-  /* Convert time variable to bitstream */
-  //UINT16_TO_BITSTREAM(p, pHrMeas->time);
+  /* Convert heart rate to bitstream */
+  if (flags & HRM_FLAG_HR_UINT16) {
+    UINT16_TO_BITSTREAM(p, pHrMeas->hr);
+  } else {
+    UINT8_TO_BITSTREAM(p, (uint8_t)pHrMeas->hr);
+  }
 
-  /* Convert ADC value to bitstream */
-  UINT16_TO_BITSTREAM(p, pHrMeas->adc);
+  /* Beats since the previous measurement */
+  for (i = pHrMeas->rrCount - rrCount; i < pHrMeas->rrCount; i++) {
+    UINT16_TO_BITSTREAM(p, pHrMeas->rr[i]);
+  }
 
   /* Return length of data to be sent */
   return (uint8_t)(p - pBuf);
@@ -406,170 +1252,578 @@ static uint8_t hrmBuildHrMeas(uint8_t *pBuf, hrMeas_t *pHrMeas)
 
 
 /***********************************************************************************************//**
- *  \brief  This function is called by the application when the periodic measurement timer expires.
- *  \param[in]  buf  Event message.
- *  \return  length of inductance measurement.
+ *  \brief  Show the newest LDC1612 conversion of each coil as sensor frequency and inductance.
  **************************************************************************************************/
-static uint8_t htmFreqMsg(uint8_t *buf)
+static void htmShowLdc(void)
 {
-  uint8_t len = 0; /* Length of the temperature measurement */
-  float freqFLT0 = 0, freqFLT1 = 0; /* Sensor resonant frequency in Hz for the LCD */
-  char freqString[HTM_FREQ_VALUE_TEXT_SIZE]; /* Sensor resonant frequency as string for the LCD */
-  uint32_t freqData0 = 0, freqData1 = 0;
-
-  /* Convert temperature to the right format for LCD display */
-  /* Read temperature and check if read successfully */
-  if (appHwReadFreq(&freqData0, &freqData1) == 0) {
-	  freqFLT0 = freqData0 * 0.149f;
-	  freqFLT1 = freqData1 * 0.149f;
-    /*if (HTM_FLAG_TEMP_UNIT_F == (htmTempMeas.flags & HTM_FLAG_TEMP_UNIT_MASK)) {
-       * Conversion to Fahrenheit: F = C * 1.8 + 32
-       * Here multiplying with 18 instead of 1.8 will make the result 10^4 (e4)
-    	htmTempMeas.temperature = FLT_TO_UINT32((freqData0 & 0xFFFF0000U) >> 16, 0);
-    } else {
-    	htmTempMeas.temperature = FLT_TO_UINT32(freqData0 & 0x0000FFFFU, 0);
-    }*/
+  char text[HTM_LDC_TEXT_SIZE];
+  uint32_t dHz0, dHz1, nH0, nH1;
 
+  /* Newest conversion read on INTB, see htmLdcDataHandler() */
+  if (htmLdcLatest.channelMask == 0) {
+    return;
   }
+  dHz0 = ldcConvToDeciHz(htmLdcLatest.data[0]);
+  dHz1 = ldcConvToDeciHz(htmLdcLatest.data[1]);
+  nH0 = ldcConvToNanoHenry(htmLdcLatest.data[0]);
+  nH1 = ldcConvToNanoHenry(htmLdcLatest.data[1]);
+  snprintf(text, sizeof(text), HTM_LDC_TEXT,
+           (unsigned long)(dHz0 / 10), (unsigned long)(dHz0 % 10),
+           (unsigned long)(nH0 / 1000), (unsigned long)(nH0 % 1000),
+           (unsigned long)(dHz1 / 10), (unsigned long)(dHz1 % 10),
+           (unsigned long)(nH1 / 1000), (unsigned long)(nH1 % 1000));
+  appUiWriteString(text);
+}
 
-  //hrMeas.hr = (uint16_t)((freqData0 - 0x00100000U) >> 4);
+/***********************************************************************************************//**
+ *  \brief  Show what was lost on the way from the sensors to the clients.
+ *  \details  The counters run from boot and are not reset.
+ *  \param[in]  connection  Connection whose stream drops are shown.
+ **************************************************************************************************/
+static void htmShowStats(uint8_t connection)
+{
+  notifyStats_t notify;
+  char text[HTM_STATS_TEXT_SIZE];
+
+  notifyGetStats(&notify);
+  snprintf(text, sizeof(text), HTM_STATS_TEXT,
+           (unsigned long)notify.sent, (unsigned long)notify.retried,
+           (unsigned long)(notify.droppedOldest + notify.droppedNewest + notify.failed),
+           (unsigned long)streamGetDrops(connection),
+           (unsigned long)ldcAsyncGetDrops(), (unsigned long)ldcAsyncGetBusErrors(),
+           (unsigned long)adcScanGetDrops(0), (unsigned long)adcScanGetDrops(1),
+           (unsigned long)adcScanGetDrops(2), (unsigned long)adcScanGetDrops(3));
+  appUiWriteString(text);
+}
 
-  //Split
-  hrMeas.hr = (uint16_t) (freqData0 >> 16);
-  hrMeas.bit = (uint16_t) (freqData0 & 0x0000FFFFU);
+/***********************************************************************************************//**
+ *  \brief Function for taking a single temperature measurement with the WSTK Temperature sensor.
+ **************************************************************************************************/
+void htmFrequencyMeasure(void)
+{
+  //start = clock();
+  uint8_t hrmBuffer[ATT_DEFAULT_PAYLOAD_LEN]; /* Heart rate measurement */
+  uint8_t length2; /* Length of the heart rate measurement characteristic */
+  uint8_t flags;
 
-  /* Set the timestamp */
-  //htmTempMeas.timestamp = htmDateTime;
-  //seconds = time(NULL);
-  //hrMeas.time = (uint16_t) seconds;
+  /* Check if anybody is listening */
+  if (!htmMeasRunning) {
+    return;
+  }
 
-  /* Increment Seconds and Minutes fields to simulate time */
-  //htmDateTime.tm_sec += htmTempMeas.period / 1000;
-#ifdef need
-  if (millisec > 999){
-	    //snprintf(freqString, sizeof("SPS:-----"), "SPS:%5d", sps);
-	    //appUiWriteString(freqString);
-	    sps = 0;
-	    //millisec = 0;
-	    htmDateTime.tm_sec += 1;
+  /* The ADC inputs besides PA0 have no heart rate characteristic, so they go out every interval */
+  htmChannelsSend();
+
+  /* Report by exception: a rate within the deadband waits for the heartbeat, the beats meanwhile
+   * stay queued in the detector and the newest go out with the next report */
+  flags = htmHrDetect.contact
+          ? (HRM_FLAG_CONTACT_SUPPORTED | HRM_FLAG_CONTACT_DETECTED) : HRM_FLAG_CONTACT_SUPPORTED;
+  if (!deadbandCheck(&htmHrDeadband, htmHrDetect.bpm, RTCC_CounterGet(), flags != hrMeas.flags)) {
+    return;
   }
-  else {
-	  sps += 1;
+
+  /* Rate and beats found by the detector since the last measurement */
+  hrMeas.hr = htmHrDetect.bpm;
+  hrMeas.flags = flags;
+  hrMeas.rrCount = (uint8_t)hrDetectTakeRr(&htmHrDetect, hrMeas.rr, HTM_HRM_RR_MAX);
+  length2 = hrmBuildHrMeas(hrmBuffer, &hrMeas);
+  //hrMeas.time = millisec;
+  //hrMeas.adc = adcValue;
+
+  //hrMeas.combo = (hrMeas.time << 8) | hrMeas.adc;
+
+  //char time[32];
+  //snprintf(time, sizeof(HTM_TIME_VALUE_TEXT),HTM_TIME_VALUE_TEXT, millisec);
+  //appUiWriteString(time);
+
+  //gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(htmTempMeas.period), MEAS_TIMER, true);
+
+
+  htmNotifySubscribers(CONN_SUB_HRM, gattdb_heart_rate_measurement, length2, hrmBuffer);
+
+
+  /* Start the repeating timer */
+	//gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(htmTempMeas.period), MEAS_TIMER, true);
+}
+
+void getADCValue(uint32_t sample) {
+	hrMeas.adc = (uint16_t)sample;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Consume the ADC blocks completed by LDMA.
+ *  \details  Called from the main loop on APP_SIGNAL_ADC_HALF. Every sample goes through the
+ *  decimator; the outputs feed the beat detector and the newest is kept for the stream and the
+ *  Sensor Channels.
+ **************************************************************************************************/
+void htmAdcStreamHandler(void)
+{
+  const uint32_t *block;
+
+  uint32_t i;
+
+  while ((block = adcStreamGetBlock()) != NULL) {
+    for (i = 0; i < ADC_BUFFER_HALF; i++) {
+      if (adcDecimate(0, block[i], &htmAdcScanLatest[0])) {
+        htmHrSample(htmAdcScanLatest[0]);
+      }
+    }
+    adcStreamReleaseBlock();
   }
+}
 
-  if (htmDateTime.tm_sec > 59) {
-    htmDateTime.tm_sec = 0;
-    if (htmDateTime.tm_min > 59) {
-    	htmDateTime.tm_min = 0;
-    	if (htmDateTime.tm_hour > 23) {
-    		htmDateTime.tm_hour = 0;
-    	}
-    	else {
-    		htmDateTime.tm_hour = htmDateTime.tm_hour + 1;
-    	}
+/***********************************************************************************************//**
+ *  \brief  Collect the LDC1612 conversions read in the background.
+ *  \details  Called from the main loop on APP_SIGNAL_LDC_DATA. The newest conversion is kept for
+ *  the next heart rate measurement notification.
+ **************************************************************************************************/
+void htmLdcDataHandler(void)
+{
+  ldcSample_t sample;
+  uint32_t ch;
+
+  while (ldcAsyncGetSample(&sample)) {
+    for (ch = 0; ch < LDC1612_CHANNELS; ch++) {
+      if (sample.channelMask & (1 << ch)) {
+        htmSpectrumSample(SPECTRUM_SRC_LDC0 + ch, sample.data[ch]);
+        sample.data[ch] = filterLdc(ch, sample.data[ch]);
+      }
     }
-    else {
-    	htmDateTime.tm_min = htmDateTime.tm_min + 1;
+    htmLdcLatest = sample;
+    if (htmMeasRunning && (streamSubscribers() > 0)) {
+      htmStreamSample(&sample);
     }
   }
+}
 
+/***********************************************************************************************//**
+ *  \brief  Send the partly filled stream frames that passed their deadline on STREAM_TIMER.
+ **************************************************************************************************/
+void htmStreamTick(void)
+{
+  htmStreamTimerArmed = false;
+  streamFlush(RTCC_CounterGet(), htmStreamSend);
+  htmStreamArm();
+}
 
+/***********************************************************************************************//**
+ *  \brief  Run the Si7013 measurement cycle on TEMP_TIMER.
+ *  \details  The first expiry starts a conversion, the one SI7013_CONV_MS later queues the result
+ *  read. The I2C bus is free for the LDC1612 in between.
+ **************************************************************************************************/
+void htmTempTick(void)
+{
+  if (!htmTempConverting) {
+    if (si7013AsyncMeasure()) {
+      htmTempConverting = true;
+      gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(SI7013_CONV_MS), TEMP_TIMER, true);
+      return;
+    }
+  } else {
+    htmTempConverting = false;
+    if (si7013AsyncFetch()) {
+      return; /* htmTempDataHandler() schedules the next cycle */
+    }
+  }
+  gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(HTM_SI7013_PERIOD_MS), TEMP_TIMER, true);
+}
 
-  /* Set temperature type */
+/***********************************************************************************************//**
+ *  \brief  Send a finished Si7013 measurement as Health Thermometer temperature measurement.
+ *  \details  Called from the main loop on APP_SIGNAL_SI7013_DATA.
+ **************************************************************************************************/
+void htmTempDataHandler(void)
+{
+  uint8_t htmTempBuffer[ATT_DEFAULT_PAYLOAD_LEN]; /* Stores the temperature data in the HTM format. */
+  uint8_t length;
+  int32_t tempData;
+  uint32_t rhData;
+  int32_t ret;
+
+  ret = si7013AsyncGetResult(&rhData, &tempData);
+  htmTempConverting = false;
+  if (!htmMeasRunning) {
+    return; /* Stopped while the transfer was queued */
+  }
+  if (ret == 1) {
+    /* Conversion still running, read again shortly */
+    htmTempConverting = true;
+    gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(HTM_SI7013_RETRY_MS), TEMP_TIMER, true);
+    return;
+  }
+  gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(HTM_SI7013_PERIOD_MS), TEMP_TIMER, true);
+  if (ret != 0) {
+    return;
+  }
+
+  /* The temperature read from the sensor is in milli-Celsius format */
+  if (HTM_FLAG_TEMP_UNIT_F == (htmTempMeas.flags & HTM_FLAG_TEMP_UNIT_MASK)) {
+    /* Conversion to Fahrenheit: F = C * 1.8 + 32
+     * Here multiplying with 18 instead of 1.8 will make the result 10^4 (e4) */
+    int32_t temp_e4 = tempData * 18 + 320000;
+    htmTempMeas.temperature = FLT_TO_UINT32(temp_e4, -4);
+  } else {
+    htmTempMeas.temperature = FLT_TO_UINT32(tempData, -3);
+  }
+  htmClockUpdate();
+  htmTempMeas.timestamp = htmDateTime;
   htmTempMeas.tempType = HTM_TT;
-  /* Build temperature measurement characteristic and store data length */
-  len = htmBuildTempMeas(buf, &htmTempMeas);
+  length = htmBuildTempMeas(htmTempBuffer, &htmTempMeas);
 
+  htmIndicateTemp(length, htmTempBuffer);
+}
 
-  /* Resonator frequency for Ch0 & CH1 should both appear on LCD display */
+/***********************************************************************************************//**
+ *  \brief  Select and store the ADC inputs acquired while measurements are running.
+ *  \param[in]  channelMask  ADC_SCAN_CH_xxx bits, 0 is ignored.
+ **************************************************************************************************/
+void htmSetAdcChannels(uint32_t channelMask)
+{
+  uint8_t value;
 
-  /*snprintf(freqString,
-           sizeof(HTM_FREQ_VALUE_TEXT_DEFAULT),
-           HTM_FREQ_VALUE_TEXT,
-		   (uint32_t)freqFLT0,
-           FLOAT_FRACTION_1STDIGIT(freqFLT0),
-		   (uint32_t)freqFLT1,
-           FLOAT_FRACTION_1STDIGIT(freqFLT1),
-		   len);*/
+  channelMask &= ADC_SCAN_CH_ALL;
+  if (channelMask == 0) {
+    return;
+  }
+  value = (uint8_t)channelMask;
+  gecko_cmd_flash_ps_save(HTM_ADC_CHANNELS_PS_KEY, 1, &value);
+  htmAdcChannels = channelMask;
 
-  /* Write the string to LCD */
-  //appUiWriteString(freqString);
-  /* Return the length of the data */
-#endif
-  return len;
+  /* Restart a running acquisition with the new selection */
+  if (htmMeasRunning) {
+    htmAdcStart();
+  }
 }
 
 /***********************************************************************************************//**
- *  \brief Function for taking a single temperature measurement with the WSTK Temperature sensor.
+ *  \brief  Drain the per-channel scan ring buffers.
+ *  \details  Called from the main loop on APP_SIGNAL_ADC_SCAN. PA0 feeds the beat detector, the
+ *  newest sample of every channel is kept.
  **************************************************************************************************/
-void htmFrequencyMeasure(void)
+void htmAdcScanHandler(void)
 {
-  //start = clock();
-  uint8_t htmFreqBuffer[ATT_DEFAULT_PAYLOAD_LEN]; /* Stores the temperature data in the HTM format. */
-  uint8_t hrmBuffer[12];
-  uint8_t length, length2; /* Length of the temperature measurement characteristic */
+  uint32_t ch;
+  uint16_t sample;
+
+  for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++) {
+    while (adcScanRead(ch, &sample)) {
+      if (adcDecimate(ch, sample, &htmAdcScanLatest[ch]) && (ch == 0)) {
+        htmHrSample(htmAdcScanLatest[0]);
+      }
+    }
+  }
+}
 
-  /* Check if the connection is still open */
-  if (HTM_NO_CONNECTION == htmClientConnection) {
+/***********************************************************************************************//**
+ *  \brief  Handle a write to the Heart Rate Control Point.
+ *  \param[in]  connection  Connection ID of the writer.
+ *  \param[in]  writeValue  Opcode followed by its parameters.
+ **************************************************************************************************/
+void htmControlPointWrite(uint8_t connection, uint8array *writeValue)
+{
+  uint32_t low, high;
+
+  if (writeValue->len == 0) {
     return;
   }
 
-  /* Create the temperature measurement characteristic in htmTempBuffer and store its length */
-  length = htmFreqMsg(htmFreqBuffer);
-  length2 = hrmBuildHrMeas(hrmBuffer, &hrMeas);
-  //hrMeas.time = millisec;
-  //hrMeas.adc = adcValue;
-
-  adcSingleScan(false);
+  switch (writeValue->data[0]) {
+    case HTM_CP_MONITOR_START:
+    case HTM_CP_MONITOR_WINDOW:
+      if (writeValue->len < HTM_CP_WINDOW_LEN) {
+        return;
+      }
+      low = adcFromMilliVolt(writeValue->data[1] | (writeValue->data[2] << 8), 12);
+      high = adcFromMilliVolt(writeValue->data[3] | (writeValue->data[4] << 8), 12);
+      if (writeValue->data[0] == HTM_CP_MONITOR_WINDOW) {
+        adcWindowSet(low, high);
+        return;
+      }
+
+      /* Nothing else runs while monitoring, so the device sleeps until an excursion. A rejected
+       * window leaves the measurements running. */
+      if (!adcWindowStart(low, high)) {
+        return;
+      }
+      if (htmMeasRunning) {
+        htmMeasStop();
+      }
+      appHwFreqSensEnable(false);
+      htmMonitorConnection = connection;
+      htmUpdateLink();
+      break;
+
+    case HTM_CP_ADC_PROFILE:
+      if (writeValue->len >= 2) {
+        htmSetAdcProfile(writeValue->data[1]);
+      }
+      break;
+
+    case HTM_CP_LDC_PROFILE:
+      if (writeValue->len >= 2) {
+        htmSetLdcProfile(writeValue->data[1]);
+      }
+      break;
+
+    case HTM_CP_STREAM_DEADLINE:
+      if (writeValue->len >= 3) {
+        streamSetDeadline(writeValue->data[1] | (writeValue->data[2] << 8));
+        htmUpdateLink();
+        htmStreamTick();
+      }
+      break;
+
+    case HTM_CP_NOTIFY_POLICY:
+      if ((writeValue->len >= 2) && (writeValue->data[1] <= NOTIFY_DROP_NEWEST)) {
+        notifySetDropPolicy((notifyDropPolicy_t)writeValue->data[1]);
+      }
+      break;
+
+    case HTM_CP_STREAM_FORMAT:
+      if ((writeValue->len >= 2) && (writeValue->data[1] <= STREAM_FORMAT_PACKED)) {
+        htmStreamFormat = writeValue->data[1];
+        htmApplyStreamFormat();
+      }
+      break;
+
+    case HTM_CP_SHOW_JITTER:
+      htmShowJitter();
+      break;
+
+    case HTM_CP_FILTER_SET:
+      if (writeValue->len >= 2) {
+        htmSetFilter(writeValue->data[1]);
+      }
+      break;
+
+    case HTM_CP_SHOW_FILTER:
+      htmShowFilter();
+      break;
+
+    case HTM_CP_SHOW_ADC_CYCLES:
+      htmShowAdcCycles();
+      break;
+
+    case HTM_CP_ADC_CHANNELS:
+      if (writeValue->len >= 2) {
+        htmSetAdcChannels(writeValue->data[1]);
+      }
+      break;
+
+    case HTM_CP_SHOW_LDC:
+      htmShowLdc();
+      break;
+
+    case HTM_CP_SHOW_STATS:
+      htmShowStats(connection);
+      break;
+
+    case HTM_CP_DEADBAND:
+      if (writeValue->len >= HTM_CP_DEADBAND_LEN) {
+        htmSetDeadband(writeValue->data[1], writeValue->data[2] | (writeValue->data[3] << 8));
+      }
+      break;
+
+    case HTM_CP_SAMPLE_PERIOD:
+      if (writeValue->len >= 3) {
+        htmSetSamplePeriod(writeValue->data[1] | (writeValue->data[2] << 8));
+      }
+      break;
+
+    case HTM_CP_SPECTRUM:
+      if ((writeValue->len >= 4)
+          && spectrumConfigure(writeValue->data[1], writeValue->data[2], writeValue->data[3],
+                               (writeValue->len >= 5 + writeValue->data[3])
+                               ? &writeValue->data[4] : NULL)) {
+        htmSpectrumRate();
+      }
+      break;
+
+    case HTM_CP_MONITOR_STOP:
+      htmMonitorStop();
+      break;
+
+    case HTM_CP_RESET_ENERGY_EXPENDED:
+    default:
+      break;
+  }
+}
 
-  //hrMeas.combo = (hrMeas.time << 8) | hrMeas.adc;
+/***********************************************************************************************//**
+ *  \brief  Select and store the ADC oversampling/decimation profile.
+ *  \param[in]  index  Profile index, 0 to ADC_OVS_PROFILES - 1.
+ **************************************************************************************************/
+void htmSetAdcProfile(uint8_t index)
+{
+  adcOvsInfo_t info;
+  char text[HTM_ADC_PROFILE_TEXT_SIZE];
 
-#ifdef print
-  testprint = ((float)hrMeas.adc * ADC_SE_VFS)/ 4096;
-  char *tmpSign = (testprint < 0) ? "-" : "";
-  float tmpVal = (testprint < 0) ? -testprint : testprint;
+  if (!adcOvsGetInfo(index, &info) || !adcOvsSelect(index)) {
+    return;
+  }
+  gecko_cmd_flash_ps_save(HTM_ADC_PROFILE_PS_KEY, 1, &index);
+  htmApplyStreamFormat();
+  htmHrDetectStart(); /* The output rate may have changed */
+
+  /* Show what the profile trades: effective resolution against output rate */
+  snprintf(text, sizeof(text), HTM_ADC_PROFILE_TEXT, index,
+           info.resolution / 10, info.resolution % 10,
+           (unsigned long)(info.rate / 1000), (unsigned long)(info.rate % 1000));
+  appUiWriteString(text);
+}
 
-  int tmpInt1 = tmpVal;                  // Get the integer (678).
-  float tmpFrac = tmpVal - tmpInt1;      // Get fraction (0.0123).
-  int tmpInt2 = trunc(tmpFrac * 10000);  // Turn into integer (123).
+/***********************************************************************************************//**
+ *  \brief  Select and store the LDC1612 acquisition profile.
+ *  \param[in]  index  Profile index, 0 to LDC_PROFILES - 1.
+ **************************************************************************************************/
+void htmSetLdcProfile(uint8_t index)
+{
+  const ldcProfile_t *profile = ldcProfileGet(index);
+  char text[HTM_LDC_PROFILE_TEXT_SIZE];
 
-    // Print as parts, note that you need 0-padding for fractional bit.
+  if (profile == NULL) {
+    return;
+  }
+  htmApplyLdcProfile(index);
+  gecko_cmd_flash_ps_save(HTM_LDC_PROFILE_PS_KEY, 1, &index);
 
-  char sampled[100];
-  sprintf (sampled, "Single PA0: = %s%d.%04dV\n", tmpSign, tmpInt1, tmpInt2);
-  appUiWriteString(sampled);
-#endif
+  snprintf(text, sizeof(text), HTM_LDC_PROFILE_TEXT, index, profile->name,
+           (unsigned long)ldcProfileConvTimeUs(profile, LDC1612_ACQ_CHANNELS));
+  appUiWriteString(text);
+}
 
-  //char time[32];
-  //snprintf(time, sizeof(HTM_TIME_VALUE_TEXT),HTM_TIME_VALUE_TEXT, millisec);
-  //appUiWriteString(time);
+/***********************************************************************************************//**
+ *  \brief  Select and store the filter coefficient set.
+ *  \param[in]  index  Set index, 0 to FILTER_SETS - 1.
+ **************************************************************************************************/
+void htmSetFilter(uint8_t index)
+{
+  if (!filterSelect(index)) {
+    return;
+  }
+  gecko_cmd_flash_ps_save(HTM_FILTER_PS_KEY, 1, &index);
+  htmApplyStreamFormat();
+  htmShowFilter();
+}
 
-  /* Send indication of the temperature in htmTempBuffer to all "listening" clients.
-   * This enables the Health Thermometer in the Blue Gecko app to display the temperature.
-   *  0xFF as connection ID will send indications to all connections. */
-  /*if (millisec % 20 == 0){
-	  gecko_cmd_gatt_server_send_characteristic_notification(
-			  htmClientConnection, gattdb_temperature_measurement, length, htmFreqBuffer);
-  }*/
+/***********************************************************************************************//**
+ *  \brief  Change and store the PA0 sample period.
+ *  \details  The acquisition keeps running, so no sample is lost or repeated. The beat detector and
+ *  the spectrum restart at the new rate, the connection parameters follow the spectrum frames.
+ *  \param[in]  ms  Period, see adcSetTriggerPeriod().
+ **************************************************************************************************/
+void htmSetSamplePeriod(uint16_t ms)
+{
+  adcOvsInfo_t info;
+  char text[HTM_SAMPLE_PERIOD_TEXT_SIZE];
+  uint8_t value[2];
 
-  //gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(htmTempMeas.period), MEAS_TIMER, true);
+  if (!adcSetTriggerPeriod(ms)) {
+    return;
+  }
+  value[0] = (uint8_t)ms;
+  value[1] = (uint8_t)(ms >> 8);
+  gecko_cmd_flash_ps_save(HTM_SAMPLE_PERIOD_PS_KEY, sizeof(value), value);
+  htmHrDetectStart();
+
+  adcOvsGetInfo(adcOvsGetSelected(), &info);
+  snprintf(text, sizeof(text), HTM_SAMPLE_PERIOD_TEXT, (unsigned long)ms,
+           (unsigned long)(info.rate / 1000), (unsigned long)(info.rate % 1000));
+  appUiWriteString(text);
+}
 
+/***********************************************************************************************//**
+ *  \brief  Change and store the Measurement Interval.
+ *  \param[in]  seconds  Interval, clamped to 1 to HTM_MEAS_INTERVAL_MAX_S.
+ **************************************************************************************************/
+void htmSetMeasInterval(uint16_t seconds)
+{
+  uint8_t value[2];
 
-  gecko_cmd_gatt_server_send_characteristic_notification(
-      htmClientConnection, gattdb_heart_rate_measurement, length2, hrmBuffer);
+  seconds = htmApplyMeasInterval(seconds);
+  value[0] = (uint8_t)seconds;
+  value[1] = (uint8_t)(seconds >> 8);
+  gecko_cmd_flash_ps_save(HTM_MEAS_INTERVAL_PS_KEY, sizeof(value), value);
+}
 
+/***********************************************************************************************//**
+ *  \brief  Apply a Measurement Interval.
+ *  \details  A running MEAS_TIMER is rescheduled from its last expiry, so the next measurement
+ *  follows the previous one by the new interval, or comes right away if that is already over.
+ *  \param[in]  seconds  Interval, clamped to 1 to HTM_MEAS_INTERVAL_MAX_S.
+ *  \return  The interval applied, also written back to the characteristic.
+ **************************************************************************************************/
+static uint16_t htmApplyMeasInterval(uint16_t seconds)
+{
+  uint32_t now;
+  uint8_t value[2];
 
-  /* Start the repeating timer */
-	//gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(htmTempMeas.period), MEAS_TIMER, true);
+  if (seconds == 0) {
+    seconds = 1;
+  } else if (seconds > HTM_MEAS_INTERVAL_MAX_S) {
+    seconds = HTM_MEAS_INTERVAL_MAX_S;
+  }
+  value[0] = (uint8_t)seconds;
+  value[1] = (uint8_t)(seconds >> 8);
+  gecko_cmd_gatt_server_write_attribute_value(gattdb_MeasInt, 0, sizeof(value), value);
+
+  htmMeasPeriodMs = seconds * 1000UL;
+  htmSetDeadband((uint8_t)htmHrDeadband.threshold, htmHrHeartbeatS);
+  if (htmMeasRunning) {
+    now = RTCC_CounterGet();
+    tickSchedInit(&htmMeasSched, htmMeasPeriodMs);
+    htmMeasDue = htmMeasLast + tickSchedNext(&htmMeasSched);
+    if ((int32_t)(htmMeasDue - now) <= 0) {
+      htmMeasDue = now;
+    }
+    htmMeasArm(now);
+  }
+  htmUpdateLink();
+  return seconds;
 }
 
-void getADCValue(uint32_t sample) {
-	hrMeas.adc = (uint16_t)sample;
+/***********************************************************************************************//**
+ *  \brief  Report a window excursion.
+ *  \details  Called from the main loop on APP_SIGNAL_ADC_WINDOW. Sends the samples leading up to
+ *  the excursion as a Sensor Excursion notification and re-arms the window compare.
+ **************************************************************************************************/
+void htmAdcWindowHandler(void)
+{
+  adcExcursion_t excursion;
+  const connInfo_t *info;
+  uint8_t buf[HTM_EXCURSION_LEN];
+  uint8_t *p = buf;
+  uint32_t i;
+
+  if (!adcWindowGetExcursion(&excursion)) {
+    return;
+  }
+
+  UINT8_TO_BITSTREAM(p, excursion.count);
+  UINT32_TO_BITSTREAM(p, excursion.timestamp);
+  for (i = 0; i < excursion.count; i++) {
+    UINT16_TO_BITSTREAM(p, excursion.data[i]);
+  }
+
+  info = connGet(htmMonitorConnection);
+  if ((info != NULL) && (info->subscriptions & CONN_SUB_EXCURSION)) {
+    notifySend(htmMonitorConnection, gattdb_sensor_excursion, (uint8_t)(p - buf), buf);
+  }
 }
 
+/***********************************************************************************************//**
+ *  \brief  MEAS_TIMER expired: schedule the next expiry, then take a measurement.
+ *  \details  Each expiry is armed against the ideal RTCC schedule rather than the previous
+ *  expiry, so event loop delays show up as jitter but never accumulate into drift.
+ **************************************************************************************************/
 void measTick(void)
 {
-	millisec = millisec + htmTempMeas.period;
-	//gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(htmTempMeas.period), MEAS_TIMER, true);
-	htmFrequencyMeasure();
+  uint32_t now = RTCC_CounterGet();
+
+  tickJitterUpdate(&htmMeasJitter, (int32_t)(now - htmMeasDue));
+  htmMeasLast = htmMeasDue;
+  /* Skip the periods that are already over after a long stall */
+  htmMeasDue = tickSchedAfter(&htmMeasSched, &htmMeasJitter, htmMeasDue, now);
+  htmMeasArm(now);
+  htmFrequencyMeasure();
 }
@@ -52,6 +52,60 @@ void htmInit(void);
  **************************************************************************************************/
 void htmTemperatureCharStatusChange(uint8_t connection, uint16_t clientConfig);
 
+/***********************************************************************************************//**
+ *  \brief  Temperature Measurement CCCD has changed event handler function.
+ *  \param[in]  connection  Connection ID.
+ *  \param[in]  clientConfig  New value of CCCD.
+ **************************************************************************************************/
+void htmTempMeasCharStatusChange(uint8_t connection, uint16_t clientConfig);
+
+/***********************************************************************************************//**
+ *  \brief  Temperature Measurement indication confirmed event handler function.
+ *  \param[in]  connection  Connection ID.
+ **************************************************************************************************/
+void htmTempMeasConfirmed(uint8_t connection);
+
+/***********************************************************************************************//**
+ *  \brief  Sensor Stream CCCD has changed event handler function.
+ *  \param[in]  connection  Connection ID.
+ *  \param[in]  clientConfig  New value of CCCD.
+ **************************************************************************************************/
+void htmStreamCharStatusChange(uint8_t connection, uint16_t clientConfig);
+
+/***********************************************************************************************//**
+ *  \brief  Sensor Spectrum CCCD has changed event handler function.
+ *  \param[in]  connection  Connection ID.
+ *  \param[in]  clientConfig  New value of CCCD.
+ **************************************************************************************************/
+void htmSpectrumCharStatusChange(uint8_t connection, uint16_t clientConfig);
+
+/***********************************************************************************************//**
+ *  \brief  Sensor Channels CCCD has changed event handler function.
+ *  \param[in]  connection  Connection ID.
+ *  \param[in]  clientConfig  New value of CCCD.
+ **************************************************************************************************/
+void htmChannelsCharStatusChange(uint8_t connection, uint16_t clientConfig);
+
+/***********************************************************************************************//**
+ *  \brief  Sensor Excursion CCCD has changed event handler function.
+ *  \param[in]  connection  Connection ID.
+ *  \param[in]  clientConfig  New value of CCCD.
+ **************************************************************************************************/
+void htmExcursionCharStatusChange(uint8_t connection, uint16_t clientConfig);
+
+/***********************************************************************************************//**
+ *  \brief  ATT MTU exchanged event handler function.
+ *  \param[in]  connection  Connection ID.
+ *  \param[in]  mtu  Negotiated ATT MTU.
+ **************************************************************************************************/
+void htmMtuExchanged(uint8_t connection, uint16_t mtu);
+
+/***********************************************************************************************//**
+ *  \brief  Connection closed while other connections stay open.
+ *  \param[in]  connection  Connection ID.
+ **************************************************************************************************/
+void htmConnectionClosed(uint8_t connection);
+
 /***********************************************************************************************//**
  *  \brief  Make one temperature measurement.
  **************************************************************************************************/
@@ -63,6 +117,84 @@ void measTick(void);
 
 void getADCValue(uint32_t sample);
 
+/***********************************************************************************************//**
+ *  \brief  Consume the ADC blocks completed by the continuous acquisition.
+ **************************************************************************************************/
+void htmAdcStreamHandler(void);
+
+/***********************************************************************************************//**
+ *  \brief  Collect the LDC1612 conversions read in the background.
+ **************************************************************************************************/
+void htmLdcDataHandler(void);
+
+/***********************************************************************************************//**
+ *  \brief  Flush overdue partial stream frames. Called when STREAM_TIMER expires.
+ **************************************************************************************************/
+void htmStreamTick(void);
+
+/***********************************************************************************************//**
+ *  \brief  Advance the Si7013 measurement cycle. Called when TEMP_TIMER expires.
+ **************************************************************************************************/
+void htmTempTick(void);
+
+/***********************************************************************************************//**
+ *  \brief  Send the Si7013 measurement read in the background.
+ **************************************************************************************************/
+void htmTempDataHandler(void);
+
+/***********************************************************************************************//**
+ *  \brief  Select and store the ADC inputs acquired while measurements are running.
+ *  \param[in]  channelMask  ADC_SCAN_CH_xxx bits.
+ **************************************************************************************************/
+void htmSetAdcChannels(uint32_t channelMask);
+
+/***********************************************************************************************//**
+ *  \brief  Handle a write to the Heart Rate Control Point.
+ *  \param[in]  connection  Connection ID of the writer.
+ *  \param[in]  writeValue  Opcode followed by its parameters.
+ **************************************************************************************************/
+void htmControlPointWrite(uint8_t connection, uint8array *writeValue);
+
+/***********************************************************************************************//**
+ *  \brief  Select and store the ADC oversampling/decimation profile.
+ *  \param[in]  index  Profile index, 0 to ADC_OVS_PROFILES - 1.
+ **************************************************************************************************/
+void htmSetAdcProfile(uint8_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Select and store the LDC1612 acquisition profile.
+ *  \param[in]  index  Profile index, 0 to LDC_PROFILES - 1.
+ **************************************************************************************************/
+void htmSetLdcProfile(uint8_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Change and store the PA0 sample period while the acquisition keeps running.
+ *  \param[in]  ms  Period, see adcSetTriggerPeriod().
+ **************************************************************************************************/
+void htmSetSamplePeriod(uint16_t ms);
+
+/***********************************************************************************************//**
+ *  \brief  Change and store the Measurement Interval, the time between heart rate measurements.
+ *  \param[in]  seconds  Interval in s.
+ **************************************************************************************************/
+void htmSetMeasInterval(uint16_t seconds);
+
+/***********************************************************************************************//**
+ *  \brief  Select and store the filter coefficient set applied to the ADC and LDC1612 samples.
+ *  \param[in]  index  Set index, 0 to FILTER_SETS - 1.
+ **************************************************************************************************/
+void htmSetFilter(uint8_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Report a captured ADC window excursion to the monitoring client.
+ **************************************************************************************************/
+void htmAdcWindowHandler(void);
+
+/***********************************************************************************************//**
+ *  \brief  Consume the per-channel samples of the multi-channel scan acquisition.
+ **************************************************************************************************/
+void htmAdcScanHandler(void);
+
 /** @} (end addtogroup htm) */
 /** @} (end addtogroup Services) */
 
@@ -0,0 +1,179 @@
+/***********************************************************************************************//**
+ * \file   i2c_async.c
+ * \brief  Queued, interrupt driven I2C0 transfers
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+
+#include "em_core.h"
+#include "em_i2c.h"
+
+/* Own header */
+#include "i2c_async.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup i2c_async
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Macros and Definitions
+ **************************************************************************************************/
+
+/** Interrupts that advance the emlib I2C_Transfer() state machine. */
+#define I2C_ASYNC_IEN   (I2C_IEN_ACK | I2C_IEN_NACK | I2C_IEN_RXDATAV | I2C_IEN_MSTOP \
+                         | I2C_IEN_ARBLOST | I2C_IEN_BUSERR | I2C_IEN_CLTO)
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+/** Waiting transfers; the one at tail owns the bus while i2cAsyncActive is set. */
+static i2cAsyncXfer_t *i2cAsyncQueue[I2C_ASYNC_QUEUE_SIZE];
+static uint32_t i2cAsyncHead = 0;
+static uint32_t i2cAsyncTail = 0;
+static volatile bool i2cAsyncActive = false;
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static void i2cAsyncStartNext(void);
+static bool i2cAsyncFinish(I2C_TransferReturn_TypeDef status);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+void i2cAsyncInit(void)
+{
+  I2C_IntDisable(I2C0, _I2C_IEN_MASK);
+  I2C_IntClear(I2C0, _I2C_IF_MASK);
+  I2C_BusFreqSet(I2C0, 0, I2C_ASYNC_BUS_FREQ, i2cClockHLRAsymetric);
+  i2cAsyncHead = 0;
+  i2cAsyncTail = 0;
+  i2cAsyncActive = false;
+  NVIC_ClearPendingIRQ(I2C0_IRQn);
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+bool i2cAsyncSetBusFreq(uint32_t freq)
+{
+  if (i2cAsyncActive) {
+    return false;
+  }
+  /* Fast-mode needs the 6:3 low/high ratio, Standard-mode works with 4:4 */
+  I2C_BusFreqSet(I2C0, 0, freq,
+                 (freq > I2C_FREQ_STANDARD_MAX) ? i2cClockHLRAsymetric : i2cClockHLRStandard);
+  return true;
+}
+
+bool i2cAsyncSubmit(i2cAsyncXfer_t *xfer)
+{
+  bool start;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if ((i2cAsyncHead - i2cAsyncTail) >= I2C_ASYNC_QUEUE_SIZE) {
+    CORE_EXIT_ATOMIC();
+    return false;
+  }
+  i2cAsyncQueue[i2cAsyncHead & (I2C_ASYNC_QUEUE_SIZE - 1)] = xfer;
+  i2cAsyncHead++;
+  start = !i2cAsyncActive;
+  i2cAsyncActive = true;
+  CORE_EXIT_ATOMIC();
+
+  /* Whoever sets i2cAsyncActive owns starting the bus */
+  if (start) {
+    i2cAsyncStartNext();
+  }
+  return true;
+}
+
+bool i2cAsyncBusy(void)
+{
+  return i2cAsyncActive;
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Start the transfer at the tail of the queue.
+ *  \details  Transfers that fail to start are completed with their error and skipped.
+ **************************************************************************************************/
+static void i2cAsyncStartNext(void)
+{
+  I2C_TransferReturn_TypeDef ret;
+
+  do {
+    /* Sends START and the address; everything after that happens in I2C0_IRQHandler() */
+    ret = I2C_TransferInit(I2C0, &i2cAsyncQueue[i2cAsyncTail & (I2C_ASYNC_QUEUE_SIZE - 1)]->seq);
+    if (ret == i2cTransferInProgress) {
+      I2C_IntEnable(I2C0, I2C_ASYNC_IEN);
+      return;
+    }
+  } while (i2cAsyncFinish(ret));
+}
+
+/***********************************************************************************************//**
+ *  \brief  Remove the transfer at the tail and run its callback.
+ *  \return  true if more transfers are waiting.
+ **************************************************************************************************/
+static bool i2cAsyncFinish(I2C_TransferReturn_TypeDef status)
+{
+  i2cAsyncXfer_t *xfer;
+  bool more;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  xfer = i2cAsyncQueue[i2cAsyncTail & (I2C_ASYNC_QUEUE_SIZE - 1)];
+  i2cAsyncTail++;
+  CORE_EXIT_ATOMIC();
+
+  /* The bus is still owned here, so transfers submitted by the callback only queue up */
+  if (xfer->cb != NULL) {
+    xfer->cb(status, xfer->ctx);
+  }
+
+  CORE_ENTER_ATOMIC();
+  more = (i2cAsyncTail != i2cAsyncHead);
+  i2cAsyncActive = more;
+  CORE_EXIT_ATOMIC();
+  return more;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Advance the running transfer, complete it and start the next one.
+ **************************************************************************************************/
+void I2C0_IRQHandler(void)
+{
+  I2C_TransferReturn_TypeDef ret;
+
+  ret = I2C_Transfer(I2C0);
+  if (ret == i2cTransferInProgress) {
+    return;
+  }
+
+  I2C_IntDisable(I2C0, I2C_ASYNC_IEN);
+  I2C_IntClear(I2C0, _I2C_IF_MASK);
+  if (i2cAsyncFinish(ret)) {
+    i2cAsyncStartNext();
+  }
+}
+
+/** @} (end addtogroup i2c_async) */
+/** @} (end addtogroup Application) */
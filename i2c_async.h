@@ -0,0 +1,104 @@
+/***********************************************************************************************//**
+ * \file   i2c_async.h
+ * \brief  Queued, interrupt driven I2C0 transfers
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef I2C_ASYNC_H
+#define I2C_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_i2c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup i2c_async I2C Async
+ * \brief Queue of non-blocking I2C0 transfers shared by the sensor drivers.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup i2c_async
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/** Transfers that can wait for the bus, power of 2. */
+#define I2C_ASYNC_QUEUE_SIZE            8
+
+/** SCL frequency set by i2cAsyncInit(). Si7013 and LDC1612 both support Fast-mode. */
+#define I2C_ASYNC_BUS_FREQ              I2C_FREQ_FAST_MAX
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** Completion callback, called from the I2C0 interrupt handler.
+ *  \param[in]  status  i2cTransferDone or the error that ended the transfer.
+ *  \param[in]  ctx  Context pointer of the transfer. */
+typedef void (*i2cAsyncCallback_t)(I2C_TransferReturn_TypeDef status, void *ctx);
+
+/** One queued transaction. Owned by the submitting driver and must stay untouched until its
+ *  callback has run. */
+typedef struct {
+  I2C_TransferSeq_TypeDef seq;          /**< Address, flags and buffers */
+  i2cAsyncCallback_t cb;                /**< Completion callback, may submit again */
+  void *ctx;                            /**< Passed to cb */
+} i2cAsyncXfer_t;
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Prepare I2C0 for queued, interrupt driven transfers at I2C_ASYNC_BUS_FREQ.
+ *  \details  I2CSPM_Init() must have run before.
+ **************************************************************************************************/
+void i2cAsyncInit(void);
+
+/***********************************************************************************************//**
+ *  \brief  Change the SCL frequency. Only takes effect while the bus is idle.
+ *  \param[in]  freq  SCL frequency in Hz, I2C_FREQ_STANDARD_MAX or I2C_FREQ_FAST_MAX.
+ *  \return  false if a transfer is running or queued.
+ **************************************************************************************************/
+bool i2cAsyncSetBusFreq(uint32_t freq);
+
+/***********************************************************************************************//**
+ *  \brief  Queue a transfer. It starts as soon as the transfers before it are done.
+ *  \details  Can be called from the main loop and from interrupt handlers, including completion
+ *  callbacks. If a transfer can not even be started, its callback runs with the error right away.
+ *  \param[in]  xfer  Transaction to run.
+ *  \return  false if the queue is full.
+ **************************************************************************************************/
+bool i2cAsyncSubmit(i2cAsyncXfer_t *xfer);
+
+/***********************************************************************************************//**
+ *  \brief  Check for running or queued transfers.
+ *  \return  true until the queue is empty and the bus idle.
+ **************************************************************************************************/
+bool i2cAsyncBusy(void);
+
+/** @} (end addtogroup i2c_async) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* I2C_ASYNC_H */
@@ -0,0 +1,390 @@
+/***********************************************************************************************//**
+ * \file   ldc1612_async.c
+ * \brief  LDC1612 data ready driven acquisition
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+
+/* BG stack headers */
+#include "native_gecko.h"
+
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_rtcc.h"
+#include "gpiointerrupt.h"
+#include "si7013.h"            /* LDC1612_ADDR */
+
+/* application specific headers */
+#include "app_signal.h"
+#include "i2c_async.h"
+
+/* Own header */
+#include "ldc1612_async.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup ldc1612_async
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+/** Acquisition profiles, fREF = 40 MHz. Settling is 4 us for all of them. */
+static const ldcProfile_t ldcProfiles[LDC_PROFILES] = {
+  { "fast",    0x0100, 0x000A, 0x1001 },  /* 102 us per channel, motion tracking */
+  { "motion",  0x0800, 0x000A, 0x1001 },  /* 819 us per channel */
+  { "default", 0x30D4, 0x000A, 0x1001 },  /* 5 ms per channel, about 10 ms for CH0 and CH1 */
+  { "static",  0xFFFF, 0x000A, 0x1001 }   /* 26 ms per channel, highest resolution */
+};
+
+/** Read sequence in progress, only touched from interrupt context while running. */
+static ldcSm_t ldcSm;
+static volatile bool ldcRunning = false;
+static volatile bool ldcReading = false;
+static uint8_t ldcRetries = 0;                  /* Restarts since the last complete sequence */
+static uint8_t ldcChannelMask = LDC1612_CH0;
+
+/** I2C transaction, queued with the other users of I2C0 */
+static i2cAsyncXfer_t ldcXfer;
+static uint8_t ldcTx[3];
+static uint8_t ldcRx[2];
+
+/** Results waiting for the main loop. The interrupt writes head, the main loop tail. */
+static ldcSample_t ldcQueue[LDC_SAMPLE_QUEUE_SIZE];
+static volatile uint32_t ldcQueueHead = 0;
+static volatile uint32_t ldcQueueTail = 0;
+static uint32_t ldcDrops = 0;
+static uint32_t ldcBusErrors = 0;
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static void ldcReadReg(uint8_t reg);
+static void ldcReadDone(I2C_TransferReturn_TypeDef status, void *ctx);
+static void ldcReadFailed(void);
+static void ldcConfigDone(I2C_TransferReturn_TypeDef status, void *ctx);
+static void ldcIntbCback(uint8_t pin);
+static void ldcBeginConversion(void);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+uint8_t ldcSmStart(ldcSm_t *sm, uint8_t channelMask, uint32_t timestamp)
+{
+  uint32_t ch;
+
+  if ((sm->pending == 0) || (sm->sample.channelMask != channelMask)) {
+    /* New sequence */
+    for (ch = 0; ch < LDC1612_CHANNELS; ch++) {
+      sm->sample.data[ch] = 0;
+    }
+    sm->sample.errors = 0;
+    sm->pending = 0;
+  }
+  sm->sample.channelMask = channelMask;
+  sm->sample.timestamp = timestamp;
+
+  /* STATUS first: reading it releases INTB and tells which channels have new data */
+  sm->steps = 1;
+  sm->step = 0;
+  sm->reg[0] = LDC1612_REG_STATUS;
+  return sm->reg[0];
+}
+
+bool ldcSmFeed(ldcSm_t *sm, uint16_t value, uint8_t *nextReg)
+{
+  uint8_t reg = sm->reg[sm->step];
+  uint8_t read;
+  uint32_t ch;
+
+  if (reg == LDC1612_REG_STATUS) {
+    sm->sample.status = value;
+
+    read = 0;
+    for (ch = 0; ch < LDC1612_CHANNELS; ch++) {
+      if (value & (LDC1612_STATUS_UNREADCONV0 >> ch)) {
+        read |= (1 << ch);
+      }
+    }
+    read &= sm->sample.channelMask;
+    if (read == 0) {
+      /* No unread flag for the wanted channels, read them all as before */
+      read = sm->sample.channelMask;
+    }
+
+    for (ch = 0; ch < LDC1612_CHANNELS; ch++) {
+      if (read & (1 << ch)) {
+        /* MSB before LSB, the LSB is latched by the MSB read */
+        sm->reg[sm->steps++] = LDC1612_REG_DATA0_MSB + (2 * ch);
+        sm->reg[sm->steps++] = LDC1612_REG_DATA0_LSB + (2 * ch);
+      }
+    }
+  } else {
+    ch = (reg - LDC1612_REG_DATA0_MSB) / 2;
+    if (((reg - LDC1612_REG_DATA0_MSB) & 1) == 0) {
+      sm->sample.data[ch] = (uint32_t)(value & LDC1612_DATA_MSB_MASK) << 16;
+      sm->sample.errors |= (uint8_t)(value >> LDC1612_DATA_ERR_SHIFT);
+    } else {
+      sm->sample.data[ch] |= value;
+      sm->pending |= (1 << ch);
+    }
+  }
+
+  if (++sm->step >= sm->steps) {
+    return false;
+  }
+  *nextReg = sm->reg[sm->step];
+  return true;
+}
+
+bool ldcSmTake(ldcSm_t *sm, ldcSample_t *sample)
+{
+  if ((sm->pending & sm->sample.channelMask) != sm->sample.channelMask) {
+    return false;
+  }
+  *sample = sm->sample;
+  sm->pending = 0;
+  return true;
+}
+
+const ldcProfile_t *ldcProfileGet(uint8_t index)
+{
+  if (index >= LDC_PROFILES) {
+    return NULL;
+  }
+  return &ldcProfiles[index];
+}
+
+uint32_t ldcProfileConvTimeUs(const ldcProfile_t *profile, uint8_t channelMask)
+{
+  uint32_t fref, cycles, channels, ns;
+
+  fref = profile->clockDividers & LDC1612_CLOCK_DIVIDERS_FREF_MASK;
+  fref = LDC1612_FCLK_HZ / (fref ? fref : 1);
+  channels = ((channelMask & LDC1612_CH0) ? 1 : 0) + ((channelMask & LDC1612_CH1) ? 1 : 0);
+
+  /* Conversion (RCOUNT * 16 + 4), settling (SETTLECOUNT * 16) and channel switch (5 fREF
+   * cycles plus 692 ns) per channel */
+  cycles = (profile->rcount * 16UL) + 4 + (profile->settleCount * 16UL) + 5;
+  ns = (uint32_t)(((uint64_t)cycles * 1000000000UL + fref - 1) / fref) + 692;
+  return ((channels * ns) + 999) / 1000;
+}
+
+bool ldcAsyncStart(uint8_t channelMask)
+{
+  channelMask &= (LDC1612_CH0 | LDC1612_CH1);
+  if (channelMask == 0) {
+    return false;
+  }
+  ldcChannelMask = channelMask;
+  ldcSm.pending = 0;
+  ldcQueueHead = 0;
+  ldcQueueTail = 0;
+  ldcDrops = 0;
+  ldcBusErrors = 0;
+  ldcRetries = 0;
+
+  /* INTB is open drain */
+  GPIO_PinModeSet(LDC1612_INTB_PORT, LDC1612_INTB_PIN, gpioModeInputPull, 1);
+  GPIOINT_CallbackRegister(LDC1612_INTB_PIN, ldcIntbCback);
+
+  /* Route data ready to INTB; the edge interrupt is enabled when this write completes */
+  ldcTx[0] = LDC1612_REG_ERROR_CONFIG;
+  ldcTx[1] = 0;
+  ldcTx[2] = LDC1612_ERROR_CONFIG_DRDY_2INT;
+  ldcXfer.seq.addr = LDC1612_ADDR;
+  ldcXfer.seq.flags = I2C_FLAG_WRITE;
+  ldcXfer.seq.buf[0].data = ldcTx;
+  ldcXfer.seq.buf[0].len = 3;
+  ldcXfer.seq.buf[1].data = NULL;
+  ldcXfer.seq.buf[1].len = 0;
+  ldcXfer.cb = ldcConfigDone;
+  ldcXfer.ctx = NULL;
+  return i2cAsyncSubmit(&ldcXfer);
+}
+
+void ldcAsyncStop(void)
+{
+  GPIO_ExtIntConfig(LDC1612_INTB_PORT, LDC1612_INTB_PIN, LDC1612_INTB_PIN, false, true, false);
+  ldcRunning = false;
+}
+
+void ldcAsyncResume(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  /* The INTB edge interrupt competes for ldcReading */
+  CORE_ENTER_ATOMIC();
+  ldcRetries = 0;
+  if (GPIO_PinInGet(LDC1612_INTB_PORT, LDC1612_INTB_PIN) == 0) {
+    ldcBeginConversion();
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+bool ldcAsyncGetSample(ldcSample_t *sample)
+{
+  uint32_t tail = ldcQueueTail;
+
+  if (tail == ldcQueueHead) {
+    return false;
+  }
+  *sample = ldcQueue[tail & (LDC_SAMPLE_QUEUE_SIZE - 1)];
+  ldcQueueTail = tail + 1;
+  return true;
+}
+
+uint32_t ldcAsyncGetDrops(void)
+{
+  return ldcDrops;
+}
+
+uint32_t ldcAsyncGetBusErrors(void)
+{
+  return ldcBusErrors;
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Start reading one 16 bit register.
+ **************************************************************************************************/
+static void ldcReadReg(uint8_t reg)
+{
+  ldcTx[0] = reg;
+  ldcXfer.seq.addr = LDC1612_ADDR;
+  ldcXfer.seq.flags = I2C_FLAG_WRITE_READ;
+  ldcXfer.seq.buf[0].data = ldcTx;
+  ldcXfer.seq.buf[0].len = 1;
+  ldcXfer.seq.buf[1].data = ldcRx;
+  ldcXfer.seq.buf[1].len = 2;
+  ldcXfer.cb = ldcReadDone;
+  ldcXfer.ctx = NULL;
+  if (!i2cAsyncSubmit(&ldcXfer)) {
+    ldcReadFailed();
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  A register read was NACKed, failed on the bus or found the I2C queue full.
+ *  \details  The sequence restarts from STATUS: channels already read stay pending, the UNREADCONV
+ *  flags tell which are left, and the timestamp stays that of the data ready edge. Once
+ *  LDC_READ_RETRIES restarts failed as well the main loop is signalled, since INTB may stay low
+ *  without another edge. Interrupt context.
+ **************************************************************************************************/
+static void ldcReadFailed(void)
+{
+  ldcBusErrors++;
+  if (!ldcRunning) {
+    ldcReading = false;
+    return;
+  }
+  if (ldcRetries < LDC_READ_RETRIES) {
+    ldcRetries++;
+    ldcReadReg(ldcSmStart(&ldcSm, ldcChannelMask, ldcSm.sample.timestamp));
+    return;
+  }
+  ldcReading = false;
+  gecko_external_signal(APP_SIGNAL_LDC_STALL);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Start the read sequence of a conversion. Interrupt context.
+ **************************************************************************************************/
+static void ldcBeginConversion(void)
+{
+  if (!ldcRunning || ldcReading) {
+    return;
+  }
+  ldcReading = true;
+  ldcReadReg(ldcSmStart(&ldcSm, ldcChannelMask, RTCC_CounterGet()));
+}
+
+/***********************************************************************************************//**
+ *  \brief  Data ready edge on INTB.
+ **************************************************************************************************/
+static void ldcIntbCback(uint8_t pin)
+{
+  (void)pin;
+  ldcBeginConversion();
+}
+
+/***********************************************************************************************//**
+ *  \brief  ERROR_CONFIG written, start listening to INTB.
+ **************************************************************************************************/
+static void ldcConfigDone(I2C_TransferReturn_TypeDef status, void *ctx)
+{
+  (void)ctx;
+  if (status != i2cTransferDone) {
+    ldcBusErrors++;
+    return;
+  }
+
+  ldcRunning = true;
+  GPIO_ExtIntConfig(LDC1612_INTB_PORT, LDC1612_INTB_PIN, LDC1612_INTB_PIN, false, true, true);
+
+  /* A conversion may already be waiting, in which case there will be no edge */
+  if (GPIO_PinInGet(LDC1612_INTB_PORT, LDC1612_INTB_PIN) == 0) {
+    ldcBeginConversion();
+  }
+}
+
+/***********************************************************************************************//**
+ *  \brief  One register read finished. Runs the sequence and queues the result. Interrupt context.
+ **************************************************************************************************/
+static void ldcReadDone(I2C_TransferReturn_TypeDef status, void *ctx)
+{
+  uint8_t nextReg;
+  uint32_t head;
+  ldcSample_t dropped;
+
+  (void)ctx;
+  if (status != i2cTransferDone) {
+    ldcReadFailed();
+    return;
+  }
+
+  if (ldcSmFeed(&ldcSm, (uint16_t)((ldcRx[0] << 8) | ldcRx[1]), &nextReg)) {
+    ldcReadReg(nextReg);
+    return;
+  }
+  ldcReading = false;
+  ldcRetries = 0;
+
+  if (ldcRunning) {
+    /* Queue the result once every channel of the sequence has been read */
+    head = ldcQueueHead;
+    if ((head - ldcQueueTail) >= LDC_SAMPLE_QUEUE_SIZE) {
+      if (ldcSmTake(&ldcSm, &dropped)) {
+        ldcDrops++;
+      }
+    } else if (ldcSmTake(&ldcSm, &ldcQueue[head & (LDC_SAMPLE_QUEUE_SIZE - 1)])) {
+      ldcQueueHead = head + 1;
+      gecko_external_signal(APP_SIGNAL_LDC_DATA);
+    }
+
+    /* INTB still low means the next conversion finished while this one was read */
+    if (GPIO_PinInGet(LDC1612_INTB_PORT, LDC1612_INTB_PIN) == 0) {
+      ldcBeginConversion();
+    }
+  }
+}
+
+/** @} (end addtogroup ldc1612_async) */
+/** @} (end addtogroup Application) */
@@ -0,0 +1,224 @@
+/***********************************************************************************************//**
+ * \file   ldc1612_async.h
+ * \brief  LDC1612 data ready driven acquisition
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef LDC1612_ASYNC_H
+#define LDC1612_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup ldc1612_async LDC1612 Async
+ * \brief Reads LDC1612 conversions on INTB without blocking the main loop.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup ldc1612_async
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/* LDC1612 registers, all 16 bit, MSB first on the bus */
+#define LDC1612_REG_DATA0_MSB           0x00
+#define LDC1612_REG_DATA0_LSB           0x01
+#define LDC1612_REG_DATA1_MSB           0x02
+#define LDC1612_REG_DATA1_LSB           0x03
+#define LDC1612_REG_RCOUNT0             0x08
+#define LDC1612_REG_RCOUNT1             0x09
+#define LDC1612_REG_SETTLECOUNT0        0x10
+#define LDC1612_REG_SETTLECOUNT1        0x11
+#define LDC1612_REG_CLOCK_DIVIDERS0     0x14
+#define LDC1612_REG_CLOCK_DIVIDERS1     0x15
+#define LDC1612_REG_STATUS              0x18
+#define LDC1612_REG_ERROR_CONFIG        0x19
+#define LDC1612_REG_CONFIG              0x1A
+#define LDC1612_REG_MUX_CONFIG          0x1B
+#define LDC1612_REG_RESET_DEV           0x1C
+#define LDC1612_REG_DRIVE_CURRENT0      0x1E
+#define LDC1612_REG_DRIVE_CURRENT1      0x1F
+
+/* Register fields */
+#define LDC1612_STATUS_DRDY             (1 << 6)
+#define LDC1612_STATUS_UNREADCONV0      (1 << 3)    /* UNREADCONV1 is bit 2 */
+#define LDC1612_CONFIG_ACTIVE_CHAN_MASK 0xC000
+#define LDC1612_CONFIG_ACTIVE_CHAN_SHIFT 14
+#define LDC1612_CONFIG_SLEEP_MODE_EN    (1 << 13)
+#define LDC1612_MUX_AUTOSCAN_EN         (1 << 15)
+#define LDC1612_MUX_RR_SEQUENCE_MASK    0x6000      /* 00: CH0, CH1 */
+#define LDC1612_ERROR_CONFIG_DRDY_2INT  (1 << 0)
+#define LDC1612_DATA_MSB_MASK           0x0FFF      /* Upper 12 bits of the 28 bit result */
+#define LDC1612_DATA_ERR_SHIFT          12          /* ERR_UR, ERR_OR, ERR_WD, ERR_AE */
+
+#define LDC1612_CHANNELS                2
+#define LDC1612_CH0                     (1 << 0)
+#define LDC1612_CH1                     (1 << 1)
+
+/** Channels acquired by this deployment. Both coils are converted in one autoscan sequence;
+ *  boards with a single coil build with -DLDC1612_ACQ_CHANNELS=LDC1612_CH0. */
+#ifndef LDC1612_ACQ_CHANNELS
+#define LDC1612_ACQ_CHANNELS            (LDC1612_CH0 | LDC1612_CH1)
+#endif
+
+/* INTB, open drain and active low. Wired to the expansion header. */
+#define LDC1612_INTB_PORT               gpioPortD
+#define LDC1612_INTB_PIN                13
+
+/** Reference clock on the CLKIN pin. */
+#define LDC1612_FCLK_HZ                 40000000UL
+#define LDC1612_CLOCK_DIVIDERS_FREF_MASK 0x03FF
+
+/** Acquisition profiles, see ldcProfileGet(). */
+#define LDC_PROFILES                    4
+#define LDC_PROFILE_DEFAULT             2
+
+/** Register reads per conversion: STATUS plus MSB and LSB of each channel. */
+#define LDC_SM_MAX_READS                (1 + (2 * LDC1612_CHANNELS))
+
+/** Samples buffered between the interrupt and the main loop, power of 2. */
+#define LDC_SAMPLE_QUEUE_SIZE           4
+
+/** Restarts of a read sequence from STATUS right after an I2C error. After that the sequence is
+ *  abandoned with APP_SIGNAL_LDC_STALL and ldcAsyncResume() tries again LDC_RETRY_MS later. */
+#define LDC_READ_RETRIES                3
+#define LDC_RETRY_MS                    5
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** One conversion result. With several channels, one result holds a complete autoscan
+ *  sequence and all channels share its timestamp. */
+typedef struct {
+  uint32_t timestamp;                   /**< RTCC counter at the INTB edge completing the sequence */
+  uint32_t data[LDC1612_CHANNELS];      /**< 28 bit results, valid for channels in channelMask */
+  uint8_t channelMask;                  /**< LDC1612_CHx bits */
+  uint8_t errors;                       /**< Error bits from the DATA MSB registers, ORed */
+  uint16_t status;                      /**< STATUS register */
+} ldcSample_t;
+
+/** Conversion settings that trade resolution against sample rate. The clock dividers have to
+ *  match LDC_CONV_FIN_DIVIDER in ldc_conv.h, so every profile uses the same ones. */
+typedef struct {
+  const char *name;                     /**< Shown on the display */
+  uint16_t rcount;                      /**< RCOUNTx, conversion time in 16 fREF cycles */
+  uint16_t settleCount;                 /**< SETTLECOUNTx, settling time in 16 fREF cycles */
+  uint16_t clockDividers;               /**< CLOCK_DIVIDERSx, FIN_DIVIDER and FREF_DIVIDER */
+} ldcProfile_t;
+
+/** Read sequence of one conversion. Hardware independent so that it can be driven by a
+ *  simulated register model as well as by the I2C interrupt. */
+typedef struct {
+  uint8_t reg[LDC_SM_MAX_READS];        /**< Registers to read, in order */
+  uint8_t steps;                        /**< Entries in reg */
+  uint8_t step;                         /**< Index of the register being read */
+  uint8_t pending;                      /**< Channels of sample collected so far */
+  ldcSample_t sample;                   /**< Result being assembled */
+} ldcSm_t;
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Begin the read sequence after a data ready edge.
+ *  \details  STATUS is read first; its unread conversion flags select the channels read next.
+ *  Channels collected on earlier edges are kept until the whole channelMask is present.
+ *  \param[in]  channelMask  LDC1612_CHx bits to read.
+ *  \param[in]  timestamp  Time of the data ready edge.
+ *  \return  First register to read.
+ **************************************************************************************************/
+uint8_t ldcSmStart(ldcSm_t *sm, uint8_t channelMask, uint32_t timestamp);
+
+/***********************************************************************************************//**
+ *  \brief  Feed the value of the register requested last.
+ *  \param[in]  value  Register value.
+ *  \param[out]  nextReg  Next register to read, if any.
+ *  \return  true if another register must be read, false when the reads of this edge are done.
+ **************************************************************************************************/
+bool ldcSmFeed(ldcSm_t *sm, uint16_t value, uint8_t *nextReg);
+
+/***********************************************************************************************//**
+ *  \brief  Check whether sm->sample holds every channel, and start a new one if so.
+ *  \param[out]  sample  Complete result.
+ *  \return  true if sample was written.
+ **************************************************************************************************/
+bool ldcSmTake(ldcSm_t *sm, ldcSample_t *sample);
+
+/***********************************************************************************************//**
+ *  \brief  Look up an acquisition profile.
+ *  \param[in]  index  Profile index, 0 to LDC_PROFILES - 1.
+ *  \return  The profile, or NULL for an invalid index.
+ **************************************************************************************************/
+const ldcProfile_t *ldcProfileGet(uint8_t index);
+
+/***********************************************************************************************//**
+ *  \brief  Time from one data ready to the next with a profile.
+ *  \param[in]  channelMask  LDC1612_CHx bits converted in sequence.
+ *  \return  Conversion time in us, rounded up.
+ **************************************************************************************************/
+uint32_t ldcProfileConvTimeUs(const ldcProfile_t *profile, uint8_t channelMask);
+
+/***********************************************************************************************//**
+ *  \brief  Enable data ready on INTB and start reading every conversion in the background.
+ *  \param[in]  channelMask  LDC1612_CHx bits to read.
+ *  \return  false if the I2C queue is full.
+ **************************************************************************************************/
+bool ldcAsyncStart(uint8_t channelMask);
+
+/***********************************************************************************************//**
+ *  \brief  Stop reading conversions. A read in progress is completed and discarded.
+ **************************************************************************************************/
+void ldcAsyncStop(void);
+
+/***********************************************************************************************//**
+ *  \brief  Read the conversion INTB still signals after a read sequence was abandoned, see
+ *  LDC_READ_RETRIES. Call from the main loop some time after APP_SIGNAL_LDC_STALL.
+ *  \details  Without it a missed STATUS read leaves INTB low, and no edge ever comes again.
+ **************************************************************************************************/
+void ldcAsyncResume(void);
+
+/***********************************************************************************************//**
+ *  \brief  Take the oldest conversion result. Call on APP_SIGNAL_LDC_DATA.
+ *  \param[out]  sample  Conversion result.
+ *  \return  false if no result is waiting.
+ **************************************************************************************************/
+bool ldcAsyncGetSample(ldcSample_t *sample);
+
+/***********************************************************************************************//**
+ *  \brief  Number of results dropped because the main loop did not collect them in time.
+ **************************************************************************************************/
+uint32_t ldcAsyncGetDrops(void);
+
+/***********************************************************************************************//**
+ *  \brief  Number of register reads that failed with an I2C error or a full I2C queue.
+ **************************************************************************************************/
+uint32_t ldcAsyncGetBusErrors(void);
+
+/** @} (end addtogroup ldc1612_async) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* LDC1612_ASYNC_H */
@@ -0,0 +1,115 @@
+/*
+ * ldc_conv.h
+ *
+ *  Integer conversion of LDC1612 codes to sensor frequency and coil
+ *  inductance. The inductance table is computed by the compiler from the
+ *  parameters below, so nothing but integer arithmetic runs on the target.
+ *  Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef LDC_CONV_H_
+#define LDC_CONV_H_
+#include <stdint.h>
+
+/* Converter and sensor parameters, override per board */
+#ifndef LDC_CONV_FREF_HZ
+#define LDC_CONV_FREF_HZ        40000000UL              /* fREF, 0.149 Hz/LSB = fREF / 2^28 */
+#endif
+#ifndef LDC_CONV_FIN_DIVIDER
+#define LDC_CONV_FIN_DIVIDER    1UL                     /* CLOCK_DIVIDERS FIN_DIVIDER */
+#endif
+#ifndef LDC_CONV_TANK_PF
+#define LDC_CONV_TANK_PF        100.0                   /* Sensor tank capacitance in pF */
+#endif
+#ifndef LDC_CONV_L_FMIN_HZ
+#define LDC_CONV_L_FMIN_HZ      3000000UL               /* Lowest tabulated sensor frequency */
+#endif
+#ifndef LDC_CONV_L_STEP_LOG2
+#define LDC_CONV_L_STEP_LOG2    15                      /* Table step, 32.768 kHz */
+#endif
+
+#define LDC_CONV_CODE_BITS      28
+#define LDC_CONV_L_SEGMENTS     64
+#define LDC_CONV_L_FMAX_HZ      (LDC_CONV_L_FMIN_HZ + ((uint32_t)LDC_CONV_L_SEGMENTS << LDC_CONV_L_STEP_LOG2))
+
+/* L = 1 / (C * (2 * pi * f)^2) in nH. Only used in constant expressions. */
+#define LDC_CONV_PI             3.14159265358979323846
+#define LDC_CONV_L_NH(f)        ((uint32_t)(1.0e21 / (LDC_CONV_TANK_PF * 4.0 * LDC_CONV_PI * LDC_CONV_PI \
+                                                      * (double)(f) * (double)(f)) + 0.5))
+#define LDC_CONV_L_ENTRY(i)     LDC_CONV_L_NH(LDC_CONV_L_FMIN_HZ + ((uint32_t)(i) << LDC_CONV_L_STEP_LOG2))
+#define LDC_CONV_L_ROW(i)       LDC_CONV_L_ENTRY(i), LDC_CONV_L_ENTRY((i) + 1), LDC_CONV_L_ENTRY((i) + 2), \
+                                LDC_CONV_L_ENTRY((i) + 3), LDC_CONV_L_ENTRY((i) + 4), LDC_CONV_L_ENTRY((i) + 5), \
+                                LDC_CONV_L_ENTRY((i) + 6), LDC_CONV_L_ENTRY((i) + 7)
+
+/* Inductance in nH at LDC_CONV_L_FMIN_HZ + i * step, LDC_CONV_L_SEGMENTS + 1 points */
+static const uint32_t ldcConvInductanceTable[LDC_CONV_L_SEGMENTS + 1] =
+{
+  LDC_CONV_L_ROW(0),  LDC_CONV_L_ROW(8),  LDC_CONV_L_ROW(16), LDC_CONV_L_ROW(24),
+  LDC_CONV_L_ROW(32), LDC_CONV_L_ROW(40), LDC_CONV_L_ROW(48), LDC_CONV_L_ROW(56),
+  LDC_CONV_L_ENTRY(64)
+};
+
+/**************************************************************************//**
+ * @brief Sensor frequency of a conversion, fSENSOR = FIN_DIVIDER * fREF * code / 2^28.
+ * @param[in] code
+ *   28 bit conversion result.
+ * @return
+ *   Frequency in 0.1 Hz, rounded.
+ *****************************************************************************/
+static inline uint32_t ldcConvToDeciHz(uint32_t code)
+{
+  return (uint32_t)(((uint64_t)code * (LDC_CONV_FREF_HZ * LDC_CONV_FIN_DIVIDER * 10)
+                     + (1UL << (LDC_CONV_CODE_BITS - 1))) >> LDC_CONV_CODE_BITS);
+}
+
+/**************************************************************************//**
+ * @brief Sensor frequency of a conversion in Hz, truncated.
+ *****************************************************************************/
+static inline uint32_t ldcConvToHz(uint32_t code)
+{
+  return (uint32_t)(((uint64_t)code * (LDC_CONV_FREF_HZ * LDC_CONV_FIN_DIVIDER)) >> LDC_CONV_CODE_BITS);
+}
+
+/**************************************************************************//**
+ * @brief Coil inductance at a sensor frequency, linearly interpolated
+ *   from ldcConvInductanceTable.
+ * @param[in] hz
+ *   Sensor frequency, clamped to the tabulated range.
+ * @return
+ *   Inductance in nH.
+ *****************************************************************************/
+static inline uint32_t ldcConvHzToNanoHenry(uint32_t hz)
+{
+  uint32_t offs, i, frac;
+  int32_t lo, hi;
+
+  if (hz <= LDC_CONV_L_FMIN_HZ)
+  {
+    return ldcConvInductanceTable[0];
+  }
+  if (hz >= LDC_CONV_L_FMAX_HZ)
+  {
+    return ldcConvInductanceTable[LDC_CONV_L_SEGMENTS];
+  }
+
+  offs = hz - LDC_CONV_L_FMIN_HZ;
+  i = offs >> LDC_CONV_L_STEP_LOG2;
+  frac = offs & ((1UL << LDC_CONV_L_STEP_LOG2) - 1);
+  lo = (int32_t)ldcConvInductanceTable[i];
+  hi = (int32_t)ldcConvInductanceTable[i + 1];
+  return (uint32_t)(lo + (int32_t)(((int64_t)(hi - lo) * frac) >> LDC_CONV_L_STEP_LOG2));
+}
+
+/**************************************************************************//**
+ * @brief Coil inductance of a conversion.
+ * @param[in] code
+ *   28 bit conversion result.
+ * @return
+ *   Inductance in nH.
+ *****************************************************************************/
+static inline uint32_t ldcConvToNanoHenry(uint32_t code)
+{
+  return ldcConvHzToNanoHenry(ldcConvToHz(code));
+}
+
+#endif /* LDC_CONV_H_ */
@@ -41,6 +41,7 @@
 #include "bsp_trace.h"
 
 #include "adc.h"
+#include "conn.h"          /* MAX_CONNECTIONS */
 /***********************************************************************************************//**
  * @addtogroup Application
  * @{
@@ -51,9 +52,6 @@
  * @{
  **************************************************************************************************/
 
-#ifndef MAX_CONNECTIONS
-#define MAX_CONNECTIONS 4
-#endif
 uint8_t bluetooth_stack_heap[DEFAULT_BLUETOOTH_HEAP(MAX_CONNECTIONS)];
 
 // Gecko configuration parameters (see gecko_configuration.h)
@@ -0,0 +1,230 @@
+/***********************************************************************************************//**
+ * \file   notify.c
+ * \brief  Outgoing notification queue
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+/* BG stack headers */
+#include "bg_types.h"
+#include "native_gecko.h"
+
+/* application specific files */
+#include "app_timer.h"
+#include "conn.h"
+
+/* Own header */
+#include "notify.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup notify
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Macros and Definitions
+ **************************************************************************************************/
+
+/** Retry delay when the connection interval is not known yet, the shortest interval. */
+#define NOTIFY_RETRY_INTERVAL           6
+
+/** Connection interval (1.25 ms units) to timer ticks, 32768 * 1.25 / 1000 = 40.96. */
+#define NOTIFY_INTERVAL_2_TIMERTICK(i)  (((uint32_t)(i) * 4096) / 100)
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+typedef struct {
+  uint8_t connection;
+  uint8_t len;
+  uint16_t characteristic;
+  uint8_t value[NOTIFY_MAX_LEN];
+} notifyEntry_t;
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+static notifyEntry_t notifyQueue[NOTIFY_QUEUE_SIZE];
+static uint8_t notifyHead = 0;                       /* Oldest entry */
+static uint8_t notifyCount = 0;
+static notifyDropPolicy_t notifyPolicy = NOTIFY_DROP_OLDEST;
+static notifyStats_t notifyStats;
+static bool notifyTimerArmed = false;
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static bool notifyTransmit(uint8_t connection, uint16_t characteristic, uint8_t len,
+                           const uint8_t *value, bool *dropped);
+static void notifyArmRetry(void);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+void notifyInit(void)
+{
+  notifyHead = 0;
+  notifyCount = 0;
+  memset(&notifyStats, 0, sizeof(notifyStats));
+  if (notifyTimerArmed) {
+    gecko_cmd_hardware_set_soft_timer(TIMER_STOP, NOTIFY_TIMER, true);
+    notifyTimerArmed = false;
+  }
+}
+
+void notifySetDropPolicy(notifyDropPolicy_t policy)
+{
+  notifyPolicy = policy;
+}
+
+bool notifySend(uint8_t connection, uint16_t characteristic, uint8_t len, const uint8_t *value)
+{
+  notifyEntry_t *entry;
+  bool dropped;
+
+  if (len > NOTIFY_MAX_LEN) {
+    notifyStats.failed++;
+    return false;
+  }
+
+  if (notifyCount == 0) {
+    if (notifyTransmit(connection, characteristic, len, value, &dropped)) {
+      return !dropped;
+    }
+    notifyStats.retried++;
+  }
+
+  if (notifyCount == NOTIFY_QUEUE_SIZE) {
+    if (notifyPolicy == NOTIFY_DROP_NEWEST) {
+      notifyStats.droppedNewest++;
+      return false;
+    }
+    notifyHead = (notifyHead + 1) % NOTIFY_QUEUE_SIZE;
+    notifyCount--;
+    notifyStats.droppedOldest++;
+  }
+
+  entry = &notifyQueue[(notifyHead + notifyCount) % NOTIFY_QUEUE_SIZE];
+  entry->connection = connection;
+  entry->characteristic = characteristic;
+  entry->len = len;
+  memcpy(entry->value, value, len);
+  notifyCount++;
+
+  notifyArmRetry();
+  return true;
+}
+
+void notifyDrain(void)
+{
+  notifyEntry_t *entry;
+  bool dropped;
+
+  notifyTimerArmed = false;
+  while (notifyCount > 0) {
+    entry = &notifyQueue[notifyHead];
+    if (!notifyTransmit(entry->connection, entry->characteristic, entry->len, entry->value,
+                        &dropped)) {
+      notifyStats.retried++;
+      break;
+    }
+    notifyHead = (notifyHead + 1) % NOTIFY_QUEUE_SIZE;
+    notifyCount--;
+  }
+  notifyArmRetry();
+}
+
+void notifyConnectionClosed(uint8_t connection)
+{
+  uint8_t kept = 0;
+  uint8_t i;
+  notifyEntry_t *from;
+  notifyEntry_t *to;
+
+  /* Compact the survivors towards the head, order is kept */
+  for (i = 0; i < notifyCount; i++) {
+    from = &notifyQueue[(notifyHead + i) % NOTIFY_QUEUE_SIZE];
+    if (from->connection == connection) {
+      continue;
+    }
+    to = &notifyQueue[(notifyHead + kept) % NOTIFY_QUEUE_SIZE];
+    if (to != from) {
+      memcpy(to, from, sizeof(*to));
+    }
+    kept++;
+  }
+  notifyCount = kept;
+}
+
+void notifyGetStats(notifyStats_t *stats)
+{
+  *stats = notifyStats;
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Hand a notification to the stack.
+ *  \param[out]  dropped  Set if the stack rejected it for a reason a retry does not fix.
+ *  \return  false if it has to be retried.
+ **************************************************************************************************/
+static bool notifyTransmit(uint8_t connection, uint16_t characteristic, uint8_t len,
+                           const uint8_t *value, bool *dropped)
+{
+  uint16_t result;
+
+  result = gecko_cmd_gatt_server_send_characteristic_notification(
+    connection, characteristic, len, value)->result;
+  *dropped = false;
+  if (result == bg_err_out_of_memory) {
+    return false;
+  }
+  if (result == bg_err_success) {
+    notifyStats.sent++;
+  } else {
+    /* Closed connection, notifications disabled: the value is gone either way */
+    notifyStats.failed++;
+    *dropped = true;
+  }
+  return true;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Retry at the next connection event of the oldest notification's connection.
+ **************************************************************************************************/
+static void notifyArmRetry(void)
+{
+  const connInfo_t *info;
+  uint16_t interval = NOTIFY_RETRY_INTERVAL;
+
+  if ((notifyCount == 0) || notifyTimerArmed) {
+    return;
+  }
+  info = connGet(notifyQueue[notifyHead].connection);
+  if ((info != NULL) && (info->interval != 0)) {
+    interval = info->interval;
+  }
+  gecko_cmd_hardware_set_soft_timer(NOTIFY_INTERVAL_2_TIMERTICK(interval), NOTIFY_TIMER, true);
+  notifyTimerArmed = true;
+}
+
+/** @} (end addtogroup notify) */
+/** @} (end addtogroup Application) */
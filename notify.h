@@ -0,0 +1,118 @@
+/***********************************************************************************************//**
+ * \file   notify.h
+ * \brief  Outgoing notification queue
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup notify Notify
+ * \brief Holds notifications the stack has no TX buffer for and sends them later.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup notify
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/** Notifications held while the stack is out of TX buffers. */
+#ifndef NOTIFY_QUEUE_SIZE
+#define NOTIFY_QUEUE_SIZE               6
+#endif
+
+/** Largest notification, ATT MTU 247 minus the 3 byte ATT header. */
+#define NOTIFY_MAX_LEN                  244
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** What to drop when a notification arrives at a full queue. */
+typedef enum {
+  NOTIFY_DROP_OLDEST = 0,               /**< Discard the head, keeps the newest data */
+  NOTIFY_DROP_NEWEST = 1                /**< Discard the new notification, keeps the sequence */
+} notifyDropPolicy_t;
+
+/** Queue counters since notifyInit(). */
+typedef struct {
+  uint32_t sent;                        /**< Notifications accepted by the stack */
+  uint32_t retried;                     /**< Sends rejected for lack of memory and queued */
+  uint32_t droppedOldest;               /**< Queued notifications discarded for newer ones */
+  uint32_t droppedNewest;               /**< New notifications discarded at a full queue */
+  uint32_t failed;                      /**< Notifications the stack rejected for other reasons */
+} notifyStats_t;
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Empty the queue and clear the counters.
+ **************************************************************************************************/
+void notifyInit(void);
+
+/***********************************************************************************************//**
+ *  \brief  Select what is dropped at a full queue.
+ **************************************************************************************************/
+void notifySetDropPolicy(notifyDropPolicy_t policy);
+
+/***********************************************************************************************//**
+ *  \brief  Send a notification, or queue it if the stack is out of TX buffers.
+ *  \details  Notifications leave in the order they were passed in, so nothing is sent directly
+ *  while older ones wait.
+ *  \param[in]  connection  Connection handle.
+ *  \param[in]  characteristic  GATT database handle.
+ *  \param[in]  len  Value length, at most NOTIFY_MAX_LEN.
+ *  \param[in]  value  Value, copied if queued.
+ *  \return  false if the notification was dropped.
+ **************************************************************************************************/
+bool notifySend(uint8_t connection, uint16_t characteristic, uint8_t len, const uint8_t *value);
+
+/***********************************************************************************************//**
+ *  \brief  Send queued notifications until the stack runs out of TX buffers again.
+ *  \details  Called on NOTIFY_TIMER, which is armed for the next connection event while
+ *  notifications wait.
+ **************************************************************************************************/
+void notifyDrain(void);
+
+/***********************************************************************************************//**
+ *  \brief  Discard the notifications queued for a closed connection.
+ **************************************************************************************************/
+void notifyConnectionClosed(uint8_t connection);
+
+/***********************************************************************************************//**
+ *  \brief  Read the counters.
+ **************************************************************************************************/
+void notifyGetStats(notifyStats_t *stats);
+
+/** @} (end addtogroup notify) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* NOTIFY_H */
@@ -0,0 +1,202 @@
+/***********************************************************************************************//**
+ * \file   si7013_async.c
+ * \brief  Si7013 humidity and temperature measurement on the I2C queue
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+
+/* BG stack headers */
+#include "native_gecko.h"
+
+#include "si7013.h"            /* SI7021_ADDR */
+
+/* application specific headers */
+#include "app_signal.h"
+#include "i2c_async.h"
+
+/* Own header */
+#include "si7013_async.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup si7013_async
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Type Definitions
+ **************************************************************************************************/
+
+typedef enum {
+  si7013StateIdle,                      /**< No conversion started */
+  si7013StateConverting,                /**< Measure command sent, waiting for si7013AsyncFetch() */
+  si7013StateReadRh,                    /**< Reading the RH result */
+  si7013StateReadTemp,                  /**< Reading the temperature of the same conversion */
+  si7013StateDone,                      /**< Result ready */
+  si7013StateNotReady,                  /**< RH read NACKed, conversion still running */
+  si7013StateError                      /**< Bus error */
+} si7013State_t;
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+static volatile si7013State_t si7013State = si7013StateIdle;
+static i2cAsyncXfer_t si7013Xfer;
+static uint8_t si7013Tx[1];
+static uint8_t si7013Rx[2];
+static uint32_t si7013Rh;
+static int32_t si7013Temp;
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static bool si7013Submit(uint16_t flags, uint8_t cmd, uint16_t rxLen);
+static void si7013Done(I2C_TransferReturn_TypeDef status, void *ctx);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+bool si7013AsyncMeasure(void)
+{
+  si7013State_t prev = si7013State;
+
+  if ((prev == si7013StateReadRh) || (prev == si7013StateReadTemp)) {
+    return false;
+  }
+  si7013State = si7013StateConverting;
+  if (!si7013Submit(I2C_FLAG_WRITE, SI7013_CMD_MEASURE_RH_NO_HOLD, 0)) {
+    si7013State = prev;
+    return false;
+  }
+  return true;
+}
+
+bool si7013AsyncFetch(void)
+{
+  if ((si7013State != si7013StateConverting) && (si7013State != si7013StateNotReady)) {
+    return false;
+  }
+  si7013State = si7013StateReadRh;
+
+  /* The sensor NACKs its address until the conversion is complete */
+  if (!si7013Submit(I2C_FLAG_READ, 0, 2)) {
+    si7013State = si7013StateNotReady;
+    return false;
+  }
+  return true;
+}
+
+int32_t si7013AsyncGetResult(uint32_t *rhData, int32_t *tData)
+{
+  switch (si7013State) {
+    case si7013StateDone:
+      *rhData = si7013Rh;
+      *tData = si7013Temp;
+      si7013State = si7013StateIdle;
+      return 0;
+    case si7013StateNotReady:
+      return 1;
+    default:
+      return -1;
+  }
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Queue a command write, a result read or both.
+ **************************************************************************************************/
+static bool si7013Submit(uint16_t flags, uint8_t cmd, uint16_t rxLen)
+{
+  si7013Tx[0] = cmd;
+  si7013Xfer.seq.addr = SI7021_ADDR;
+  si7013Xfer.seq.flags = flags;
+  if (flags == I2C_FLAG_READ) {
+    si7013Xfer.seq.buf[0].data = si7013Rx;
+    si7013Xfer.seq.buf[0].len = rxLen;
+  } else {
+    si7013Xfer.seq.buf[0].data = si7013Tx;
+    si7013Xfer.seq.buf[0].len = 1;
+    si7013Xfer.seq.buf[1].data = si7013Rx;
+    si7013Xfer.seq.buf[1].len = rxLen;
+  }
+  si7013Xfer.cb = si7013Done;
+  si7013Xfer.ctx = NULL;
+  return i2cAsyncSubmit(&si7013Xfer);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Advance the measurement when a transfer completes. Interrupt context.
+ **************************************************************************************************/
+static void si7013Done(I2C_TransferReturn_TypeDef status, void *ctx)
+{
+  uint32_t code;
+
+  (void)ctx;
+  switch (si7013State) {
+    case si7013StateConverting:
+      if (status != i2cTransferDone) {
+        si7013State = si7013StateError;
+        gecko_external_signal(APP_SIGNAL_SI7013_DATA);
+      }
+      break;
+
+    case si7013StateReadRh:
+      if (status == i2cTransferNack) {
+        si7013State = si7013StateNotReady;
+        gecko_external_signal(APP_SIGNAL_SI7013_DATA);
+        break;
+      }
+      if (status != i2cTransferDone) {
+        si7013State = si7013StateError;
+        gecko_external_signal(APP_SIGNAL_SI7013_DATA);
+        break;
+      }
+      /* RH = 125 * code / 65536 - 6, in milli-percent */
+      code = ((uint32_t)si7013Rx[0] << 8) | (si7013Rx[1] & 0xFC);  /* Two status bits */
+      si7013Rh = ((code * 15625UL) >> 13) - 6000;
+      if ((int32_t)si7013Rh < 0) {
+        si7013Rh = 0;
+      }
+
+      si7013State = si7013StateReadTemp;
+      if (!si7013Submit(I2C_FLAG_WRITE_READ, SI7013_CMD_READ_TEMP_FROM_RH, 2)) {
+        si7013State = si7013StateError;
+        gecko_external_signal(APP_SIGNAL_SI7013_DATA);
+      }
+      break;
+
+    case si7013StateReadTemp:
+      if (status != i2cTransferDone) {
+        si7013State = si7013StateError;
+      } else {
+        /* T = 175.72 * code / 65536 - 46.85, in milli-Celsius */
+        code = ((uint32_t)si7013Rx[0] << 8) | (si7013Rx[1] & 0xFC);
+        si7013Temp = (int32_t)((code * 21965UL) >> 13) - 46850;
+        si7013State = si7013StateDone;
+      }
+      gecko_external_signal(APP_SIGNAL_SI7013_DATA);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/** @} (end addtogroup si7013_async) */
+/** @} (end addtogroup Application) */
@@ -0,0 +1,81 @@
+/***********************************************************************************************//**
+ * \file   si7013_async.h
+ * \brief  Si7013 humidity and temperature measurement on the I2C queue
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef SI7013_ASYNC_H
+#define SI7013_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup si7013_async Si7013 Async
+ * \brief Si7013 measurements that never hold the I2C bus during a conversion.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup si7013_async
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/* Si7013 commands */
+#define SI7013_CMD_MEASURE_RH_NO_HOLD   0xF5
+#define SI7013_CMD_READ_TEMP_FROM_RH    0xE0   /* Temperature measured along with the RH */
+
+/** Worst case RH plus temperature conversion time at 12/14 bit resolution, in ms. */
+#define SI7013_CONV_MS                  25
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Start a RH and temperature conversion. The bus is released while the sensor converts.
+ *  \return  false if a measurement is already in progress or the I2C queue is full.
+ **************************************************************************************************/
+bool si7013AsyncMeasure(void);
+
+/***********************************************************************************************//**
+ *  \brief  Read the results of the conversion, at least SI7013_CONV_MS after si7013AsyncMeasure().
+ *  \details  APP_SIGNAL_SI7013_DATA is raised when the read has finished, successfully or not.
+ *  \return  false if no conversion was started or the I2C queue is full.
+ **************************************************************************************************/
+bool si7013AsyncFetch(void);
+
+/***********************************************************************************************//**
+ *  \brief  Collect the result of the last fetch. Call on APP_SIGNAL_SI7013_DATA.
+ *  \param[out]  rhData  Relative humidity in milli-percent.
+ *  \param[out]  tData  Temperature in milli-Celsius.
+ *  \return  0 on success, 1 if the conversion had not finished yet and the fetch can be repeated,
+ *  -1 on a bus error.
+ **************************************************************************************************/
+int32_t si7013AsyncGetResult(uint32_t *rhData, int32_t *tData);
+
+/** @} (end addtogroup si7013_async) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* SI7013_ASYNC_H */
@@ -0,0 +1,352 @@
+/***********************************************************************************************//**
+ * \file   spectrum.c
+ * \brief  Spectral summaries of the acquired samples
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+/* application specific files */
+#include "dsp_fft.h"
+
+/* Own header */
+#include "spectrum.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup spectrum
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Macros and Definitions
+ **************************************************************************************************/
+
+/** Bins of the real FFT, DC to Nyquist. */
+#define SPECTRUM_BINS                   ((SPECTRUM_FFT_LEN / 2) + 1)
+
+/** log2(SPECTRUM_FFT_LEN), the FFT output is divided by the length. */
+#define SPECTRUM_FFT_LOG2               7
+
+/** Default bands, roughly octaves above DC. */
+#define SPECTRUM_DEFAULT_BANDS          7
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+static const uint8_t spectrumDefaultEdges[SPECTRUM_DEFAULT_BANDS + 1] = {
+  1, 2, 4, 8, 16, 24, 40, SPECTRUM_BINS
+};
+
+static uint8_t spectrumSource;
+static uint8_t spectrumMode;
+static uint8_t spectrumCount;
+static uint8_t spectrumEdges[SPECTRUM_ITEMS_MAX + 1];
+static uint32_t spectrumRate;                        /* Sample rate in mHz */
+
+static int16_t spectrumWindow[SPECTRUM_FFT_LEN];     /* Hann, q15 */
+static int32_t spectrumHist[SPECTRUM_FFT_LEN];       /* Last samples, ring */
+static uint32_t spectrumPos;                         /* Where the next sample goes */
+static uint32_t spectrumFill;                        /* Samples since the restart, up to the length */
+static uint32_t spectrumNew;                         /* Samples since the last frame */
+static int16_t spectrumBuf[SPECTRUM_FFT_LEN + 2];    /* Windowed frame in, bins out */
+
+/* Last frame */
+static uint16_t spectrumSeq;
+static uint8_t spectrumItems;
+static uint16_t spectrumLevel[SPECTRUM_ITEMS_MAX];
+static uint16_t spectrumPeakPos[SPECTRUM_ITEMS_MAX]; /* 1/16 bins */
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static void spectrumRestart(void);
+static int32_t spectrumTransform(void);
+static uint16_t spectrumLevelOf(uint64_t power, int32_t exponent);
+static void spectrumBands(int32_t exponent);
+static void spectrumPeaks(int32_t exponent);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+void spectrumInit(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++) {
+    spectrumWindow[i] = dspFftHann(i, SPECTRUM_FFT_LEN);
+  }
+  spectrumConfigure(SPECTRUM_SRC_ADC, SPECTRUM_MODE_BANDS, SPECTRUM_DEFAULT_BANDS,
+                    spectrumDefaultEdges);
+}
+
+bool spectrumConfigure(uint8_t source, uint8_t mode, uint8_t count, const uint8_t *edges)
+{
+  uint32_t i;
+
+  if ((source > SPECTRUM_SRC_LDC1) || (mode > SPECTRUM_MODE_PEAKS) || (count == 0)
+      || (count > SPECTRUM_ITEMS_MAX)) {
+    return false;
+  }
+  if (mode == SPECTRUM_MODE_BANDS) {
+    if (edges == NULL) {
+      if ((spectrumMode != SPECTRUM_MODE_BANDS) || (count != spectrumCount)) {
+        return false;
+      }
+      edges = spectrumEdges;
+    }
+    if (edges[count] > SPECTRUM_BINS) {
+      return false;
+    }
+    for (i = 0; i < count; i++) {
+      if (edges[i] >= edges[i + 1]) {
+        return false;
+      }
+    }
+    memmove(spectrumEdges, edges, count + 1);
+  }
+
+  spectrumSource = source;
+  spectrumMode = mode;
+  spectrumCount = count;
+  spectrumRestart();
+  return true;
+}
+
+uint8_t spectrumGetSource(void)
+{
+  return spectrumSource;
+}
+
+void spectrumSetRate(uint32_t rateMilliHz)
+{
+  spectrumRate = rateMilliHz;
+  spectrumRestart();
+}
+
+uint32_t spectrumFramePeriodMs(void)
+{
+  if (spectrumRate == 0) {
+    return 0;
+  }
+  return (SPECTRUM_HOP * 1000000UL) / spectrumRate;
+}
+
+bool spectrumAdd(uint32_t sample)
+{
+  int32_t exponent;
+
+  spectrumHist[spectrumPos] = (int32_t)sample;
+  spectrumPos = (spectrumPos + 1) % SPECTRUM_FFT_LEN;
+  if (spectrumFill < SPECTRUM_FFT_LEN) {
+    spectrumFill++;
+  }
+  if ((++spectrumNew < SPECTRUM_HOP) || (spectrumFill < SPECTRUM_FFT_LEN)) {
+    return false;
+  }
+  spectrumNew = 0;
+
+  exponent = spectrumTransform();
+  if (spectrumMode == SPECTRUM_MODE_BANDS) {
+    spectrumBands(exponent);
+  } else {
+    spectrumPeaks(exponent);
+  }
+  spectrumSeq++;
+  return true;
+}
+
+uint8_t spectrumFrame(uint8_t *buf, uint16_t maxLen)
+{
+  uint32_t itemLen = (spectrumMode == SPECTRUM_MODE_BANDS) ? 2 : 4;
+  uint32_t binWidth = spectrumRate / SPECTRUM_FFT_LEN;
+  uint32_t items = spectrumItems;
+  uint32_t i;
+  uint8_t *p = buf;
+
+  if (maxLen < SPECTRUM_HEADER_LEN) {
+    return 0;
+  }
+  if (items > (maxLen - SPECTRUM_HEADER_LEN) / itemLen) {
+    items = (maxLen - SPECTRUM_HEADER_LEN) / itemLen;
+  }
+  if (binWidth > UINT16_MAX) {
+    binWidth = UINT16_MAX;
+  }
+
+  *p++ = (uint8_t)((spectrumMode << 4) | spectrumSource);
+  *p++ = (uint8_t)items;
+  *p++ = (uint8_t)spectrumSeq;
+  *p++ = (uint8_t)(spectrumSeq >> 8);
+  *p++ = (uint8_t)binWidth;
+  *p++ = (uint8_t)(binWidth >> 8);
+  for (i = 0; i < items; i++) {
+    if (spectrumMode == SPECTRUM_MODE_PEAKS) {
+      *p++ = (uint8_t)spectrumPeakPos[i];
+      *p++ = (uint8_t)(spectrumPeakPos[i] >> 8);
+    }
+    *p++ = (uint8_t)spectrumLevel[i];
+    *p++ = (uint8_t)(spectrumLevel[i] >> 8);
+  }
+  return (uint8_t)(p - buf);
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Drop the collected samples, the next frame starts from a full new window.
+ **************************************************************************************************/
+static void spectrumRestart(void)
+{
+  spectrumPos = 0;
+  spectrumFill = 0;
+  spectrumNew = 0;
+  spectrumItems = 0;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Window and transform the last SPECTRUM_FFT_LEN samples into spectrumBuf.
+ *  \details  The mean is removed, so DC does not leak into the low bins, and the rest is scaled by
+ *  a power of 2 to use the input range of the FFT, like a block floating point value. LDC1612 codes
+ *  with a few LSBs of movement on top of a large offset thereby keep their resolution.
+ *  \return  The exponent, the samples were divided by 2^exponent.
+ **************************************************************************************************/
+static int32_t spectrumTransform(void)
+{
+  int64_t sum = 0;
+  int32_t mean, d;
+  uint32_t maxAbs = 0;
+  int32_t exponent = 0;
+  uint32_t i, k;
+
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++) {
+    sum += spectrumHist[i];
+  }
+  mean = (int32_t)(sum / SPECTRUM_FFT_LEN);
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++) {
+    d = spectrumHist[i] - mean;
+    if ((uint32_t)((d < 0) ? -d : d) > maxAbs) {
+      maxAbs = (uint32_t)((d < 0) ? -d : d);
+    }
+  }
+  if (maxAbs > DSP_FFT_INPUT_MAX) {
+    while ((maxAbs >> exponent) > DSP_FFT_INPUT_MAX) {
+      exponent++;
+    }
+  } else if (maxAbs != 0) {
+    while ((exponent > -15) && ((maxAbs << (1 - exponent)) <= DSP_FFT_INPUT_MAX)) {
+      exponent--;
+    }
+  }
+
+  /* Oldest sample first */
+  for (i = 0, k = spectrumPos; i < SPECTRUM_FFT_LEN; i++, k = (k + 1) % SPECTRUM_FFT_LEN) {
+    d = spectrumHist[k] - mean;
+    d = (exponent >= 0) ? (d >> exponent) : (d * (1 << -exponent));
+    spectrumBuf[i] = (int16_t)((d * spectrumWindow[i]) >> 15);
+  }
+  dspRfftQ15(spectrumBuf, SPECTRUM_FFT_LEN);
+  return exponent;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Level of a power summed from spectrumBuf bins, see the frame layout in spectrum.h.
+ *  \details  Undoes the 1 / SPECTRUM_FFT_LEN of the FFT and the scaling of spectrumTransform().
+ **************************************************************************************************/
+static uint16_t spectrumLevelOf(uint64_t power, int32_t exponent)
+{
+  int32_t level;
+
+  if (power == 0) {
+    return 0;
+  }
+  level = dspLog2Q8(power) + (512 * (SPECTRUM_FFT_LOG2 + exponent));
+  if (level < 1) {
+    return 1;
+  }
+  return (uint16_t)((level > UINT16_MAX) ? UINT16_MAX : level);
+}
+
+/***********************************************************************************************//**
+ *  \brief  Sum the power of the configured bands.
+ **************************************************************************************************/
+static void spectrumBands(int32_t exponent)
+{
+  uint64_t power;
+  uint32_t i, k;
+
+  for (i = 0; i < spectrumCount; i++) {
+    power = 0;
+    for (k = spectrumEdges[i]; k < spectrumEdges[i + 1]; k++) {
+      power += dspFftPower(spectrumBuf, k);
+    }
+    spectrumLevel[i] = spectrumLevelOf(power, exponent);
+  }
+  spectrumItems = spectrumCount;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Find the strongest local maxima, strongest first.
+ *  \details  The position is refined by a parabola through the peak and its neighbours.
+ **************************************************************************************************/
+static void spectrumPeaks(int32_t exponent)
+{
+  uint32_t peakPower[SPECTRUM_ITEMS_MAX];
+  uint32_t prev, cur, next;
+  int64_t num, den;
+  int32_t offset;
+  uint32_t n = 0;
+  uint32_t i, k;
+
+  prev = dspFftPower(spectrumBuf, 0);
+  cur = dspFftPower(spectrumBuf, 1);
+  for (k = 1; k < SPECTRUM_BINS - 1; k++, prev = cur, cur = next) {
+    next = dspFftPower(spectrumBuf, k + 1);
+    if ((cur <= prev) || (cur < next)) {
+      continue;
+    }
+    if ((n == spectrumCount) && (cur <= peakPower[n - 1])) {
+      continue;
+    }
+
+    /* Insert sorted, the weakest drops out once full */
+    i = (n < spectrumCount) ? n++ : (n - 1);
+    for (; (i > 0) && (peakPower[i - 1] < cur); i--) {
+      peakPower[i] = peakPower[i - 1];
+      spectrumPeakPos[i] = spectrumPeakPos[i - 1];
+    }
+    num = ((int64_t)next - prev) * 16;
+    den = 2 * ((2 * (int64_t)cur) - prev - next);
+    offset = (den > 0) ? (int32_t)(num / den) : 0;
+    if (offset > 8) {
+      offset = 8;
+    } else if (offset < -8) {
+      offset = -8;
+    }
+    peakPower[i] = cur;
+    spectrumPeakPos[i] = (uint16_t)((k * 16) + offset);
+  }
+
+  for (i = 0; i < n; i++) {
+    spectrumLevel[i] = spectrumLevelOf(peakPower[i], exponent);
+  }
+  spectrumItems = (uint8_t)n;
+}
+
+/** @} (end addtogroup spectrum) */
+/** @} (end addtogroup Application) */
@@ -0,0 +1,124 @@
+/***********************************************************************************************//**
+ * \file   spectrum.h
+ * \brief  Spectral summaries of the acquired samples
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup spectrum Spectrum
+ * \brief Band powers or peaks of Hann windowed, half overlapping FFT frames of one channel.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup spectrum
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/** FFT length and the new samples per frame, half of them overlap with the previous frame. */
+#define SPECTRUM_FFT_LEN                128
+#define SPECTRUM_HOP                    (SPECTRUM_FFT_LEN / 2)
+
+/** Analysed channel. */
+#define SPECTRUM_SRC_ADC                0           /* PA0 */
+#define SPECTRUM_SRC_LDC0               1           /* LDC1612 CH0 */
+#define SPECTRUM_SRC_LDC1               2           /* LDC1612 CH1 */
+
+/** Frame contents. */
+#define SPECTRUM_MODE_BANDS             0           /* Summed power per band of bins */
+#define SPECTRUM_MODE_PEAKS             1           /* Strongest local maxima */
+
+/** Most bands or peaks per frame. */
+#define SPECTRUM_ITEMS_MAX              8
+
+/** Frame layout, little endian:
+ *  mode << 4 | source (1), item count (1), sequence number (2), bin width in mHz (2), then per band
+ *  its level (2) or per peak its position in 1/16 bins (2) and level (2). Levels are
+ *  256 * log2 of the power in input LSB^2, 0 for none. */
+#define SPECTRUM_HEADER_LEN             6
+#define SPECTRUM_FRAME_MAX              (SPECTRUM_HEADER_LEN + (4 * SPECTRUM_ITEMS_MAX))
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Select the default configuration: PA0, seven octave-like bands.
+ **************************************************************************************************/
+void spectrumInit(void);
+
+/***********************************************************************************************//**
+ *  \brief  Change what is analysed and reported. Restarts the frames.
+ *  \param[in]  source  SPECTRUM_SRC_xx.
+ *  \param[in]  mode  SPECTRUM_MODE_xx.
+ *  \param[in]  count  Bands or peaks, 1 to SPECTRUM_ITEMS_MAX.
+ *  \param[in]  edges  Bands mode only: count + 1 ascending bin numbers up to SPECTRUM_FFT_LEN / 2
+ *  + 1, band i sums bins edges[i] to edges[i + 1] - 1. NULL keeps the current edges if count is
+ *  unchanged.
+ *  \return  false if the configuration is invalid.
+ **************************************************************************************************/
+bool spectrumConfigure(uint8_t source, uint8_t mode, uint8_t count, const uint8_t *edges);
+
+/***********************************************************************************************//**
+ *  \brief  The analysed channel, SPECTRUM_SRC_xx.
+ **************************************************************************************************/
+uint8_t spectrumGetSource(void);
+
+/***********************************************************************************************//**
+ *  \brief  Set the sample rate of the analysed channel. Restarts the frames.
+ *  \param[in]  rateMilliHz  Sample rate in mHz.
+ **************************************************************************************************/
+void spectrumSetRate(uint32_t rateMilliHz);
+
+/***********************************************************************************************//**
+ *  \brief  Time between frames in ms, 0 while the rate is unknown.
+ **************************************************************************************************/
+uint32_t spectrumFramePeriodMs(void);
+
+/***********************************************************************************************//**
+ *  \brief  Add a sample of the analysed channel.
+ *  \param[in]  sample  ADC sample or LDC1612 code.
+ *  \return  true if a frame has been completed, see spectrumFrame().
+ **************************************************************************************************/
+bool spectrumAdd(uint32_t sample);
+
+/***********************************************************************************************//**
+ *  \brief  Build the notification of the last frame.
+ *  \param[out]  buf  At least SPECTRUM_FRAME_MAX bytes.
+ *  \param[in]  maxLen  Payload length of the receiver; items that do not fit are left out,
+ *  strongest peaks first.
+ *  \return  Length in bytes.
+ **************************************************************************************************/
+uint8_t spectrumFrame(uint8_t *buf, uint16_t maxLen);
+
+/** @} (end addtogroup spectrum) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* SPECTRUM_H */
@@ -0,0 +1,382 @@
+/***********************************************************************************************//**
+ * \file   stream.c
+ * \brief  Batching of sensor samples into notification sized frames
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+/* BG stack headers */
+#include "bg_types.h"
+#include "infrastructure.h"
+
+/* Own header */
+#include "stream.h"
+#include "stream_codec.h"
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup stream
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Local Macros and Definitions
+ **************************************************************************************************/
+
+/** RTCC ticks per second. */
+#define STREAM_RTCC_HZ                  32768
+
+/** Largest sample time delta, uint16. */
+#define STREAM_MAX_DELTA                0xFFFF
+
+/** Offset of the sample count in the header. */
+#define STREAM_COUNT_OFFSET             6
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/** A sample as passed to streamAdd(). */
+typedef struct {
+  uint32_t timestamp;
+  uint8_t data[STREAM_SAMPLE_LEN];
+} streamEntry_t;
+
+/** Frame state of one subscriber. */
+typedef struct {
+  uint8_t connection;                   /* 0 if the slot is free */
+  bool complete;                        /* frame waits to be sent */
+  uint8_t format;                       /* Format of the frame being filled */
+  uint16_t payloadLen;
+  uint16_t len;                         /* Bytes in frame, 0 if empty */
+  uint16_t seq;
+  uint32_t cursor;                      /* Next ring sample to add */
+  uint32_t base;                        /* Timestamp of the first sample */
+  uint32_t prevTime;                    /* Timestamp of the previous sample */
+  bool prevValid;
+  uint32_t drops;
+  streamCodec_t codec;
+  uint8_t frame[STREAM_MAX_PAYLOAD];
+} streamSub_t;
+
+/***************************************************************************************************
+ * Local Variables
+ **************************************************************************************************/
+
+static streamEntry_t streamRing[STREAM_RING_SIZE];
+static uint32_t streamHead = 0;                      /* Samples added since streamInit() */
+static streamSub_t streamSubs[STREAM_MAX_SUBSCRIBERS];
+static uint8_t streamTurn = 0;                       /* Subscriber served first next round */
+static uint32_t streamDeadline = (STREAM_DEFAULT_DEADLINE_MS * STREAM_RTCC_HZ) / 1000;
+static uint16_t streamDeadlineMs = STREAM_DEFAULT_DEADLINE_MS;
+static uint8_t streamFormat = STREAM_FORMAT_RAW;     /* Format of new frames */
+static uint8_t streamAdcShift = 0;
+
+/***************************************************************************************************
+ * Static Function Declarations
+ **************************************************************************************************/
+
+static streamSub_t *streamFind(uint8_t connection);
+static bool streamFill(streamSub_t *sub);
+static bool streamAppend(streamSub_t *sub, const streamEntry_t *entry);
+static uint32_t streamGetUint32(const uint8_t *p);
+
+/***************************************************************************************************
+ * Public Function Definitions
+ **************************************************************************************************/
+
+void streamInit(void)
+{
+  memset(streamSubs, 0, sizeof(streamSubs));
+  streamHead = 0;
+  streamTurn = 0;
+}
+
+bool streamSubscribe(uint8_t connection, uint16_t len)
+{
+  streamSub_t *sub = streamFind(connection);
+
+  if (sub == NULL) {
+    sub = streamFind(0);
+    if (sub == NULL) {
+      return false;
+    }
+  }
+  memset(sub, 0, offsetof(streamSub_t, codec));
+  sub->connection = connection;
+  sub->cursor = streamHead;
+  streamSetPayloadLen(connection, len);
+  return true;
+}
+
+void streamUnsubscribe(uint8_t connection)
+{
+  streamSub_t *sub = streamFind(connection);
+
+  if ((connection != 0) && (sub != NULL)) {
+    sub->connection = 0;
+  }
+}
+
+uint8_t streamSubscribers(void)
+{
+  uint8_t i, n = 0;
+
+  for (i = 0; i < STREAM_MAX_SUBSCRIBERS; i++) {
+    if (streamSubs[i].connection != 0) {
+      n++;
+    }
+  }
+  return n;
+}
+
+void streamSetPayloadLen(uint8_t connection, uint16_t len)
+{
+  streamSub_t *sub = streamFind(connection);
+
+  if ((connection == 0) || (sub == NULL)) {
+    return;
+  }
+  if (len > STREAM_MAX_PAYLOAD) {
+    len = STREAM_MAX_PAYLOAD;
+  }
+  if (len < (STREAM_HEADER_LEN + STREAM_RAW_SAMPLE_LEN)) {
+    len = STREAM_HEADER_LEN + STREAM_RAW_SAMPLE_LEN;
+  }
+  sub->payloadLen = len;
+}
+
+void streamSetDeadline(uint16_t ms)
+{
+  streamDeadline = ((uint32_t)ms * STREAM_RTCC_HZ) / 1000;
+  streamDeadlineMs = ms;
+}
+
+void streamSetFormat(uint8_t format, uint8_t adcShift)
+{
+  streamFormat = (format == STREAM_FORMAT_PACKED) ? STREAM_FORMAT_PACKED : STREAM_FORMAT_RAW;
+  streamAdcShift = adcShift;
+}
+
+uint32_t streamFramePeriodMs(uint8_t connection, uint32_t samplePeriodMs)
+{
+  streamSub_t *sub = streamFind(connection);
+  uint32_t fill;
+
+  if ((connection == 0) || (sub == NULL)) {
+    return 0;
+  }
+  fill = samplePeriodMs * ((sub->payloadLen - STREAM_HEADER_LEN) / STREAM_RAW_SAMPLE_LEN);
+
+  /* The sample that passes the deadline closes the frame */
+  if ((streamDeadlineMs < fill) && (samplePeriodMs < fill)) {
+    return (streamDeadlineMs > samplePeriodMs) ? streamDeadlineMs : samplePeriodMs;
+  }
+  return fill;
+}
+
+void streamAdd(uint32_t timestamp, const uint8_t *sample)
+{
+  streamEntry_t *entry = &streamRing[streamHead % STREAM_RING_SIZE];
+  streamSub_t *sub;
+  uint8_t i;
+
+  /* Subscribers that would lose the overwritten sample skip it */
+  for (i = 0; i < STREAM_MAX_SUBSCRIBERS; i++) {
+    sub = &streamSubs[i];
+    if ((sub->connection != 0) && ((streamHead - sub->cursor) >= STREAM_RING_SIZE)) {
+      sub->cursor++;
+      sub->drops++;
+    }
+  }
+
+  entry->timestamp = timestamp;
+  memcpy(entry->data, sample, STREAM_SAMPLE_LEN);
+  streamHead++;
+}
+
+void streamService(streamSendFn_t send)
+{
+  streamSub_t *sub;
+  bool progress = true;
+  uint8_t i;
+
+  while (progress) {
+    progress = false;
+    for (i = 0; i < STREAM_MAX_SUBSCRIBERS; i++) {
+      sub = &streamSubs[(streamTurn + i) % STREAM_MAX_SUBSCRIBERS];
+      if ((sub->connection == 0) || !streamFill(sub)) {
+        continue;
+      }
+      if (send(sub->connection, sub->frame, sub->len)) {
+        sub->complete = false;
+        sub->len = 0;
+        sub->seq++;
+        progress = true;
+      }
+    }
+    streamTurn = (streamTurn + 1) % STREAM_MAX_SUBSCRIBERS;
+  }
+}
+
+void streamFlush(uint32_t now, streamSendFn_t send)
+{
+  streamSub_t *sub;
+  uint8_t i;
+
+  for (i = 0; i < STREAM_MAX_SUBSCRIBERS; i++) {
+    sub = &streamSubs[i];
+    if ((sub->connection != 0) && !streamFill(sub) && (sub->len != 0)
+        && ((uint32_t)(now - sub->base) >= streamDeadline)) {
+      sub->complete = true;
+    }
+  }
+  streamService(send);
+}
+
+bool streamNextDeadline(uint32_t now, uint32_t *ticks)
+{
+  streamSub_t *sub;
+  uint32_t elapsed, wait;
+  bool found = false;
+  uint8_t i;
+
+  for (i = 0; i < STREAM_MAX_SUBSCRIBERS; i++) {
+    sub = &streamSubs[i];
+    if ((sub->connection == 0) || sub->complete || (sub->len == 0)) {
+      continue;
+    }
+    elapsed = now - sub->base;
+    wait = (elapsed < streamDeadline) ? (streamDeadline - elapsed) : 1;
+    if (!found || (wait < *ticks)) {
+      *ticks = wait;
+      found = true;
+    }
+  }
+  return found;
+}
+
+uint32_t streamGetDrops(uint8_t connection)
+{
+  streamSub_t *sub = streamFind(connection);
+
+  return ((connection != 0) && (sub != NULL)) ? sub->drops : 0;
+}
+
+/***************************************************************************************************
+ * Static Function Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Find the slot of a subscriber, or a free slot when called with 0.
+ **************************************************************************************************/
+static streamSub_t *streamFind(uint8_t connection)
+{
+  uint8_t i;
+
+  for (i = 0; i < STREAM_MAX_SUBSCRIBERS; i++) {
+    if (streamSubs[i].connection == connection) {
+      return &streamSubs[i];
+    }
+  }
+  return NULL;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Add the subscriber's pending ring samples to its frame.
+ *  \return  true if the frame is complete.
+ **************************************************************************************************/
+static bool streamFill(streamSub_t *sub)
+{
+  while (!sub->complete && (sub->cursor != streamHead)) {
+    sub->complete = streamAppend(sub, &streamRing[sub->cursor % STREAM_RING_SIZE]);
+    sub->cursor++;
+  }
+  return sub->complete;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Append a sample to the subscriber's frame.
+ *  \return  true if the frame is full or its deadline has passed.
+ **************************************************************************************************/
+static bool streamAppend(streamSub_t *sub, const streamEntry_t *entry)
+{
+  uint8_t *p;
+  uint32_t values[STREAM_CODEC_CHANNELS];
+  uint32_t delta = 0;
+
+  if (sub->prevValid) {
+    delta = entry->timestamp - sub->prevTime;
+    if (delta > STREAM_MAX_DELTA) {
+      delta = STREAM_MAX_DELTA;
+    }
+  }
+  sub->prevTime = entry->timestamp;
+  sub->prevValid = true;
+
+  if (sub->len == 0) {
+    /* Header, the count is filled in as samples arrive */
+    p = sub->frame;
+    UINT16_TO_BITSTREAM(p, sub->seq);
+    UINT32_TO_BITSTREAM(p, entry->timestamp);
+    UINT8_TO_BITSTREAM(p, 0);
+    sub->len = STREAM_HEADER_LEN;
+    sub->base = entry->timestamp;
+    sub->format = streamFormat;
+    if (sub->format == STREAM_FORMAT_PACKED) {
+      sub->frame[STREAM_COUNT_OFFSET] = STREAM_COUNT_PACKED;
+      streamCodecBegin(&sub->codec, &sub->frame[STREAM_HEADER_LEN],
+                       sub->payloadLen - STREAM_HEADER_LEN, streamAdcShift);
+    }
+  }
+
+  if (sub->format == STREAM_FORMAT_PACKED) {
+    values[0] = streamGetUint32(&entry->data[0]);
+    values[1] = streamGetUint32(&entry->data[4]);
+    values[2] = (uint32_t)entry->data[8] | ((uint32_t)entry->data[9] << 8);
+    values[3] = delta;
+    streamCodecAdd(&sub->codec, values);
+    sub->len = (uint16_t)(STREAM_HEADER_LEN + streamCodecBytes(&sub->codec));
+    sub->frame[STREAM_COUNT_OFFSET]++;
+
+    if (!streamCodecRoom(&sub->codec)
+        || ((sub->frame[STREAM_COUNT_OFFSET] & STREAM_COUNT_MASK) == STREAM_COUNT_MASK)) {
+      return true;
+    }
+    return (uint32_t)(entry->timestamp - sub->base) >= streamDeadline;
+  }
+
+  p = &sub->frame[sub->len];
+  UINT16_TO_BITSTREAM(p, delta);
+  memcpy(p, entry->data, STREAM_SAMPLE_LEN);
+  sub->len += STREAM_RAW_SAMPLE_LEN;
+  sub->frame[STREAM_COUNT_OFFSET]++;
+
+  /* Full when the next sample would not fit */
+  if ((sub->len + STREAM_RAW_SAMPLE_LEN) > sub->payloadLen) {
+    return true;
+  }
+  return (uint32_t)(entry->timestamp - sub->base) >= streamDeadline;
+}
+
+/***********************************************************************************************//**
+ *  \brief  Little endian uint32 of a sample field.
+ **************************************************************************************************/
+static uint32_t streamGetUint32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/** @} (end addtogroup stream) */
+/** @} (end addtogroup Application) */
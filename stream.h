@@ -0,0 +1,195 @@
+/***********************************************************************************************//**
+ * \file   stream.h
+ * \brief  Batching of sensor samples into notification sized frames
+ ***************************************************************************************************
+ * <b> (C) Copyright 2015 Silicon Labs, http://www.silabs.com</b>
+ ***************************************************************************************************
+ * This file is licensed under the Silabs License Agreement. See the file
+ * "Silabs_License_Agreement.txt" for details. Before using this software for
+ * any purpose, you must agree to the terms of that agreement.
+ **************************************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***********************************************************************************************//**
+ * \defgroup stream Stream
+ * \brief Packs fixed size samples into frames that fill one notification of every subscriber.
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup Application
+ * @{
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ * @addtogroup stream
+ * @{
+ **************************************************************************************************/
+
+/***************************************************************************************************
+ * Public Macros and Definitions
+ **************************************************************************************************/
+
+/** Frame header: sequence number (uint16), RTCC time of the first sample (uint32), sample count
+ *  (uint8). Little endian like all GATT values. The samples follow, STREAM_RAW_SAMPLE_LEN each, or
+ *  packed as described in stream_codec.h if STREAM_COUNT_PACKED is set in the count. Every sample
+ *  carries the RTCC ticks since the previous one, also across frames; sample i of a frame was
+ *  taken at the header time plus the deltas of samples 1 to i. */
+#define STREAM_HEADER_LEN               7
+
+/** Count flag of a packed frame, the count itself is in the lower bits. */
+#define STREAM_COUNT_PACKED             0x80
+#define STREAM_COUNT_MASK               0x7F
+
+/** Sample passed to streamAdd(): LDC1612 CH0 (uint32), LDC1612 CH1 (uint32), ADC (uint16). */
+#define STREAM_SAMPLE_LEN               10
+
+/** Raw frame sample: RTCC ticks since the previous sample (uint16), then the streamAdd() sample. */
+#define STREAM_RAW_SAMPLE_LEN           (2 + STREAM_SAMPLE_LEN)
+
+/** Largest notification payload, ATT MTU 247 minus the 3 byte ATT header. */
+#define STREAM_MAX_PAYLOAD              244
+
+/** Payload until an MTU has been exchanged, the default ATT MTU of 23 minus 3. */
+#define STREAM_DEFAULT_PAYLOAD          20
+
+/** Default time from the first sample of a frame until it is sent even if not full, in ms. */
+#define STREAM_DEFAULT_DEADLINE_MS      100
+
+/** Frame formats. */
+#define STREAM_FORMAT_RAW               0
+#define STREAM_FORMAT_PACKED            1
+
+/** Samples kept for subscribers whose frame is waiting for a TX buffer, power of 2. */
+#ifndef STREAM_RING_SIZE
+#define STREAM_RING_SIZE                32
+#endif
+
+/** Subscribers served at the same time. */
+#ifndef STREAM_MAX_SUBSCRIBERS
+#define STREAM_MAX_SUBSCRIBERS          4
+#endif
+
+/***************************************************************************************************
+ * Type Definitions
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Hand a frame to the stack.
+ *  \return  false if the stack is out of TX buffers; the same frame is offered again later.
+ **************************************************************************************************/
+typedef bool (*streamSendFn_t)(uint8_t connection, const uint8_t *frame, uint16_t len);
+
+/***************************************************************************************************
+ * Function Declarations
+ **************************************************************************************************/
+
+/***********************************************************************************************//**
+ *  \brief  Drop all subscribers and samples.
+ **************************************************************************************************/
+void streamInit(void);
+
+/***********************************************************************************************//**
+ *  \brief  Start sending frames to a connection, beginning with the next sample.
+ *  \details  Sequence numbers and time deltas restart for the subscriber.
+ *  \param[in]  connection  Connection handle.
+ *  \param[in]  len  Notification payload, ATT MTU minus 3.
+ *  \return  false if all STREAM_MAX_SUBSCRIBERS slots are taken.
+ **************************************************************************************************/
+bool streamSubscribe(uint8_t connection, uint16_t len);
+
+/***********************************************************************************************//**
+ *  \brief  Stop sending frames to a connection.
+ **************************************************************************************************/
+void streamUnsubscribe(uint8_t connection);
+
+/***********************************************************************************************//**
+ *  \brief  Number of subscribers.
+ **************************************************************************************************/
+uint8_t streamSubscribers(void);
+
+/***********************************************************************************************//**
+ *  \brief  Size the frames of a subscriber for its notification payload.
+ *  \details  The ATT MTU only grows during a connection, so a partly filled frame always fits.
+ *  \param[in]  connection  Connection handle.
+ *  \param[in]  len  ATT MTU minus 3, limited to STREAM_MAX_PAYLOAD.
+ **************************************************************************************************/
+void streamSetPayloadLen(uint8_t connection, uint16_t len);
+
+/***********************************************************************************************//**
+ *  \brief  Set the latency deadline of a partly filled frame.
+ *  \param[in]  ms  Time from the first sample until the frame is sent, 0 sends every sample.
+ **************************************************************************************************/
+void streamSetDeadline(uint16_t ms);
+
+/***********************************************************************************************//**
+ *  \brief  Select the frame format, from the next frame on.
+ *  \param[in]  format  STREAM_FORMAT_xx.
+ *  \param[in]  adcShift  ADC LSBs that are always zero, they are not sent in packed frames.
+ **************************************************************************************************/
+void streamSetFormat(uint8_t format, uint8_t adcShift);
+
+/***********************************************************************************************//**
+ *  \brief  Time between frames of a subscriber at a sample period: until a frame is full, at most
+ *  the deadline.
+ *  \details  Packed frames are assumed to hold as many samples as raw ones, they hold more.
+ *  \param[in]  connection  Connection handle.
+ *  \param[in]  samplePeriodMs  Time between samples.
+ *  \return  Frame period in ms, 0 if the connection is not subscribed.
+ **************************************************************************************************/
+uint32_t streamFramePeriodMs(uint8_t connection, uint32_t samplePeriodMs);
+
+/***********************************************************************************************//**
+ *  \brief  Store a sample for all subscribers.
+ *  \details  A subscriber more than STREAM_RING_SIZE samples behind loses its oldest samples.
+ *  \param[in]  timestamp  RTCC counter when the sample was taken; deltas beyond 2 s saturate.
+ *  \param[in]  sample  STREAM_SAMPLE_LEN bytes.
+ **************************************************************************************************/
+void streamAdd(uint32_t timestamp, const uint8_t *sample);
+
+/***********************************************************************************************//**
+ *  \brief  Fill the frames of all subscribers and send the complete ones.
+ *  \details  Subscribers take turns, one frame each per round, so a link that is out of TX
+ *  buffers holds back only its own frames while the others keep going.
+ *  \param[in]  send  Called for every complete frame.
+ **************************************************************************************************/
+void streamService(streamSendFn_t send);
+
+/***********************************************************************************************//**
+ *  \brief  Close the partly filled frames whose deadline has passed and send them.
+ *  \details  streamAdd() only checks the deadline when the next sample arrives, which may be much
+ *  later or never once the samples stop. Call when the streamNextDeadline() wait is over.
+ *  \param[in]  now  RTCC counter.
+ *  \param[in]  send  Called for every complete frame.
+ **************************************************************************************************/
+void streamFlush(uint32_t now, streamSendFn_t send);
+
+/***********************************************************************************************//**
+ *  \brief  Time until the oldest partly filled frame reaches its deadline.
+ *  \param[in]  now  RTCC counter.
+ *  \param[out]  ticks  RTCC ticks to wait, at least 1.
+ *  \return  false if no frame is partly filled.
+ **************************************************************************************************/
+bool streamNextDeadline(uint32_t now, uint32_t *ticks);
+
+/***********************************************************************************************//**
+ *  \brief  Samples a subscriber lost because it fell more than STREAM_RING_SIZE behind.
+ **************************************************************************************************/
+uint32_t streamGetDrops(uint8_t connection);
+
+/** @} (end addtogroup stream) */
+/** @} (end addtogroup Application) */
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* STREAM_H */
@@ -0,0 +1,332 @@
+/*
+ * stream_codec.h
+ *
+ *  Lossless packing of sensor stream samples. The first sample of a frame is
+ *  sent bit-packed at the width of each channel, every following one as the
+ *  zig-zag mapped difference to its predecessor in an adaptive Rice code.
+ *  Each frame decodes on its own, a lost frame costs only its own samples.
+ *  Plain C without device headers, like adc_conv.h, so hosts decode with the
+ *  same code that encodes on the target.
+ */
+
+#ifndef STREAM_CODEC_H_
+#define STREAM_CODEC_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Channels of a sample: LDC1612 CH0, LDC1612 CH1, ADC, RTCC ticks since the
+ * previous sample. Regular sampling makes the differences of the last one 0. */
+#define STREAM_CODEC_CHANNELS   4
+#define STREAM_CODEC_LDC_BITS   28                      /* LDC1612 conversion result */
+#define STREAM_CODEC_ADC_BITS   16                      /* Decimated ADC sample */
+#define STREAM_CODEC_DT_BITS    16                      /* Sample time delta */
+
+/* Unary quotients from STREAM_CODEC_QMAX on are replaced by an escape and
+ * the residual in full, which bounds a sample to STREAM_CODEC_WORST_BITS */
+#define STREAM_CODEC_QMAX       12
+#define STREAM_CODEC_WORST_BITS (4 * STREAM_CODEC_QMAX + 2 * (STREAM_CODEC_LDC_BITS + 1) \
+                                 + STREAM_CODEC_ADC_BITS + 1 + STREAM_CODEC_DT_BITS + 1)
+
+/* Rice parameter adaptation: running magnitude sum over about 16 residuals */
+#define STREAM_CODEC_WINDOW     16
+#define STREAM_CODEC_ACC_INIT   4
+#define STREAM_CODEC_ACC_CLAMP  0x00FFFFFFUL
+
+typedef struct
+{
+  uint8_t *buf;                                 /* Output, starts with the ADC shift byte */
+  uint32_t bits;                                /* Bits written, or read when decoding */
+  uint32_t capacity;                            /* Bits available */
+  uint32_t prev[STREAM_CODEC_CHANNELS];         /* Previous sample */
+  uint32_t acc[STREAM_CODEC_CHANNELS];          /* Sum of recent residuals */
+  uint32_t n;                                   /* Residuals in acc */
+  uint8_t width[STREAM_CODEC_CHANNELS];         /* Coded bits per channel */
+  uint8_t adcShift;                             /* ADC LSBs known to be zero */
+  uint16_t count;                               /* Samples coded */
+} streamCodec_t;
+
+/**************************************************************************//**
+ * @brief Bits of the first, bit-packed sample.
+ *****************************************************************************/
+static inline uint32_t streamCodecRawBits(const streamCodec_t *c)
+{
+  return (uint32_t)c->width[0] + c->width[1] + c->width[2] + c->width[3];
+}
+
+/**************************************************************************//**
+ * @brief Reset the coder state at the start of a frame.
+ *****************************************************************************/
+static inline void streamCodecReset(streamCodec_t *c, uint8_t *buf, uint32_t len, uint8_t adcShift)
+{
+  uint32_t i;
+
+  c->buf = buf;
+  c->bits = 8;
+  c->capacity = len * 8;
+  c->adcShift = (uint8_t)(adcShift & 0x0F);
+  c->width[0] = STREAM_CODEC_LDC_BITS;
+  c->width[1] = STREAM_CODEC_LDC_BITS;
+  c->width[2] = (uint8_t)(STREAM_CODEC_ADC_BITS - c->adcShift);
+  c->width[3] = STREAM_CODEC_DT_BITS;
+  for (i = 0; i < STREAM_CODEC_CHANNELS; i++)
+  {
+    c->prev[i] = 0;
+    c->acc[i] = STREAM_CODEC_ACC_INIT;
+  }
+  c->n = 1;
+  c->count = 0;
+}
+
+/**************************************************************************//**
+ * @brief Rice parameter of a channel, the smallest k with n * 2^k >= acc.
+ *****************************************************************************/
+static inline uint32_t streamCodecK(const streamCodec_t *c, uint32_t ch)
+{
+  uint32_t k = 0;
+
+  while (((c->n << k) < c->acc[ch]) && (k < c->width[ch]))
+  {
+    k++;
+  }
+  return k;
+}
+
+/**************************************************************************//**
+ * @brief Account a residual in the adaptation state.
+ *****************************************************************************/
+static inline void streamCodecAdapt(streamCodec_t *c, uint32_t ch, uint32_t u)
+{
+  c->acc[ch] += (u > STREAM_CODEC_ACC_CLAMP) ? STREAM_CODEC_ACC_CLAMP : u;
+}
+
+/**************************************************************************//**
+ * @brief Advance the adaptation window after a complete sample.
+ *****************************************************************************/
+static inline void streamCodecNext(streamCodec_t *c)
+{
+  uint32_t i;
+
+  c->n++;
+  if (c->n >= STREAM_CODEC_WINDOW)
+  {
+    c->n >>= 1;
+    for (i = 0; i < STREAM_CODEC_CHANNELS; i++)
+    {
+      c->acc[i] >>= 1;
+    }
+  }
+  c->count++;
+}
+
+/**************************************************************************//**
+ * @brief Append bits, LSB first.
+ *****************************************************************************/
+static inline void streamCodecPut(streamCodec_t *c, uint32_t value, uint32_t nbits)
+{
+  uint32_t take, pos;
+
+  while (nbits > 0)
+  {
+    pos = c->bits & 7;
+    take = 8 - pos;
+    if (take > nbits)
+    {
+      take = nbits;
+    }
+    c->buf[c->bits >> 3] |= (uint8_t)((value & ((1UL << take) - 1)) << pos);
+    value >>= take;
+    c->bits += take;
+    nbits -= take;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Read bits, LSB first.
+ *****************************************************************************/
+static inline uint32_t streamCodecGet(streamCodec_t *c, uint32_t nbits)
+{
+  uint32_t value = 0;
+  uint32_t shift = 0;
+  uint32_t take, pos;
+
+  while (nbits > 0)
+  {
+    pos = c->bits & 7;
+    take = 8 - pos;
+    if (take > nbits)
+    {
+      take = nbits;
+    }
+    value |= (uint32_t)((c->buf[c->bits >> 3] >> pos) & ((1UL << take) - 1)) << shift;
+    shift += take;
+    c->bits += take;
+    nbits -= take;
+  }
+  return value;
+}
+
+/**************************************************************************//**
+ * @brief Start encoding a frame.
+ * @param[out] buf
+ *   Frame payload after the stream header, cleared here.
+ * @param[in] len
+ *   Bytes available in buf.
+ * @param[in] adcShift
+ *   ADC LSBs that are always zero, 4 for plain 12 bit conversions.
+ *****************************************************************************/
+static inline void streamCodecBegin(streamCodec_t *c, uint8_t *buf, uint32_t len, uint8_t adcShift)
+{
+  uint32_t i;
+
+  for (i = 0; i < len; i++)
+  {
+    buf[i] = 0;
+  }
+  streamCodecReset(c, buf, len, adcShift);
+  buf[0] = c->adcShift;
+}
+
+/**************************************************************************//**
+ * @brief Check that one more sample fits whatever its residuals are.
+ *****************************************************************************/
+static inline bool streamCodecRoom(const streamCodec_t *c)
+{
+  uint32_t need = (c->count == 0) ? streamCodecRawBits(c) : STREAM_CODEC_WORST_BITS;
+
+  return (c->bits + need) <= c->capacity;
+}
+
+/**************************************************************************//**
+ * @brief Encode a sample.
+ * @param[in] v
+ *   CH0 and CH1 conversion results, the ADC sample and the time delta.
+ * @return
+ *   False if it does not fit, see streamCodecRoom().
+ *****************************************************************************/
+static inline bool streamCodecAdd(streamCodec_t *c, const uint32_t *v)
+{
+  uint32_t ch, x, mask, d, u, k, q;
+
+  if (!streamCodecRoom(c))
+  {
+    return false;
+  }
+
+  for (ch = 0; ch < STREAM_CODEC_CHANNELS; ch++)
+  {
+    mask = (1UL << c->width[ch]) - 1;
+    x = ((ch == 2) ? (v[ch] >> c->adcShift) : v[ch]) & mask;
+    if (c->count == 0)
+    {
+      streamCodecPut(c, x, c->width[ch]);
+    }
+    else
+    {
+      /* Zig-zag: 0, -1, 1, -2 ... to 0, 1, 2, 3 ... */
+      d = x - c->prev[ch];
+      u = ((int32_t)d < 0) ? ((~d << 1) | 1) : (d << 1);
+      k = streamCodecK(c, ch);
+      q = u >> k;
+      if (q < STREAM_CODEC_QMAX)
+      {
+        streamCodecPut(c, (1UL << q) - 1, q + 1);
+        streamCodecPut(c, u, k);
+      }
+      else
+      {
+        streamCodecPut(c, (1UL << STREAM_CODEC_QMAX) - 1, STREAM_CODEC_QMAX);
+        streamCodecPut(c, u, c->width[ch] + 1);
+      }
+      streamCodecAdapt(c, ch, u);
+    }
+    c->prev[ch] = x;
+  }
+  streamCodecNext(c);
+  return true;
+}
+
+/**************************************************************************//**
+ * @brief Bytes of the frame payload written so far.
+ *****************************************************************************/
+static inline uint32_t streamCodecBytes(const streamCodec_t *c)
+{
+  return (c->bits + 7) >> 3;
+}
+
+/**************************************************************************//**
+ * @brief Decode a frame payload.
+ * @param[in] buf
+ *   Frame payload after the stream header.
+ * @param[in] len
+ *   Payload length.
+ * @param[in] count
+ *   Samples in the frame, from the stream header.
+ * @param[out] out
+ *   count samples of STREAM_CODEC_CHANNELS values, the ADC back at 16 bit.
+ * @return
+ *   Samples decoded, less than count if the payload is truncated.
+ *****************************************************************************/
+static inline uint32_t streamCodecDecode(const uint8_t *buf, uint32_t len, uint32_t count,
+                                         uint32_t (*out)[STREAM_CODEC_CHANNELS])
+{
+  streamCodec_t c;
+  uint32_t i, ch, k, q, u, need;
+
+  if (len == 0)
+  {
+    return 0;
+  }
+  streamCodecReset(&c, (uint8_t *)buf, len, buf[0]);
+
+  for (i = 0; i < count; i++)
+  {
+    for (ch = 0; ch < STREAM_CODEC_CHANNELS; ch++)
+    {
+      if (i == 0)
+      {
+        if ((c.bits + c.width[ch]) > c.capacity)
+        {
+          return i;
+        }
+        c.prev[ch] = streamCodecGet(&c, c.width[ch]);
+      }
+      else
+      {
+        k = streamCodecK(&c, ch);
+        q = 0;
+        while (q < STREAM_CODEC_QMAX)
+        {
+          if (c.bits >= c.capacity)
+          {
+            return i;
+          }
+          if (!streamCodecGet(&c, 1))
+          {
+            break;
+          }
+          q++;
+        }
+        need = (q < STREAM_CODEC_QMAX) ? k : (uint32_t)(c.width[ch] + 1);
+        if ((c.bits + need) > c.capacity)
+        {
+          return i;
+        }
+        if (q < STREAM_CODEC_QMAX)
+        {
+          u = (q << k) | streamCodecGet(&c, k);
+        }
+        else
+        {
+          u = streamCodecGet(&c, need);
+        }
+        streamCodecAdapt(&c, ch, u);
+        c.prev[ch] = (c.prev[ch] + ((u & 1) ? ~(u >> 1) : (u >> 1))) & ((1UL << c.width[ch]) - 1);
+      }
+      out[i][ch] = (ch == 2) ? (c.prev[ch] << c.adcShift) : c.prev[ch];
+    }
+    streamCodecNext(&c);
+  }
+  return i;
+}
+
+#endif /* STREAM_CODEC_H_ */
@@ -0,0 +1,59 @@
+/*
+ * check.h
+ *
+ *  Minimal assertions for the host tests: a failed check prints where and
+ *  what, the test carries on and main() returns checkResult().
+ */
+
+#ifndef CHECK_H_
+#define CHECK_H_
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static unsigned int checkCount;
+static unsigned int checkFailed;
+
+#define CHECK(cond) \
+  do { \
+    checkCount++; \
+    if (!(cond)) { \
+      checkFailed++; \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+#define CHECK_EQ(actual, expected) \
+  do { \
+    long long a_ = (long long)(actual); \
+    long long e_ = (long long)(expected); \
+    checkCount++; \
+    if (a_ != e_) { \
+      checkFailed++; \
+      printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+    } \
+  } while (0)
+
+/**************************************************************************//**
+ * @brief Report the checks of one test program.
+ * @return
+ *   Exit code, 0 if all checks passed.
+ *****************************************************************************/
+static inline int checkResult(const char *name)
+{
+  printf("%s: %u checks, %u failed\n", name, checkCount, checkFailed);
+  return (checkFailed == 0) ? 0 : 1;
+}
+
+/**************************************************************************//**
+ * @brief Monotonic time in ns, for the benchmarks.
+ *****************************************************************************/
+static inline uint64_t checkNowNs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* CHECK_H_ */
@@ -0,0 +1,24 @@
+/*
+ * bg_types.h
+ *
+ *  Host stand-in for the BGAPI base types.
+ */
+
+#ifndef BG_TYPES_H_
+#define BG_TYPES_H_
+#include <stdint.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+
+typedef struct
+{
+  uint8 len;
+  uint8 data[];
+} uint8array;
+
+#endif /* BG_TYPES_H_ */
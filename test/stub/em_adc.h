@@ -0,0 +1,157 @@
+/*
+ * em_adc.h
+ *
+ *  Host stand-in for emlib ADC. A started single conversion completes at
+ *  once with the code stubAdcInput() returns for the selected input, see
+ *  stub.h.
+ */
+
+#ifndef EM_ADC_H_
+#define EM_ADC_H_
+#include "em_device.h"
+
+typedef enum
+{
+  adcOvsRateSel2, adcOvsRateSel4, adcOvsRateSel8, adcOvsRateSel16, adcOvsRateSel32,
+  adcOvsRateSel64, adcOvsRateSel128, adcOvsRateSel256, adcOvsRateSel512, adcOvsRateSel1024,
+  adcOvsRateSel2048, adcOvsRateSel4096
+} ADC_OvsRateSel_TypeDef;
+
+typedef enum
+{
+  adcEm2Disabled, adcEm2ClockOnDemand, adcEm2ClockAlwaysOn
+} ADC_EM2ClockConfig_TypeDef;
+
+typedef enum
+{
+  adcWarmupNormal
+} ADC_Warmup_TypeDef;
+
+typedef enum
+{
+  adcRes12Bit, adcRes8Bit, adcRes6Bit, adcResOVS
+} ADC_Res_TypeDef;
+
+typedef enum
+{
+  adcRef1V25, adcRef2V5, adcRefVDD, adcRef5VDIFF, adcRefExtSingle, adcRef2xExtDiff, adcRef2xVDD
+} ADC_Ref_TypeDef;
+
+typedef enum
+{
+  adcPosSelAPORT3XCH2 = 0x62, adcPosSelAPORT3YCH3 = 0x73, adcPosSelAPORT3XCH8 = 0x68,
+  adcPosSelAPORT3YCH9 = 0x79, adcPosSelAVDD = 0xE0, adcPosSelDVDD = 0xE4, adcPosSelVSS = 0xF0
+} ADC_PosSel_TypeDef;
+
+typedef enum
+{
+  adcNegSelAPORT3YCH9 = 0x79, adcNegSelVSS = 0xFF
+} ADC_NegSel_TypeDef;
+
+typedef enum
+{
+  adcPRSSELCh0, adcPRSSELCh1
+} ADC_PRSSEL_TypeDef;
+
+typedef enum
+{
+  adcAcqTime1, adcAcqTime2, adcAcqTime4, adcAcqTime8, adcAcqTime16, adcAcqTime32,
+  adcAcqTime64, adcAcqTime128, adcAcqTime256
+} ADC_AcqTime_TypeDef;
+
+typedef enum
+{
+  adcScanInputGroup0, adcScanInputGroup1, adcScanInputGroup2, adcScanInputGroup3
+} ADC_ScanInputGroup_TypeDef;
+
+typedef enum
+{
+  adcStartSingle = 1, adcStartScan = 4
+} ADC_Start_TypeDef;
+
+typedef struct
+{
+  ADC_OvsRateSel_TypeDef ovsRateSel;
+  ADC_Warmup_TypeDef warmUpMode;
+  uint8_t timebase;
+  uint8_t prescale;
+  bool tailgate;
+  ADC_EM2ClockConfig_TypeDef em2ClockConfig;
+} ADC_Init_TypeDef;
+
+typedef struct
+{
+  ADC_PRSSEL_TypeDef prsSel;
+  ADC_AcqTime_TypeDef acqTime;
+  ADC_Ref_TypeDef reference;
+  ADC_Res_TypeDef resolution;
+  ADC_PosSel_TypeDef posSel;
+  ADC_NegSel_TypeDef negSel;
+  bool diff;
+  bool prsEnable;
+  bool leftAdjust;
+  bool rep;
+  bool singleDmaEm2Wu;
+  bool fifoOverwrite;
+} ADC_InitSingle_TypeDef;
+
+typedef struct
+{
+  uint32_t scanInputSel;
+  uint32_t scanInputEn;
+  uint32_t scanNegSel;
+} ADC_InitScanInput_TypeDef;
+
+typedef struct
+{
+  ADC_PRSSEL_TypeDef prsSel;
+  ADC_AcqTime_TypeDef acqTime;
+  ADC_Ref_TypeDef reference;
+  ADC_Res_TypeDef resolution;
+  ADC_InitScanInput_TypeDef scanInputConfig;
+  bool diff;
+  bool prsEnable;
+  bool leftAdjust;
+  bool rep;
+  bool scanDmaEm2Wu;
+  bool fifoOverwrite;
+} ADC_InitScan_TypeDef;
+
+#define ADC_INIT_DEFAULT                        { adcOvsRateSel2, adcWarmupNormal, 0, 0, false, \
+                                                  adcEm2Disabled }
+#define ADC_INITSINGLE_DEFAULT                  { adcPRSSELCh0, adcAcqTime1, adcRef1V25, \
+                                                  adcRes12Bit, adcPosSelAPORT3XCH8, adcNegSelVSS, \
+                                                  false, false, false, false, false, false }
+#define ADC_INITSCAN_DEFAULT                    { adcPRSSELCh0, adcAcqTime1, adcRef1V25, \
+                                                  adcRes12Bit, { 0, 0, 0 }, false, false, false, \
+                                                  false, false, false }
+
+void ADC_Init(ADC_TypeDef *adc, const ADC_Init_TypeDef *init);
+void ADC_InitSingle(ADC_TypeDef *adc, const ADC_InitSingle_TypeDef *init);
+void ADC_InitScan(ADC_TypeDef *adc, const ADC_InitScan_TypeDef *init);
+void ADC_Reset(ADC_TypeDef *adc);
+void ADC_ScanInputClear(ADC_InitScan_TypeDef *scanInit);
+uint32_t ADC_ScanSingleEndedInputAdd(ADC_InitScan_TypeDef *scanInit,
+                                     ADC_ScanInputGroup_TypeDef inputGroup,
+                                     ADC_PosSel_TypeDef singleEndedSel);
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq);
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq);
+void ADC_Start(ADC_TypeDef *adc, ADC_Start_TypeDef cmd);
+uint32_t ADC_DataSingleGet(ADC_TypeDef *adc);
+
+static inline void ADC_IntClear(ADC_TypeDef *adc, uint32_t flags)
+{
+  adc->IF &= ~flags;
+}
+
+static inline void ADC_IntEnable(ADC_TypeDef *adc, uint32_t flags)
+{
+  adc->IEN |= flags;
+}
+
+static inline void ADC_IntDisable(ADC_TypeDef *adc, uint32_t flags)
+{
+  adc->IEN &= ~flags;
+}
+
+#endif /* EM_ADC_H_ */
@@ -0,0 +1,11 @@
+/*
+ * em_chip.h
+ *
+ *  Host stand-in, nothing of it is used by the tested modules.
+ */
+
+#ifndef EM_CHIP_H_
+#define EM_CHIP_H_
+#include "em_device.h"
+
+#endif /* EM_CHIP_H_ */
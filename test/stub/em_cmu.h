@@ -0,0 +1,32 @@
+/*
+ * em_cmu.h
+ *
+ *  Host stand-in for emlib CMU.
+ */
+
+#ifndef EM_CMU_H_
+#define EM_CMU_H_
+#include "em_device.h"
+
+typedef enum
+{
+  cmuClock_HFPER, cmuClock_CORELE, cmuClock_LFA, cmuClock_LFE, cmuClock_GPIO, cmuClock_PRS,
+  cmuClock_LDMA, cmuClock_RTCC, cmuClock_ADC0, cmuClock_I2C0, cmuClock_LETIMER0
+} CMU_Clock_TypeDef;
+
+typedef enum
+{
+  cmuSelect_LFRCO, cmuSelect_LFXO
+} CMU_Select_TypeDef;
+
+typedef enum
+{
+  cmuAUXHFRCOFreq_4M0Hz = 4000000, cmuAUXHFRCOFreq_19M0Hz = 19000000
+} CMU_AUXHFRCOFreq_TypeDef;
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref);
+void CMU_AUXHFRCOFreqSet(CMU_AUXHFRCOFreq_TypeDef freq);
+uint32_t CMU_AUXHFRCOBandGet(void);
+
+#endif /* EM_CMU_H_ */
@@ -0,0 +1,18 @@
+/*
+ * em_core.h
+ *
+ *  Host stand-in for emlib CORE: tests call the interrupt handlers from the
+ *  same thread, so critical sections need no locking.
+ */
+
+#ifndef EM_CORE_H_
+#define EM_CORE_H_
+
+#define CORE_DECLARE_IRQ_STATE          int irqState = 0
+#define CORE_ENTER_ATOMIC()             ((void)irqState)
+#define CORE_EXIT_ATOMIC()              ((void)irqState)
+#define CORE_ENTER_CRITICAL()           ((void)irqState)
+#define CORE_EXIT_CRITICAL()            ((void)irqState)
+#define CORE_ATOMIC_SECTION(yourcode)   { yourcode }
+
+#endif /* EM_CORE_H_ */
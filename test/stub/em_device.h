@@ -0,0 +1,117 @@
+/*
+ * em_device.h
+ *
+ *  Host stand-in for the EFR32BG1 device header: the registers the
+ *  application touches directly, backed by plain memory so tests can set
+ *  interrupt flags and read back configuration.
+ */
+
+#ifndef EM_DEVICE_H_
+#define EM_DEVICE_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct
+{
+  volatile uint32_t CTRL, CMD, STATUS, SINGLECTRL, SINGLECTRLX, SCANCTRL, SCANCTRLX;
+  volatile uint32_t SCANMASK, SCANINPUTSEL, SCANNEGSEL, CMPTHR, BIASPROG, CAL;
+  volatile uint32_t IF, IFS, IFC, IEN;
+  volatile uint32_t SINGLEDATA, SCANDATA, SINGLEDATAP, SCANDATAP, SCANDATAX, SCANDATAXP;
+  volatile uint32_t SINGLEFIFOCOUNT, SCANFIFOCOUNT, SINGLEFIFOCLEAR, SCANFIFOCLEAR;
+} ADC_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t ADCCTRL;
+} CMU_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t CTRL;
+} MSC_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t IFC, EXTIFALL;
+} GPIO_TypeDef;
+
+typedef struct
+{
+  volatile uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern ADC_TypeDef stubAdc0;
+extern CMU_TypeDef stubCmu;
+extern MSC_TypeDef stubMsc;
+extern GPIO_TypeDef stubGpio;
+extern DWT_Type stubDwt;
+extern CoreDebug_Type stubCoreDebug;
+
+#define ADC0                    (&stubAdc0)
+#define CMU                     (&stubCmu)
+#define MSC                     (&stubMsc)
+#define GPIO                    (&stubGpio)
+#define DWT                     (&stubDwt)
+#define CoreDebug               (&stubCoreDebug)
+
+typedef enum
+{
+  GPIO_EVEN_IRQn, I2C0_IRQn, GPIO_ODD_IRQn, LETIMER0_IRQn, RTCC_IRQn, ADC0_IRQn, LDMA_IRQn
+} IRQn_Type;
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+
+#define CoreDebug_DEMCR_TRCENA_Msk              (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk                  (1UL << 0)
+#define MSC_CTRL_IFCREADCLEAR                   (1UL << 4)
+#define CMU_ADCCTRL_ADC0CLKSEL_AUXHFRCO         (1UL << 4)
+#define _GPIO_IFC_MASK                          0xFFFFUL
+
+#define ADC_IF_SINGLE                           (1UL << 0)
+#define ADC_IF_SCAN                             (1UL << 1)
+#define ADC_IF_SINGLEOF                         (1UL << 8)
+#define ADC_IF_SCANOF                           (1UL << 9)
+#define ADC_IF_SINGLECMP                        (1UL << 16)
+#define ADC_IF_SCANCMP                          (1UL << 17)
+#define _ADC_IF_MASK                            0x00FF0F0FUL
+#define ADC_IEN_SINGLE                          ADC_IF_SINGLE
+#define ADC_IEN_SCAN                            ADC_IF_SCAN
+#define ADC_IEN_SINGLECMP                       ADC_IF_SINGLECMP
+#define ADC_IEN_SCANCMP                         ADC_IF_SCANCMP
+#define ADC_SINGLECTRL_CMPEN                    (1UL << 28)
+#define ADC_SINGLECTRL_PRSEN                    (1UL << 29)
+#define _ADC_SINGLECTRL_POSSEL_SHIFT            8
+#define _ADC_SINGLECTRL_POSSEL_MASK             0xFF00UL
+#define ADC_SCANCTRL_CMPEN                      (1UL << 28)
+#define ADC_SCANCTRL_PRSEN                      (1UL << 29)
+#define _ADC_SINGLECTRLX_RESETVALUE             0x00000000UL
+#define _ADC_SINGLECTRLX_DVL_SHIFT              12
+#define _ADC_SINGLECTRLX_DVL_MASK               0x7000UL
+#define _ADC_SCANCTRLX_DVL_SHIFT                12
+#define _ADC_SCANCTRLX_DVL_MASK                 0x7000UL
+#define _ADC_BIASPROG_RESETVALUE                0x00000000UL
+#define ADC_BIASPROG_GPBIASACC                  (1UL << 16)
+#define _ADC_CMPTHR_RESETVALUE                  0x00000000UL
+#define _ADC_CMPTHR_ADLT_SHIFT                  0
+#define _ADC_CMPTHR_ADGT_SHIFT                  16
+#define _ADC_CAL_SINGLEOFFSET_SHIFT             0
+#define _ADC_CAL_SINGLEOFFSET_MASK              0xFUL
+#define _ADC_CAL_SINGLEGAIN_SHIFT               8
+#define _ADC_CAL_SINGLEGAIN_MASK                0x7F00UL
+#define ADC_SINGLEFIFOCLEAR_SINGLEFIFOCLEAR     (1UL << 0)
+#define ADC_SCANFIFOCLEAR_SCANFIFOCLEAR         (1UL << 0)
+#define _ADC_SCANDATAX_DATA_SHIFT               0
+#define _ADC_SCANDATAX_DATA_MASK                0xFFFFUL
+#define _ADC_SCANDATAX_SCANINPUTID_SHIFT        16
+#define _ADC_SCANDATAX_SCANINPUTID_MASK         0x1F0000UL
+
+#endif /* EM_DEVICE_H_ */
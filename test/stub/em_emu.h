@@ -0,0 +1,11 @@
+/*
+ * em_emu.h
+ *
+ *  Host stand-in, nothing of it is used by the tested modules.
+ */
+
+#ifndef EM_EMU_H_
+#define EM_EMU_H_
+#include "em_device.h"
+
+#endif /* EM_EMU_H_ */
@@ -0,0 +1,27 @@
+/*
+ * em_gpio.h
+ *
+ *  Host stand-in for emlib GPIO.
+ */
+
+#ifndef EM_GPIO_H_
+#define EM_GPIO_H_
+#include "em_device.h"
+
+typedef enum
+{
+  gpioPortA, gpioPortB, gpioPortC, gpioPortD, gpioPortF = 5
+} GPIO_Port_TypeDef;
+
+typedef enum
+{
+  gpioModeDisabled, gpioModeInput, gpioModeInputPull, gpioModeInputPullFilter, gpioModePushPull
+} GPIO_Mode_TypeDef;
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode,
+                     unsigned int out);
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo,
+                       bool risingEdge, bool fallingEdge, bool enable);
+
+#endif /* EM_GPIO_H_ */
@@ -0,0 +1,42 @@
+/*
+ * em_i2c.h
+ *
+ *  Host stand-in for emlib I2C: the transfer description and its results,
+ *  the transfers themselves are simulated by the tests.
+ */
+
+#ifndef EM_I2C_H_
+#define EM_I2C_H_
+#include "em_device.h"
+
+#define I2C_FLAG_WRITE          0x0001
+#define I2C_FLAG_READ           0x0002
+#define I2C_FLAG_WRITE_READ     0x0004
+#define I2C_FLAG_WRITE_WRITE    0x0008
+
+#define I2C_FREQ_STANDARD_MAX   92000
+#define I2C_FREQ_FAST_MAX       392157
+
+typedef enum
+{
+  i2cTransferInProgress = 1,
+  i2cTransferDone = 0,
+  i2cTransferNack = -1,
+  i2cTransferBusErr = -2,
+  i2cTransferArbLost = -3,
+  i2cTransferUsageFault = -4,
+  i2cTransferSwFault = -5
+} I2C_TransferReturn_TypeDef;
+
+typedef struct
+{
+  uint16_t addr;
+  uint16_t flags;
+  struct
+  {
+    uint8_t *data;
+    uint16_t len;
+  } buf[2];
+} I2C_TransferSeq_TypeDef;
+
+#endif /* EM_I2C_H_ */
@@ -0,0 +1,61 @@
+/*
+ * em_ldma.h
+ *
+ *  Host stand-in for emlib LDMA. Transfers are not simulated: a test fills
+ *  the destination itself and raises the channel done flag in
+ *  stubLdmaIf before calling LDMA_IRQHandler(), see stub.h.
+ */
+
+#ifndef EM_LDMA_H_
+#define EM_LDMA_H_
+#include "em_device.h"
+
+typedef enum
+{
+  ldmaPeripheralSignal_NONE, ldmaPeripheralSignal_ADC0_SINGLE, ldmaPeripheralSignal_ADC0_SCAN
+} LDMA_PeripheralSignal_t;
+
+typedef enum
+{
+  ldmaCtrlSizeByte, ldmaCtrlSizeHalf, ldmaCtrlSizeWord
+} LDMA_CtrlSize_t;
+
+typedef struct
+{
+  uint8_t ldmaInitCtrlNumFixed;
+} LDMA_Init_t;
+
+typedef struct
+{
+  uint32_t ldmaReqSel;
+} LDMA_TransferCfg_t;
+
+typedef union
+{
+  struct
+  {
+    uint32_t xferCnt;
+    uint32_t blockSize;
+    bool ignoreSrec;
+    LDMA_CtrlSize_t size;
+    volatile const void *srcAddr;
+    void *dstAddr;
+    int32_t link;
+  } xfer;
+} LDMA_Descriptor_t;
+
+#define LDMA_INIT_DEFAULT                       { 0 }
+#define LDMA_TRANSFER_CFG_PERIPHERAL(signal)    { (uint32_t)(signal) }
+#define LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, dest, count, linkjmp) \
+  { .xfer = { (count), 0, false, ldmaCtrlSizeByte, (src), (dest), (linkjmp) } }
+
+void LDMA_Init(const LDMA_Init_t *init);
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer,
+                        const LDMA_Descriptor_t *descriptor);
+void LDMA_StopTransfer(int ch);
+uint32_t LDMA_IntGet(void);
+void LDMA_IntClear(uint32_t flags);
+void LDMA_IntEnable(uint32_t flags);
+void LDMA_IntDisable(uint32_t flags);
+
+#endif /* EM_LDMA_H_ */
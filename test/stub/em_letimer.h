@@ -0,0 +1,50 @@
+/*
+ * em_letimer.h
+ *
+ *  Host stand-in for emlib LETIMER.
+ */
+
+#ifndef EM_LETIMER_H_
+#define EM_LETIMER_H_
+#include "em_device.h"
+
+typedef struct
+{
+  volatile uint32_t CTRL;
+} LETIMER_TypeDef;
+
+extern LETIMER_TypeDef stubLetimer0;
+#define LETIMER0                (&stubLetimer0)
+
+typedef enum
+{
+  letimerUFOANone, letimerUFOAToggle, letimerUFOAPulse, letimerUFOAPwm
+} LETIMER_UFOA_TypeDef;
+
+typedef enum
+{
+  letimerRepeatFree, letimerRepeatOneshot
+} LETIMER_RepeatMode_TypeDef;
+
+typedef struct
+{
+  bool enable;
+  bool debugRun;
+  bool comp0Top;
+  bool bufTop;
+  uint8_t out0Pol;
+  uint8_t out1Pol;
+  LETIMER_UFOA_TypeDef ufoa0;
+  LETIMER_UFOA_TypeDef ufoa1;
+  LETIMER_RepeatMode_TypeDef repMode;
+} LETIMER_Init_TypeDef;
+
+#define LETIMER_INIT_DEFAULT                    { true, false, false, false, 0, 0, letimerUFOANone, \
+                                                  letimerUFOANone, letimerRepeatFree }
+
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init);
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value);
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value);
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable);
+
+#endif /* EM_LETIMER_H_ */
@@ -0,0 +1,20 @@
+/*
+ * em_prs.h
+ *
+ *  Host stand-in for emlib PRS.
+ */
+
+#ifndef EM_PRS_H_
+#define EM_PRS_H_
+#include "em_device.h"
+
+#define PRS_CH_CTRL_SOURCESEL_GPIOL             (0x6UL << 8)
+#define PRS_CH_CTRL_SOURCESEL_GPIOH             (0x7UL << 8)
+#define PRS_CH_CTRL_SOURCESEL_LETIMER0          (0x34UL << 8)
+#define PRS_CH_CTRL_SOURCESEL_RTCC              (0x29UL << 8)
+#define PRS_CH_CTRL_SIGSEL_LETIMER0CH0          0x0UL
+#define PRS_CH_CTRL_SIGSEL_RTCCCCV1             0x2UL
+
+void PRS_SourceAsyncSignalSet(unsigned int ch, uint32_t source, uint32_t signal);
+
+#endif /* EM_PRS_H_ */
@@ -0,0 +1,59 @@
+/*
+ * em_rtcc.h
+ *
+ *  Host stand-in for emlib RTCC. The counter only moves when a test sets
+ *  stubRtccCounter, see stub.h.
+ */
+
+#ifndef EM_RTCC_H_
+#define EM_RTCC_H_
+#include "em_device.h"
+
+typedef enum
+{
+  rtccPRSCh0, rtccPRSCh1
+} RTCC_PRSSel_TypeDef;
+
+typedef enum
+{
+  rtccCntPresc_1
+} RTCC_CntPresc_TypeDef;
+
+typedef enum
+{
+  rtccCntTickPresc, rtccCntTickCCV0Match
+} RTCC_PrescMode_TypeDef;
+
+typedef enum
+{
+  rtccCntModeNormal, rtccCntModeCalendar
+} RTCC_CntMode_TypeDef;
+
+typedef struct
+{
+  bool enable;
+  bool debugRun;
+  bool precntWrapOnCCV0;
+  bool cntWrapOnCCV1;
+  RTCC_CntPresc_TypeDef presc;
+  RTCC_PrescMode_TypeDef prescMode;
+  bool enaOSCFailDetect;
+  RTCC_CntMode_TypeDef cntMode;
+} RTCC_Init_TypeDef;
+
+typedef struct
+{
+  RTCC_PRSSel_TypeDef prsSel;
+} RTCC_CCChConf_TypeDef;
+
+#define RTCC_INIT_DEFAULT                       { true, false, false, false, rtccCntPresc_1, \
+                                                  rtccCntTickPresc, false, rtccCntModeNormal }
+#define RTCC_CH_INIT_COMPARE_DEFAULT            { rtccPRSCh0 }
+
+void RTCC_Init(const RTCC_Init_TypeDef *init);
+void RTCC_ChannelInit(int ch, const RTCC_CCChConf_TypeDef *confPtr);
+void RTCC_ChannelCCVSet(int ch, uint32_t value);
+uint32_t RTCC_ChannelCCVGet(int ch);
+uint32_t RTCC_CounterGet(void);
+
+#endif /* EM_RTCC_H_ */
@@ -0,0 +1,17 @@
+/*
+ * gpiointerrupt.h
+ *
+ *  Host stand-in for the GPIOINT driver: callbacks are kept in
+ *  stubGpioIntCallback for the tests to call, see stub.h.
+ */
+
+#ifndef GPIOINTERRUPT_H_
+#define GPIOINTERRUPT_H_
+#include <stdint.h>
+
+typedef void (*GPIOINT_IrqCallbackPtr_t)(uint8_t pin);
+
+void GPIOINT_Init(void);
+void GPIOINT_CallbackRegister(uint8_t pin, GPIOINT_IrqCallbackPtr_t callbackPtr);
+
+#endif /* GPIOINTERRUPT_H_ */
@@ -0,0 +1,16 @@
+/*
+ * infrastructure.h
+ *
+ *  Host stand-in for the stack infrastructure header, only the little
+ *  endian bitstream writers.
+ */
+
+#ifndef INFRASTRUCTURE_H_
+#define INFRASTRUCTURE_H_
+
+#define UINT8_TO_BITSTREAM(p, n)        { *(p)++ = (uint8_t)(n); }
+#define UINT16_TO_BITSTREAM(p, n)       { *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); }
+#define UINT32_TO_BITSTREAM(p, n)       { *(p)++ = (uint8_t)(n); *(p)++ = (uint8_t)((n) >> 8); \
+                                          *(p)++ = (uint8_t)((n) >> 16); *(p)++ = (uint8_t)((n) >> 24); }
+
+#endif /* INFRASTRUCTURE_H_ */
@@ -0,0 +1,14 @@
+/*
+ * native_gecko.h
+ *
+ *  Host stand-in for the Bluetooth stack API: only the external signal the
+ *  interrupt handlers raise, collected in stubSignals, see stub.h.
+ */
+
+#ifndef NATIVE_GECKO_H_
+#define NATIVE_GECKO_H_
+#include "bg_types.h"
+
+void gecko_external_signal(uint32 signals);
+
+#endif /* NATIVE_GECKO_H_ */
@@ -0,0 +1,13 @@
+/*
+ * si7013.h
+ *
+ *  Host stand-in for the Si7013 driver header, only the bus addresses.
+ */
+
+#ifndef SI7013_H_
+#define SI7013_H_
+
+#define SI7021_ADDR             0x80
+#define LDC1612_ADDR            0x54
+
+#endif /* SI7013_H_ */
@@ -0,0 +1,264 @@
+/*
+ * stub.c
+ *
+ *  Host stand-ins for the emlib and Bluetooth stack calls of the modules
+ *  under test, see stub.h.
+ */
+
+#include <string.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_prs.h"
+#include "em_rtcc.h"
+#include "em_adc.h"
+#include "em_ldma.h"
+#include "em_letimer.h"
+#include "em_gpio.h"
+#include "gpiointerrupt.h"
+#include "native_gecko.h"
+#include "stub.h"
+
+ADC_TypeDef stubAdc0;
+CMU_TypeDef stubCmu;
+MSC_TypeDef stubMsc;
+GPIO_TypeDef stubGpio;
+DWT_Type stubDwt;
+CoreDebug_Type stubCoreDebug;
+LETIMER_TypeDef stubLetimer0;
+
+uint32_t stubRtccCounter;
+uint32_t stubRtccCcv[3];
+uint32_t stubRtccCcvWrites[3];
+uint32_t stubLdmaIf;
+const void *stubLdmaDescr;
+uint32_t stubSignals;
+uint32_t stubAdcStarts;
+uint32_t (*stubAdcInput)(uint32_t posSel);
+uint32_t stubGpioIn;
+uint32_t stubGpioIntEnabled;
+void (*stubGpioIntCallback[16])(uint8_t pin);
+
+void stubReset(void)
+{
+  memset(&stubAdc0, 0, sizeof(stubAdc0));
+  memset(&stubDwt, 0, sizeof(stubDwt));
+  stubRtccCounter = 0;
+  memset(stubRtccCcv, 0, sizeof(stubRtccCcv));
+  memset(stubRtccCcvWrites, 0, sizeof(stubRtccCcvWrites));
+  stubLdmaIf = 0;
+  stubLdmaDescr = NULL;
+  stubSignals = 0;
+  stubAdcStarts = 0;
+  stubAdcInput = NULL;
+  stubGpioIn = 0xFFFF;
+  stubGpioIntEnabled = 0;
+  memset(stubGpioIntCallback, 0, sizeof(stubGpioIntCallback));
+}
+
+/* Core */
+void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+void NVIC_DisableIRQ(IRQn_Type irq) { (void)irq; }
+void NVIC_ClearPendingIRQ(IRQn_Type irq) { (void)irq; }
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+
+/* CMU */
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable) { (void)clock; (void)enable; }
+void CMU_ClockSelectSet(CMU_Clock_TypeDef clock, CMU_Select_TypeDef ref) { (void)clock; (void)ref; }
+void CMU_AUXHFRCOFreqSet(CMU_AUXHFRCOFreq_TypeDef freq) { (void)freq; }
+uint32_t CMU_AUXHFRCOBandGet(void) { return cmuAUXHFRCOFreq_4M0Hz; }
+
+/* PRS */
+void PRS_SourceAsyncSignalSet(unsigned int ch, uint32_t source, uint32_t signal)
+{
+  (void)ch;
+  (void)source;
+  (void)signal;
+}
+
+/* RTCC */
+void RTCC_Init(const RTCC_Init_TypeDef *init) { (void)init; }
+void RTCC_ChannelInit(int ch, const RTCC_CCChConf_TypeDef *confPtr) { (void)ch; (void)confPtr; }
+
+void RTCC_ChannelCCVSet(int ch, uint32_t value)
+{
+  stubRtccCcv[ch] = value;
+  stubRtccCcvWrites[ch]++;
+}
+
+uint32_t RTCC_ChannelCCVGet(int ch)
+{
+  return stubRtccCcv[ch];
+}
+
+uint32_t RTCC_CounterGet(void)
+{
+  return stubRtccCounter;
+}
+
+/* ADC */
+void ADC_Init(ADC_TypeDef *adc, const ADC_Init_TypeDef *init)
+{
+  adc->CTRL = (uint32_t)init->ovsRateSel << 24;
+}
+
+void ADC_InitSingle(ADC_TypeDef *adc, const ADC_InitSingle_TypeDef *init)
+{
+  adc->SINGLECTRL = ((uint32_t)init->posSel << _ADC_SINGLECTRL_POSSEL_SHIFT)
+                    | (init->prsEnable ? ADC_SINGLECTRL_PRSEN : 0);
+  /* Like emlib, SINGLECTRLX DVL and BIASPROG are left alone */
+}
+
+void ADC_InitScan(ADC_TypeDef *adc, const ADC_InitScan_TypeDef *init)
+{
+  adc->SCANCTRL = init->prsEnable ? ADC_SCANCTRL_PRSEN : 0;
+}
+
+void ADC_Reset(ADC_TypeDef *adc)
+{
+  memset(adc, 0, sizeof(*adc));
+}
+
+void ADC_ScanInputClear(ADC_InitScan_TypeDef *scanInit)
+{
+  memset(&scanInit->scanInputConfig, 0, sizeof(scanInit->scanInputConfig));
+}
+
+uint32_t ADC_ScanSingleEndedInputAdd(ADC_InitScan_TypeDef *scanInit,
+                                     ADC_ScanInputGroup_TypeDef inputGroup,
+                                     ADC_PosSel_TypeDef singleEndedSel)
+{
+  uint32_t id = ((uint32_t)inputGroup * 8) + ((uint32_t)singleEndedSel & 7);
+
+  scanInit->scanInputConfig.scanInputEn |= 1UL << id;
+  return id;
+}
+
+uint8_t ADC_TimebaseCalc(uint32_t hfperFreq)
+{
+  (void)hfperFreq;
+  return 4;
+}
+
+uint8_t ADC_PrescaleCalc(uint32_t adcFreq, uint32_t hfperFreq)
+{
+  (void)adcFreq;
+  (void)hfperFreq;
+  return 3;
+}
+
+void ADC_Start(ADC_TypeDef *adc, ADC_Start_TypeDef cmd)
+{
+  uint32_t posSel = (adc->SINGLECTRL & _ADC_SINGLECTRL_POSSEL_MASK) >> _ADC_SINGLECTRL_POSSEL_SHIFT;
+
+  if (cmd == adcStartSingle)
+  {
+    adc->SINGLEDATA = (stubAdcInput != NULL) ? stubAdcInput(posSel) : 0;
+    adc->SINGLEFIFOCOUNT = 1;
+    stubAdcStarts++;
+  }
+}
+
+uint32_t ADC_DataSingleGet(ADC_TypeDef *adc)
+{
+  if (adc->SINGLEFIFOCOUNT > 0)
+  {
+    adc->SINGLEFIFOCOUNT--;
+  }
+  return adc->SINGLEDATA;
+}
+
+/* LDMA */
+void LDMA_Init(const LDMA_Init_t *init) { (void)init; }
+
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *transfer,
+                        const LDMA_Descriptor_t *descriptor)
+{
+  (void)ch;
+  (void)transfer;
+  stubLdmaDescr = descriptor;
+}
+
+void LDMA_StopTransfer(int ch)
+{
+  (void)ch;
+  stubLdmaDescr = NULL;
+}
+
+uint32_t LDMA_IntGet(void) { return stubLdmaIf; }
+void LDMA_IntClear(uint32_t flags) { stubLdmaIf &= ~flags; }
+void LDMA_IntEnable(uint32_t flags) { (void)flags; }
+void LDMA_IntDisable(uint32_t flags) { (void)flags; }
+
+/* LETIMER */
+void LETIMER_Init(LETIMER_TypeDef *letimer, const LETIMER_Init_TypeDef *init)
+{
+  letimer->CTRL = init->enable;
+}
+
+void LETIMER_CompareSet(LETIMER_TypeDef *letimer, unsigned int comp, uint32_t value)
+{
+  (void)letimer;
+  (void)comp;
+  (void)value;
+}
+
+void LETIMER_RepeatSet(LETIMER_TypeDef *letimer, unsigned int rep, uint32_t value)
+{
+  (void)letimer;
+  (void)rep;
+  (void)value;
+}
+
+void LETIMER_Enable(LETIMER_TypeDef *letimer, bool enable)
+{
+  letimer->CTRL = enable;
+}
+
+/* GPIO */
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode,
+                     unsigned int out)
+{
+  (void)port;
+  (void)pin;
+  (void)mode;
+  (void)out;
+}
+
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin)
+{
+  (void)port;
+  return (stubGpioIn >> pin) & 1;
+}
+
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo,
+                       bool risingEdge, bool fallingEdge, bool enable)
+{
+  (void)port;
+  (void)pin;
+  (void)risingEdge;
+  (void)fallingEdge;
+  if (enable)
+  {
+    stubGpioIntEnabled |= (1UL << intNo);
+  }
+  else
+  {
+    stubGpioIntEnabled &= ~(1UL << intNo);
+  }
+}
+
+/* GPIOINT */
+void GPIOINT_Init(void)
+{
+}
+
+void GPIOINT_CallbackRegister(uint8_t pin, GPIOINT_IrqCallbackPtr_t callbackPtr)
+{
+  stubGpioIntCallback[pin] = callbackPtr;
+}
+
+/* Bluetooth stack */
+void gecko_external_signal(uint32 signals)
+{
+  stubSignals |= signals;
+}
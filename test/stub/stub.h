@@ -0,0 +1,48 @@
+/*
+ * stub.h
+ *
+ *  State behind the host stand-ins for emlib and the Bluetooth stack, so
+ *  tests can drive the interrupt handlers and check what the code under
+ *  test did to the peripherals.
+ */
+
+#ifndef STUB_H_
+#define STUB_H_
+#include <stdint.h>
+#include <stdbool.h>
+
+/* RTCC counter, set by the test */
+extern uint32_t stubRtccCounter;
+
+/* Compare values and how often each was written */
+extern uint32_t stubRtccCcv[3];
+extern uint32_t stubRtccCcvWrites[3];
+
+/* LDMA channel done flags returned by LDMA_IntGet() */
+extern uint32_t stubLdmaIf;
+
+/* Transfer started last, NULL after LDMA_StopTransfer() */
+extern const void *stubLdmaDescr;
+
+/* gecko_external_signal() bits since the last stubReset() */
+extern uint32_t stubSignals;
+
+/* Conversions started with ADC_Start() */
+extern uint32_t stubAdcStarts;
+
+/* Input level per GPIO pin number, all high after stubReset() */
+extern uint32_t stubGpioIn;
+
+/* Enabled edge interrupts per interrupt number, and the GPIOINT callbacks */
+extern uint32_t stubGpioIntEnabled;
+extern void (*stubGpioIntCallback[16])(uint8_t pin);
+
+/* Code converted from a single-ended input, POSSEL value as in em_adc.h */
+extern uint32_t (*stubAdcInput)(uint32_t posSel);
+
+/**************************************************************************//**
+ * @brief Clear the registers and recorded state.
+ *****************************************************************************/
+void stubReset(void);
+
+#endif /* STUB_H_ */
@@ -0,0 +1,468 @@
+/*
+ * test_adc.c
+ *
+ *  adc.c on the host against the emlib stand-ins in stub/: RTCC CC1
+ *  scheduling of the PRS triggers, their jitter statistics, the LDMA
+ *  ping-pong hand-off of adcBuffer, the scan demultiplexing into the channel
+ *  rings, the window compare profile and the two point calibration, and a
+ *  benchmark of the hand-off.
+ */
+
+#include "adc.h"
+#include "app_signal.h"
+#include "stub.h"
+#include "check.h"
+
+void ADC0_IRQHandler(void);
+void LDMA_IRQHandler(void);
+
+/* htm.c is not linked, adcSingleScan() reports to it */
+void getADCValue(uint32_t sample)
+{
+  (void)sample;
+}
+
+/* Let the conversion triggered by CC1 complete latency ticks after the compare */
+static uint32_t convert(uint32_t latency)
+{
+  uint32_t compare = stubRtccCcv[RTCC_CC_CHANNEL];
+
+  stubRtccCounter = compare + latency;
+  ADC0->IFC = ADC_IF_SINGLE;
+  ADC0_IRQHandler();
+  return stubRtccCcv[RTCC_CC_CHANNEL] - compare;
+}
+
+static void start(uint32_t counter)
+{
+  stubReset();
+  adcStreamStop();
+  stubRtccCounter = counter;
+  adcSetup();
+  CHECK(adcSetTriggerPeriod(RTCC_WAKEUP_MS));
+  adcStreamStart();
+}
+
+static void testSchedule(void)
+{
+  tickJitter_t jitter;
+  uint32_t first, i, step;
+
+  /* 10 ms are 327.68 ticks: 1000 triggers take exactly 327680 ticks */
+  start(1000);
+  first = stubRtccCcv[RTCC_CC_CHANNEL];
+  CHECK_EQ(first, 1000 + 327);
+  for (i = 1; i < 1000; i++)
+  {
+    step = convert(3);
+    CHECK((step == 327) || (step == 328));
+  }
+  CHECK_EQ(stubRtccCcv[RTCC_CC_CHANNEL] - 1000, 327680);
+
+  adcGetTriggerJitter(&jitter);
+  CHECK_EQ(jitter.count, 999);
+  CHECK_EQ(jitter.min, 3);
+  CHECK_EQ(jitter.max, 3);
+  CHECK_EQ(jitter.sumAbs, 999 * 3);
+  CHECK_EQ(jitter.skipped, 0);
+
+  /* The schedule continues across the counter wrap */
+  start(0xFFFFFF00UL);
+  convert(0);
+  CHECK_EQ(stubRtccCcv[RTCC_CC_CHANNEL], (uint32_t)(0xFFFFFF00UL + 327 + 328));
+  adcGetTriggerJitter(&jitter);
+  CHECK_EQ(jitter.skipped, 0);
+}
+
+static void testStall(void)
+{
+  tickJitter_t jitter;
+  uint32_t first, now;
+
+  /* Served 3.5 periods late: the three triggers already over are skipped */
+  start(0);
+  first = stubRtccCcv[RTCC_CC_CHANNEL];
+  now = first + (3 * 328) + 150;
+  stubRtccCounter = now;
+  ADC0->IFC = ADC_IF_SINGLE;
+  ADC0_IRQHandler();
+  CHECK((int32_t)(stubRtccCcv[RTCC_CC_CHANNEL] - now) > 0);
+  CHECK_EQ(stubRtccCcv[RTCC_CC_CHANNEL], 5 * 327 + 3);       /* Same phase as without stall */
+  adcGetTriggerJitter(&jitter);
+  CHECK_EQ(jitter.count, 1);
+  CHECK_EQ(jitter.max, (3 * 328) + 150);
+  CHECK_EQ(jitter.skipped, 3);
+
+  /* A trigger due at the very tick the interrupt runs is over as well, the sixth step is 328 */
+  first = stubRtccCcv[RTCC_CC_CHANNEL];
+  stubRtccCounter = first + 328;
+  ADC0->IFC = ADC_IF_SINGLE;
+  ADC0_IRQHandler();
+  CHECK((int32_t)(stubRtccCcv[RTCC_CC_CHANNEL] - stubRtccCounter) > 0);
+  adcGetTriggerJitter(&jitter);
+  CHECK_EQ(jitter.skipped, 4);
+
+  /* Statistics restart, the next on-time trigger counts nothing */
+  adcResetTriggerJitter();
+  convert(1);
+  adcGetTriggerJitter(&jitter);
+  CHECK_EQ(jitter.count, 1);
+  CHECK_EQ(jitter.skipped, 0);
+}
+
+static void testPeriodChange(void)
+{
+  tickJitter_t jitter;
+  uint32_t now;
+
+  CHECK(!adcSetTriggerPeriod(0));
+  CHECK(!adcSetTriggerPeriod(ADC_TRIG_PERIOD_MAX_MS + 1));
+
+  /* The trigger already armed keeps its time, the next one is 20 ms later */
+  start(0);
+  CHECK(adcSetTriggerPeriod(20));
+  CHECK_EQ(stubRtccCcv[RTCC_CC_CHANNEL], 327);
+  CHECK_EQ(convert(2), 655);
+  CHECK_EQ(convert(2), 655);
+  CHECK_EQ(convert(2), 656);
+  CHECK_EQ(adcGetTriggerPeriod(), 20);
+
+  /* A stall right when the new period is taken over skips whole new periods */
+  CHECK(adcSetTriggerPeriod(50));
+  now = stubRtccCcv[RTCC_CC_CHANNEL] + (2 * 1639) + 10;
+  stubRtccCounter = now;
+  ADC0->IFC = ADC_IF_SINGLE;
+  ADC0_IRQHandler();
+  CHECK((int32_t)(stubRtccCcv[RTCC_CC_CHANNEL] - now) > 0);
+  CHECK((stubRtccCcv[RTCC_CC_CHANNEL] - now) <= 1639);
+  adcGetTriggerJitter(&jitter);
+  CHECK_EQ(jitter.skipped, 2);
+  adcStreamStop();
+}
+
+static void testCycleStats(void)
+{
+  adcCycleStats_t stats;
+  uint32_t i;
+
+  /* Profile changes and samples are counted apart */
+  start(0);
+  adcGetCycleStats(&stats);
+  CHECK_EQ(stats.configure.count, 1);
+  CHECK_EQ(stats.sample.count, 0);
+  for (i = 0; i < 5; i++)
+  {
+    convert(1);
+  }
+  adcStreamStart();           /* Running with the same profile, nothing to configure */
+  adcGetCycleStats(&stats);
+  CHECK_EQ(stats.configure.count, 1);
+  CHECK_EQ(stats.sample.count, 5);
+
+  adcResetCycleStats();
+  adcGetCycleStats(&stats);
+  CHECK_EQ(stats.configure.count, 0);
+  CHECK_EQ(stats.sample.count, 0);
+  CHECK_EQ(stats.sample.max, 0);
+  adcStreamStop();
+}
+
+/* Fill one half as LDMA would and raise its done interrupt */
+static void ldmaHalfDone(uint32_t half, uint32_t base)
+{
+  uint32_t i;
+
+  for (i = 0; i < ADC_BUFFER_HALF; i++)
+  {
+    adcBuffer[(half * ADC_BUFFER_HALF) + i] = base + i;
+  }
+  stubLdmaIf |= ADC_DMA_CH_MASK;
+  LDMA_IRQHandler();
+}
+
+static void testHandoff(void)
+{
+  const LDMA_Descriptor_t *descr;
+  const uint32_t *block;
+  uint32_t i;
+  bool same;
+
+  start(0);
+
+  /* Two halves of ADC_BUFFER_HALF words, linked to each other */
+  descr = stubLdmaDescr;
+  CHECK(descr != NULL);
+  CHECK(descr[0].xfer.dstAddr == &adcBuffer[0]);
+  CHECK(descr[1].xfer.dstAddr == &adcBuffer[ADC_BUFFER_HALF]);
+  CHECK(descr[0].xfer.srcAddr == &ADC0->SINGLEDATA);
+  CHECK_EQ(descr[0].xfer.xferCnt, ADC_BUFFER_HALF);
+  CHECK_EQ(descr[0].xfer.link, 1);
+  CHECK_EQ(descr[1].xfer.link, -1);
+  CHECK(adcStreamGetBlock() == NULL);
+
+  /* First half: signalled and handed over in order */
+  ldmaHalfDone(0, 100);
+  CHECK(stubSignals & APP_SIGNAL_ADC_HALF);
+  block = adcStreamGetBlock();
+  CHECK(block == &adcBuffer[0]);
+  same = true;
+  for (i = 0; i < ADC_BUFFER_HALF; i++)
+  {
+    same = same && (block[i] == 100 + i);
+  }
+  CHECK(same);
+
+  /* Second half completes while the first is still held */
+  ldmaHalfDone(1, 200);
+  CHECK(adcStreamGetBlock() == &adcBuffer[0]);
+  adcStreamReleaseBlock();
+  block = adcStreamGetBlock();
+  CHECK(block == &adcBuffer[ADC_BUFFER_HALF]);
+  CHECK_EQ(block[0], 200);
+  adcStreamReleaseBlock();
+  CHECK(adcStreamGetBlock() == NULL);
+  CHECK_EQ(adcStreamGetOverruns(), 0);
+
+  /* Three halves without a release: the first one is refilled */
+  ldmaHalfDone(0, 300);
+  ldmaHalfDone(1, 400);
+  ldmaHalfDone(0, 500);
+  CHECK_EQ(adcStreamGetOverruns(), 1);
+  CHECK(adcStreamGetBlock() == &adcBuffer[0]);
+  CHECK_EQ(adcStreamGetBlock()[0], 500);
+
+  /* Stopping releases LDMA and drops the halves still held */
+  adcStreamStop();
+  CHECK(stubLdmaDescr == NULL);
+  CHECK(adcStreamGetBlock() == NULL);
+}
+
+/* SCANDATAX input IDs of PA0, PA1, PD10 and PD11 as the stand-in ADC_ScanSingleEndedInputAdd()
+ * numbers them: group * 8 + APORT channel & 7 */
+static const uint32_t scanId[ADC_SCAN_CHANNELS] = { 0, 1, 10, 11 };
+
+/* Fill one half with sequences of the channels in mask, sample n of channel ch is ch * 1000 + n */
+static void scanHalfDone(uint32_t half, uint32_t mask, uint32_t seq)
+{
+  uint32_t count = 0, i, ch;
+  uint32_t *p;
+
+  for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++)
+  {
+    count += (mask >> ch) & 1;
+  }
+  p = &adcBuffer[half * count * ADC_SCAN_SEQ_PER_HALF];
+  for (i = 0; i < ADC_SCAN_SEQ_PER_HALF; i++)
+  {
+    for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++)
+    {
+      if (mask & (1 << ch))
+      {
+        *p++ = (scanId[ch] << _ADC_SCANDATAX_SCANINPUTID_SHIFT) | ((ch * 1000) + seq + i);
+      }
+    }
+  }
+  stubLdmaIf |= ADC_DMA_CH_MASK;
+  LDMA_IRQHandler();
+}
+
+static void testScan(void)
+{
+  const uint32_t mask = ADC_SCAN_CH_PA0 | ADC_SCAN_CH_PD10 | ADC_SCAN_CH_PD11;
+  const LDMA_Descriptor_t *descr;
+  uint32_t ch, n, half;
+  uint16_t sample;
+  bool inOrder;
+
+  start(0);
+  adcScanStart(mask);
+  CHECK_EQ(adcScanGetMask(), mask);
+
+  /* One LDMA request per scan sequence of 3 results */
+  descr = stubLdmaDescr;
+  CHECK(descr != NULL);
+  CHECK(descr[0].xfer.srcAddr == &ADC0->SCANDATAX);
+  CHECK_EQ(descr[0].xfer.xferCnt, 3 * ADC_SCAN_SEQ_PER_HALF);
+  CHECK(descr[1].xfer.dstAddr == &adcBuffer[3 * ADC_SCAN_SEQ_PER_HALF]);
+  CHECK_EQ(ADC_SCAN_RING_SIZE % ADC_SCAN_SEQ_PER_HALF, 0);
+
+  /* Each result lands in the ring of its input ID, in order, and nothing in PA1 */
+  scanHalfDone(0, mask, 0);
+  scanHalfDone(1, mask, ADC_SCAN_SEQ_PER_HALF);
+  CHECK(stubSignals & APP_SIGNAL_ADC_SCAN);
+  CHECK(!adcScanRead(1, &sample));
+  for (ch = 0; ch < ADC_SCAN_CHANNELS; ch++)
+  {
+    if (!(mask & (1 << ch)))
+    {
+      continue;
+    }
+    inOrder = true;
+    for (n = 0; adcScanRead(ch, &sample); n++)
+    {
+      inOrder = inOrder && (sample == (ch * 1000) + n);
+    }
+    CHECK(inOrder);
+    CHECK_EQ(n, 2 * ADC_SCAN_SEQ_PER_HALF);
+    CHECK_EQ(adcScanGetDrops(ch), 0);
+  }
+
+  /* A full ring keeps its oldest samples and counts the new ones it drops */
+  for (half = 0; half <= ADC_SCAN_RING_SIZE / ADC_SCAN_SEQ_PER_HALF; half++)
+  {
+    scanHalfDone(half & 1, mask, half * ADC_SCAN_SEQ_PER_HALF);
+  }
+  CHECK_EQ(adcScanGetDrops(0), ADC_SCAN_SEQ_PER_HALF);
+  CHECK_EQ(adcScanGetDrops(3), ADC_SCAN_SEQ_PER_HALF);
+  inOrder = true;
+  for (n = 0; adcScanRead(2, &sample); n++)
+  {
+    inOrder = inOrder && (sample == 2000 + n);
+  }
+  CHECK(inOrder);
+  CHECK_EQ(n, ADC_SCAN_RING_SIZE);
+
+  /* Reading makes room again, LDMA moved on to the second half */
+  scanHalfDone(1, mask, 0);
+  CHECK_EQ(adcScanGetDrops(2), ADC_SCAN_SEQ_PER_HALF);
+  CHECK(adcScanRead(2, &sample));
+  CHECK_EQ(sample, 2000);
+
+  /* A restart empties the rings and clears the drops */
+  adcScanStart(ADC_SCAN_CH_PA1);
+  CHECK_EQ(adcScanGetMask(), ADC_SCAN_CH_PA1);
+  CHECK(!adcScanRead(0, &sample));
+  CHECK_EQ(adcScanGetDrops(0), 0);
+  scanHalfDone(0, ADC_SCAN_CH_PA1, 5);
+  CHECK(adcScanRead(1, &sample));
+  CHECK_EQ(sample, 1005);
+
+  adcStreamStop();
+  CHECK_EQ(adcScanGetMask(), 0);
+}
+
+static void testWindow(void)
+{
+  const LDMA_Descriptor_t *descr;
+
+  start(0);
+  descr = stubLdmaDescr;
+
+  /* A rejected window leaves the stream running */
+  CHECK(!adcWindowStart(3000, 1000));
+  CHECK(stubLdmaDescr == descr);
+  CHECK(adcStreamGetBlock() == NULL);
+  ldmaHalfDone(0, 0);
+  CHECK(adcStreamGetBlock() == &adcBuffer[0]);
+
+  /* Monitoring takes ADC0 over with its own bias and FIFO level */
+  CHECK(adcWindowStart(1000, 3000));
+  CHECK(stubLdmaDescr == NULL);
+  CHECK_EQ(ADC0->BIASPROG, ADC_BIASPROG_GPBIASACC);
+  CHECK_EQ((ADC0->SINGLECTRLX & _ADC_SINGLECTRLX_DVL_MASK) >> _ADC_SINGLECTRLX_DVL_SHIFT,
+           ADC_WINDOW_CONTEXT - 1);
+
+  /* The stream afterwards is back to one sample per LDMA request at full bias */
+  adcWindowStop();
+  adcStreamStart();
+  CHECK_EQ(ADC0->BIASPROG, 0);
+  CHECK_EQ(ADC0->SINGLECTRLX & _ADC_SINGLECTRLX_DVL_MASK, 0);
+  CHECK(ADC0->SINGLECTRL & ADC_SINGLECTRL_PRSEN);
+  CHECK(!(ADC0->SINGLECTRL & ADC_SINGLECTRL_CMPEN));
+  adcStreamStop();
+}
+
+/* 16 bit codes of an ADC with an offset of 160 and a gain 1 % high, PA0 left floating low */
+static uint32_t calInput(uint32_t posSel)
+{
+  switch (posSel)
+  {
+    case adcPosSelVSS:
+      return 160;
+    case adcPosSelAVDD:
+      return 160 + ((16384 * 101) / 100);
+    default:
+      return 90;
+  }
+}
+
+/* Gain point lost, e.g. a wrong input: nothing plausible to calibrate against */
+static uint32_t calInputBroken(uint32_t posSel)
+{
+  return (posSel == adcPosSelVSS) ? 160 : 4000;
+}
+
+static void testCalibrate(void)
+{
+  adcCal_t cal, bad;
+
+  stubReset();
+  adcStreamStop();
+  adcSetup();
+
+  /* Internal points only, PA0 is not converted */
+  stubAdcInput = calInput;
+  CHECK(adcCalibrate());
+  CHECK_EQ(stubAdcStarts, 2 * ADC_CAL_SAMPLES);
+  adcGetCalibration(&cal);
+  CHECK_EQ(cal.offset, 160);
+  CHECK_EQ(adcToMilliVolt(160 + ((16384 * 101) / 100), 16), ADC_CAL_GAIN_MV);
+  CHECK_EQ(adcToMilliVolt(160 + 32768, 16), 1634);        /* 1650 mV / 1.01 */
+
+  /* Rejected measurements and stored values keep the coefficients in use */
+  stubAdcInput = calInputBroken;
+  CHECK(!adcCalibrate());
+  bad.offset = 30000;
+  bad.scale = cal.scale;
+  CHECK(!adcSetCalibration(&bad));
+  bad.offset = 0;
+  bad.scale = 0;
+  CHECK(!adcSetCalibration(&bad));
+  adcGetCalibration(&bad);
+  CHECK_EQ(bad.offset, cal.offset);
+  CHECK_EQ(bad.scale, cal.scale);
+
+  /* Not while the stream owns ADC0 */
+  stubAdcInput = calInput;
+  adcStreamStart();
+  CHECK(!adcCalibrate());
+  adcStreamStop();
+}
+
+static void benchmark(void)
+{
+  uint32_t half;
+  uint64_t t0, ns;
+
+  /* Interrupt and main loop side of each half, without LDMA filling it */
+  start(0);
+  t0 = checkNowNs();
+  for (half = 0; half < 1000000; half++)
+  {
+    stubLdmaIf |= ADC_DMA_CH_MASK;
+    LDMA_IRQHandler();
+    while (adcStreamGetBlock() != NULL)
+    {
+      adcStreamReleaseBlock();
+    }
+  }
+  ns = checkNowNs() - t0;
+  CHECK_EQ(adcStreamGetOverruns(), 0);
+  adcStreamStop();
+  printf("ADC hand-off: %.1f ns per half of %u samples, %.2f ns per sample\n",
+         (double)ns / half, ADC_BUFFER_HALF, (double)ns / half / ADC_BUFFER_HALF);
+}
+
+int main(void)
+{
+  testSchedule();
+  testStall();
+  testPeriodChange();
+  testCycleStats();
+  testHandoff();
+  testScan();
+  testWindow();
+  testCalibrate();
+  benchmark();
+  return checkResult("test_adc");
+}
@@ -0,0 +1,179 @@
+/*
+ * test_adc_conv.c
+ *
+ *  Fixed-point calibration math of adc_conv.h against a double reference,
+ *  and the time adcConvToMilliVolt() takes per sample against it.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "adc_conv.h"
+#include "check.h"
+
+/* Millivolts the coefficients should give, in double */
+static double reference(uint32_t zero, uint32_t ref, double refMilliVolt, uint32_t sample,
+                        uint32_t bits)
+{
+  double code = (double)(sample << (16 - bits));
+
+  return (code - zero) * refMilliVolt / (double)(ref - zero);
+}
+
+static void testDefault(void)
+{
+  adcCal_t cal;
+
+  adcConvDefault(&cal);
+  CHECK_EQ(cal.offset, 0);
+  CHECK_EQ(adcConvToMilliVolt(&cal, 0, 16), 0);
+  CHECK_EQ(adcConvToMilliVolt(&cal, 32768, 16), 1650);
+  CHECK_EQ(adcConvToMilliVolt(&cal, 2048, 12), 1650);
+  CHECK_EQ(adcConvToMilliVolt(&cal, 65535, 16), 3300);
+  CHECK_EQ(adcConvCheck(&cal, 0, 0), 0);
+}
+
+static void testCalibrate(void)
+{
+  static const struct
+  {
+    uint32_t zero;
+    uint32_t ref;
+  } points[] =
+  {
+    { 0, 16384 }, { 160, 16384 + 160 }, { 300, 16100 }, { 40, 16900 }, { 1000, 17000 }
+  };
+  adcCal_t cal;
+  uint32_t i, sample, bits;
+  double error, maxError;
+  int32_t mv;
+
+  /* Both directions over the whole 16 and 12 bit range. Rounding costs 0.5 mV, the Q16 scale
+   * another 0.5 mV at full scale. */
+  adcConvDefault(&cal);
+  for (i = 0; i < sizeof(points) / sizeof(points[0]); i++)
+  {
+    CHECK_EQ(adcConvCalibrate(&cal, points[i].zero, points[i].ref, 825), 0);
+    CHECK_EQ(cal.offset, points[i].zero);
+    for (bits = 12; bits <= 16; bits += 4)
+    {
+      maxError = 0;
+      for (sample = 0; sample < (1UL << bits); sample++)
+      {
+        mv = adcConvToMilliVolt(&cal, sample, bits);
+        error = fabs(mv - reference(points[i].zero, points[i].ref, 825, sample, bits));
+        if (error > maxError)
+        {
+          maxError = error;
+        }
+      }
+      CHECK(maxError <= 1.0);
+    }
+
+    /* Back to a code: within one 12 bit LSB of the code that gave the voltage */
+    for (sample = 0; sample < 4096; sample += 7)
+    {
+      mv = adcConvToMilliVolt(&cal, sample, 12);
+      if ((mv > 0) && (mv < 3000))
+      {
+        CHECK(labs((long)adcConvFromMilliVolt(&cal, mv, 12) - (long)sample) <= 1);
+      }
+    }
+  }
+
+  /* The gain point itself reads back as the reference voltage */
+  CHECK_EQ(adcConvCalibrate(&cal, 200, 16600, 825), 0);
+  CHECK_EQ(adcConvToMilliVolt(&cal, 16600, 16), 825);
+  CHECK_EQ(adcConvToMilliVolt(&cal, 200, 16), 0);
+
+  /* No positive gain */
+  CHECK_EQ(adcConvCalibrate(&cal, 500, 500, 825), -1);
+  CHECK_EQ(adcConvCalibrate(&cal, 600, 500, 825), -1);
+}
+
+static void testClamp(void)
+{
+  adcCal_t cal;
+
+  CHECK_EQ(adcConvCalibrate(&cal, 320, 16384 + 320, 825), 0);
+  CHECK_EQ(adcConvFromMilliVolt(&cal, -100, 12), 0);
+  CHECK_EQ(adcConvFromMilliVolt(&cal, 4000, 12), 4095);
+  CHECK_EQ(adcConvFromMilliVolt(&cal, 4000, 16), 65535);
+  CHECK_EQ(adcConvFromMilliVolt(&cal, 0, 16), 320);
+}
+
+static void testCheck(void)
+{
+  adcCal_t cal;
+
+  /* 2 % gain error, offset 100 */
+  CHECK_EQ(adcConvCalibrate(&cal, 100, 100 + 16056, 825), 0);
+  CHECK_EQ(adcConvCheck(&cal, 1024, 50), 0);
+  CHECK_EQ(adcConvCheck(&cal, 1024, 10), -1);
+  CHECK_EQ(adcConvCheck(&cal, 99, 50), -1);
+
+  /* PA0 floating instead of a reference: far off the expected gain */
+  CHECK_EQ(adcConvCalibrate(&cal, 100, 4000, 825), 0);
+  CHECK_EQ(adcConvCheck(&cal, 1024, 50), -1);
+
+  /* Negative offsets are limited the same way */
+  cal.offset = -1025;
+  cal.scale = 3300;
+  CHECK_EQ(adcConvCheck(&cal, 1024, 50), -1);
+  cal.offset = -1024;
+  CHECK_EQ(adcConvCheck(&cal, 1024, 50), 0);
+}
+
+static void benchmark(void)
+{
+  static uint32_t samples[4096];
+  adcCal_t cal;
+  uint32_t i, round, state = 1;
+  uint64_t t0, fixedNs, doubleNs;
+  int64_t fixedSum = 0;
+  double doubleSum = 0;
+
+  for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    samples[i] = state & 0xFFFF;
+  }
+  CHECK_EQ(adcConvCalibrate(&cal, 160, 16384 + 160, 825), 0);
+
+  /* The sums keep the compiler from dropping the conversions */
+  t0 = checkNowNs();
+  for (round = 0; round < 1000; round++)
+  {
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+      fixedSum += adcConvToMilliVolt(&cal, samples[i], 16);
+    }
+  }
+  fixedNs = checkNowNs() - t0;
+
+  t0 = checkNowNs();
+  for (round = 0; round < 1000; round++)
+  {
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+      doubleSum += reference(160, 16384 + 160, 825, samples[i], 16);
+    }
+  }
+  doubleNs = checkNowNs() - t0;
+
+  CHECK(fabs((double)fixedSum - doubleSum) <= 1.0 * 1000 * (sizeof(samples) / sizeof(samples[0])));
+  printf("adcConvToMilliVolt: %.2f ns per sample, double reference %.2f ns\n",
+         (double)fixedNs / (1000 * (sizeof(samples) / sizeof(samples[0]))),
+         (double)doubleNs / (1000 * (sizeof(samples) / sizeof(samples[0]))));
+}
+
+int main(void)
+{
+  testDefault();
+  testCalibrate();
+  testClamp();
+  testCheck();
+  benchmark();
+  return checkResult("test_adc_conv");
+}
@@ -0,0 +1,371 @@
+/*
+ * test_dsp_fft.c
+ *
+ *  q15 real FFT, Hann window and log2 of dsp_fft.h against a double
+ *  reference, the band levels and peaks of spectrum.c for known signals,
+ *  and a benchmark of the 128 point transform and of a whole frame.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dsp_fft.h"
+#include "spectrum.h"
+#include "check.h"
+
+/* Every halving stage truncates, about 1 LSB each at full scale for 128 points */
+#define DSP_FFT_ERROR_MAX       7
+
+static uint32_t rngState = 1;
+
+static uint32_t rng(void)
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+/* Uniform in -range..range */
+static int32_t rngRange(int32_t range)
+{
+  return (int32_t)(rng() % (uint32_t)((2 * range) + 1)) - range;
+}
+
+/* Bin k of the DFT of x[0..n-1], not normalized */
+static void refDft(const double *x, uint32_t n, uint32_t k, double *re, double *im)
+{
+  uint32_t i;
+
+  *re = 0;
+  *im = 0;
+  for (i = 0; i < n; i++)
+  {
+    *re += x[i] * cos(2.0 * M_PI * k * i / n);
+    *im -= x[i] * sin(2.0 * M_PI * k * i / n);
+  }
+}
+
+static void testRfft(void)
+{
+  int16_t buf[DSP_FFT_MAX_LEN + 2];
+  double x[DSP_FFT_MAX_LEN];
+  double re, im, error, maxError = 0;
+  uint32_t n, k, i, trial;
+  int32_t amp;
+
+  for (n = DSP_FFT_MIN_LEN; n <= DSP_FFT_MAX_LEN; n *= 2)
+  {
+    CHECK(dspFftLenValid(n));
+    CHECK(!dspFftLenValid(n + (n / 2)));
+
+    for (trial = 0; trial < 200; trial++)
+    {
+      /* Full scale noise, tones at and between bins, and quiet noise */
+      for (i = 0; i < n; i++)
+      {
+        if (trial % 4 == 0)
+        {
+          x[i] = rngRange(DSP_FFT_INPUT_MAX);
+        }
+        else if (trial % 4 == 1)
+        {
+          amp = (trial % 3 == 0) ? DSP_FFT_INPUT_MAX : 1000;
+          x[i] = floor(amp * sin(2.0 * M_PI * (trial % (n / 2)) * i / n) + 0.5);
+        }
+        else if (trial % 4 == 2)
+        {
+          x[i] = floor(DSP_FFT_INPUT_MAX * cos(2.0 * M_PI * (trial % 37) * 0.31 * i / n) + 0.5);
+        }
+        else
+        {
+          x[i] = rngRange(8);
+        }
+        buf[i] = (int16_t)x[i];
+      }
+      buf[n] = 0x5555;
+      buf[n + 1] = 0x5555;
+
+      dspRfftQ15(buf, n);
+
+      for (k = 0; k <= n / 2; k++)
+      {
+        refDft(x, n, k, &re, &im);
+        error = fmax(fabs(buf[2 * k] - (re / n)), fabs(buf[(2 * k) + 1] - (im / n)));
+        if (error > maxError)
+        {
+          maxError = error;
+        }
+        CHECK(error <= DSP_FFT_ERROR_MAX);
+      }
+      CHECK_EQ(buf[1], 0);
+      CHECK_EQ(buf[n + 1], 0);
+    }
+  }
+  printf("dspRfftQ15: max error %.2f LSB of X[k] / n\n", maxError);
+
+  /* Full scale DC and Nyquist do not overflow, the truncation bias adds up in them */
+  for (i = 0; i < DSP_FFT_MAX_LEN; i++)
+  {
+    buf[i] = DSP_FFT_INPUT_MAX;
+  }
+  dspRfftQ15(buf, DSP_FFT_MAX_LEN);
+  CHECK(abs(buf[0] - DSP_FFT_INPUT_MAX) <= DSP_FFT_ERROR_MAX);
+  CHECK(abs(buf[DSP_FFT_MAX_LEN]) <= DSP_FFT_ERROR_MAX);
+  for (i = 0; i < DSP_FFT_MAX_LEN; i++)
+  {
+    buf[i] = (i & 1) ? -DSP_FFT_INPUT_MAX : DSP_FFT_INPUT_MAX;
+  }
+  dspRfftQ15(buf, DSP_FFT_MAX_LEN);
+  CHECK(abs(buf[0]) <= DSP_FFT_ERROR_MAX);
+  CHECK(abs(buf[DSP_FFT_MAX_LEN] - DSP_FFT_INPUT_MAX) <= DSP_FFT_ERROR_MAX);
+}
+
+static void testHann(void)
+{
+  uint32_t n, i;
+  double ref, error, maxError = 0;
+
+  for (n = DSP_FFT_MIN_LEN; n <= DSP_FFT_MAX_LEN; n *= 2)
+  {
+    for (i = 0; i < n; i++)
+    {
+      ref = 32768.0 * pow(sin(M_PI * i / n), 2);
+      error = fabs(dspFftHann(i, n) - ref);
+      if (error > maxError)
+      {
+        maxError = error;
+      }
+      /* q15 table rounding, the 32767 peak and the truncated square */
+      CHECK(error < 4.0);
+      CHECK_EQ(dspFftHann(i, n), dspFftHann(n - i, n));
+    }
+  }
+  printf("dspFftHann: max error %.2f LSB\n", maxError);
+}
+
+static void testLog2(void)
+{
+  uint64_t x;
+  uint32_t i, shift;
+  double error, maxError = 0;
+
+  CHECK_EQ(dspLog2Q8(0), 0);
+  CHECK_EQ(dspLog2Q8(1), 0);
+  for (shift = 0; shift < 64; shift++)
+  {
+    CHECK_EQ(dspLog2Q8(1ULL << shift), 256 * shift);
+  }
+
+  /* The fraction is truncated bit by bit */
+  for (i = 0; i < 100000; i++)
+  {
+    shift = rng() % 64;
+    x = (((uint64_t)rng() << 32) | rng()) >> shift;
+    if (x == 0)
+    {
+      continue;
+    }
+    error = (256.0 * log2((double)x)) - dspLog2Q8(x);
+    if (fabs(error) > maxError)
+    {
+      maxError = fabs(error);
+    }
+    CHECK((error > -0.01) && (error < 2.0));
+  }
+  printf("dspLog2Q8: max error %.2f / 256\n", maxError);
+}
+
+/* Levels of the last spectrum frame */
+static uint32_t frameLevels(uint16_t *level, uint16_t *pos)
+{
+  uint8_t buf[SPECTRUM_FRAME_MAX];
+  uint32_t len = spectrumFrame(buf, sizeof(buf));
+  uint32_t items = buf[1];
+  uint32_t itemLen = ((buf[0] >> 4) == SPECTRUM_MODE_PEAKS) ? 4 : 2;
+  uint32_t i;
+  uint8_t *p = &buf[SPECTRUM_HEADER_LEN];
+
+  CHECK_EQ(len, SPECTRUM_HEADER_LEN + (items * itemLen));
+  for (i = 0; i < items; i++)
+  {
+    if (itemLen == 4)
+    {
+      pos[i] = (uint16_t)(p[0] | (p[1] << 8));
+      p += 2;
+    }
+    level[i] = (uint16_t)(p[0] | (p[1] << 8));
+    p += 2;
+  }
+  return items;
+}
+
+/* Feed a frame of samples, the band levels in double from the same window */
+static void feedFrame(const int32_t *s, const uint8_t *edges, uint32_t bands, double *ref)
+{
+  double x[SPECTRUM_FFT_LEN];
+  double re, im, power;
+  int64_t sum = 0;
+  int32_t mean;
+  uint32_t i, k;
+  bool done = false;
+
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++)
+  {
+    sum += s[i];
+  }
+  mean = (int32_t)(sum / SPECTRUM_FFT_LEN);
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++)
+  {
+    x[i] = (double)(s[i] - mean) * dspFftHann(i, SPECTRUM_FFT_LEN) / 32768.0;
+    done = spectrumAdd((uint32_t)s[i]);
+  }
+  CHECK(done);
+
+  for (i = 0; i < bands; i++)
+  {
+    power = 0;
+    for (k = edges[i]; k < edges[i + 1]; k++)
+    {
+      refDft(x, SPECTRUM_FFT_LEN, k, &re, &im);
+      power += (re * re) + (im * im);
+    }
+    ref[i] = power;
+  }
+}
+
+static void testBands(void)
+{
+  static const uint8_t edges[] = { 1, 2, 4, 8, 16, 24, 40, 65 };
+  static const int32_t offset[] = { 32768, 0x02000000, 0x0FFFFF00 };
+  static const int32_t amplitude[] = { 30000, 12, 2000, 3 };
+  const uint32_t bands = sizeof(edges) - 1;
+  int32_t s[SPECTRUM_FFT_LEN];
+  uint16_t level[SPECTRUM_ITEMS_MAX], pos[SPECTRUM_ITEMS_MAX];
+  double ref[SPECTRUM_ITEMS_MAX], total, error, maxError = 0;
+  uint32_t o, a, i, trial, items;
+
+  spectrumInit();
+  spectrumSetRate(100000);
+
+  for (o = 0; o < sizeof(offset) / sizeof(offset[0]); o++)
+  {
+    for (a = 0; a < sizeof(amplitude) / sizeof(amplitude[0]); a++)
+    {
+      for (trial = 0; trial < 20; trial++)
+      {
+        CHECK(spectrumConfigure(SPECTRUM_SRC_ADC, SPECTRUM_MODE_BANDS, bands, edges));
+        for (i = 0; i < SPECTRUM_FFT_LEN; i++)
+        {
+          s[i] = offset[o] + (int32_t)floor((amplitude[a] * sin(2.0 * M_PI * (1.7 + trial * 2.3)
+                                                                  * i / SPECTRUM_FFT_LEN)) + 0.5)
+                 + rngRange(1 + (amplitude[a] / 8));
+          if ((offset[o] == 32768) && (s[i] > 0xFFFF))
+          {
+            s[i] = 0xFFFF;
+          }
+        }
+        feedFrame(s, edges, bands, ref);
+        items = frameLevels(level, pos);
+        CHECK_EQ(items, bands);
+
+        /* Bands far below the strongest one are within the rounding noise of the FFT */
+        for (i = 0, total = 0; i < bands; i++)
+        {
+          total = fmax(total, ref[i]);
+        }
+        for (i = 0; i < bands; i++)
+        {
+          if (ref[i] < total * 1e-3)
+          {
+            continue;
+          }
+          error = fabs((level[i] / 256.0) - log2(ref[i]));
+          if (error > maxError)
+          {
+            maxError = error;
+          }
+          CHECK(error < 0.2);
+        }
+      }
+    }
+  }
+  printf("spectrum bands: max error %.3f in log2 of power\n", maxError);
+
+  /* A constant gives no power at all */
+  CHECK(spectrumConfigure(SPECTRUM_SRC_LDC0, SPECTRUM_MODE_BANDS, bands, edges));
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++)
+  {
+    s[i] = 0x01234567;
+  }
+  feedFrame(s, edges, bands, ref);
+  CHECK_EQ(frameLevels(level, pos), bands);
+  for (i = 0; i < bands; i++)
+  {
+    CHECK_EQ(level[i], 0);
+  }
+
+  /* Two tones between bins, the stronger one first, positions in 1/16 bins */
+  CHECK(spectrumConfigure(SPECTRUM_SRC_ADC, SPECTRUM_MODE_PEAKS, 2, NULL));
+  for (i = 0; i < SPECTRUM_FFT_LEN; i++)
+  {
+    s[i] = 32768 + (int32_t)floor((4000 * sin(2.0 * M_PI * 10.25 * i / SPECTRUM_FFT_LEN))
+                                  + (12000 * sin(2.0 * M_PI * 30.5 * i / SPECTRUM_FFT_LEN)) + 0.5);
+  }
+  feedFrame(s, edges, 0, ref);
+  CHECK_EQ(frameLevels(level, pos), 2);
+  CHECK(abs(pos[0] - (int32_t)(30.5 * 16)) <= 2);
+  CHECK(abs(pos[1] - (int32_t)(10.25 * 16)) <= 2);
+  CHECK(level[0] > level[1]);
+  printf("spectrum peaks: %.3f and %.3f bins for 30.5 and 10.25\n", pos[0] / 16.0, pos[1] / 16.0);
+}
+
+static void benchmark(void)
+{
+  static int16_t frames[64][DSP_FFT_MAX_LEN + 2];
+  int16_t buf[DSP_FFT_MAX_LEN + 2];
+  uint32_t i, f, round, frameCount = 0;
+  uint64_t t0, fftNs = 0, frameNs = 0;
+
+  for (f = 0; f < 64; f++)
+  {
+    for (i = 0; i < DSP_FFT_MAX_LEN; i++)
+    {
+      frames[f][i] = (int16_t)rngRange(DSP_FFT_INPUT_MAX);
+    }
+  }
+  for (round = 0; round < 200; round++)
+  {
+    for (f = 0; f < 64; f++)
+    {
+      memcpy(buf, frames[f], sizeof(buf));
+      t0 = checkNowNs();
+      dspRfftQ15(buf, DSP_FFT_MAX_LEN);
+      fftNs += checkNowNs() - t0;
+      CHECK(buf[1] == 0);
+    }
+  }
+
+  /* Mean removal, scaling, window, transform and bands, per frame of SPECTRUM_HOP samples */
+  spectrumInit();
+  spectrumSetRate(100000);
+  t0 = checkNowNs();
+  for (i = 0; i < 1000 * SPECTRUM_HOP; i++)
+  {
+    frameCount += spectrumAdd(32768 + (uint32_t)rngRange(20000));
+  }
+  frameNs = checkNowNs() - t0;
+
+  printf("dspRfftQ15: %.2f us per %u point transform, spectrum: %.2f us per frame\n",
+         fftNs / (200.0 * 64 * 1000), DSP_FFT_MAX_LEN, frameNs / (frameCount * 1000.0));
+}
+
+int main(void)
+{
+  testRfft();
+  testHann();
+  testLog2();
+  testBands();
+  benchmark();
+  return checkResult("test_dsp_fft");
+}
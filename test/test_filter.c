@@ -0,0 +1,271 @@
+/*
+ * test_filter.c
+ *
+ *  The kernels of dsp_filter.h and the coefficient sets of filter.c: unity
+ *  gain at DC, pass band and stop band of the low passes, spike rejection
+ *  and delay of the median, and the ADC and LDC1612 scaling around them.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "dsp_filter.h"
+#include "filter.h"
+#include "check.h"
+
+#define PI              3.14159265358979
+#define SET_MEDIAN3     1
+#define SET_IIR2        2
+#define SET_IIR4        3
+#define SET_FIR15       4
+
+/* Peak output of the IIR or FIR of a set on a q31 sine of amplitude 2^30 at f times the sample
+ * rate, once settled, relative to the amplitude */
+static double sineGain(uint8_t index, double f)
+{
+  const filterSet_t *set = filterSetGet(index);
+  dspBiquadQ31_t bq;
+  dspFirQ31_t fir;
+  uint32_t i;
+  int32_t y, peak = 0;
+
+  dspBiquadQ31Init(&bq, set->numStages, set->coeffs, 1);
+  dspFirQ31Init(&fir, set->numTaps, set->coeffs);
+  for (i = 0; i < 2000; i++)
+  {
+    y = (int32_t)lround(1073741824.0 * sin(2 * PI * f * i));
+    y = dspFirQ31(&fir, dspBiquadQ31(&bq, y));
+    if ((i >= 1000) && (labs(y) > peak))
+    {
+      peak = labs(y);
+    }
+  }
+  return peak / 1073741824.0;
+}
+
+/* DC gain of the coefficient tables themselves, in double */
+static void testCoefficients(void)
+{
+  const filterSet_t *set;
+  const int32_t *c;
+  double b, a, gain, sum;
+  uint32_t s, k;
+
+  set = filterSetGet(SET_IIR2);
+  CHECK(set != NULL);
+  for (s = SET_IIR2; s <= SET_IIR4; s++)
+  {
+    set = filterSetGet((uint8_t)s);
+    gain = 1;
+    for (k = 0, c = set->coeffs; k < set->numStages; k++, c += 5)
+    {
+      /* Stored halved, feedback negated */
+      b = 2.0 * ((double)c[0] + c[1] + c[2]) / 2147483648.0;
+      a = 1.0 - (2.0 * ((double)c[3] + c[4]) / 2147483648.0);
+      gain *= b / a;
+    }
+    CHECK(fabs(gain - 1) < 1e-6);
+  }
+
+  set = filterSetGet(SET_FIR15);
+  sum = 0;
+  for (k = 0; k < set->numTaps; k++)
+  {
+    sum += set->coeffs[k];
+    CHECK_EQ(set->coeffs[k], set->coeffs[set->numTaps - 1 - k]);
+  }
+  CHECK(fabs((sum / 2147483648.0) - 1) < 1e-6);
+
+  CHECK(filterSetGet(FILTER_SETS) == NULL);
+  CHECK(!filterSelect(FILTER_SETS));
+}
+
+/* Constant input comes out unchanged once settled, for the ADC and both LDC1612 channels */
+static void testDcGain(void)
+{
+  static const uint16_t adc[] = { 0, 1000, 32768, 40000, 65535 };
+  static const uint32_t ldc[] = { 0, 0x00123456, 0x08000000, 0x0ABCDEF0, 0x0FFFFFFF };
+  uint8_t set;
+  uint32_t i, k, out;
+  int32_t error, maxError = 0;
+
+  for (set = 0; set < FILTER_SETS; set++)
+  {
+    for (k = 0; k < sizeof(adc) / sizeof(adc[0]); k++)
+    {
+      CHECK(filterSelect(set));
+      CHECK_EQ(filterGetSelected(), set);
+      for (i = 0; i < 500; i++)
+      {
+        out = filterAdc(adc[k]);
+      }
+      error = abs((int32_t)out - adc[k]);
+      maxError = (error > maxError) ? error : maxError;
+      CHECK(error <= 1);
+    }
+    for (k = 0; k < sizeof(ldc) / sizeof(ldc[0]); k++)
+    {
+      CHECK(filterSelect(set));
+      for (i = 0; i < 500; i++)
+      {
+        out = filterLdc(i & 1, ldc[k]);
+      }
+      CHECK(out <= 0x0FFFFFFF);
+      error = abs((int32_t)out - (int32_t)ldc[k]);
+      maxError = (error > maxError) ? error : maxError;
+      CHECK(error <= 16);
+    }
+  }
+  printf("DC: max error %ld LSB\n", (long)maxError);
+}
+
+/* Low passes keep slow signals and attenuate those above their cutoff */
+static void testStopband(void)
+{
+  static const struct
+  {
+    uint8_t set;
+    double cutoff;                      /* Relative to the sample rate */
+    double stop;                        /* Largest gain from 3 * cutoff up */
+  } sets[] =
+  {
+    { SET_IIR2, 0.1, 0.07 }, { SET_IIR4, 0.05, 0.015 }, { SET_FIR15, 0.125, 0.005 }
+  };
+  uint32_t s;
+  double f, gain, cutoff, maxStop;
+
+  for (s = 0; s < sizeof(sets) / sizeof(sets[0]); s++)
+  {
+    gain = sineGain(sets[s].set, sets[s].cutoff / 10);
+    CHECK(fabs(gain - 1) < 0.02);
+
+    /* -3 dB at the cutoff, the FIR is windowed to -6 dB */
+    cutoff = sineGain(sets[s].set, sets[s].cutoff);
+    CHECK((cutoff > 0.45) && (cutoff < 0.75));
+
+    maxStop = 0;
+    for (f = 3 * sets[s].cutoff; f < 0.5; f += 0.01)
+    {
+      gain = sineGain(sets[s].set, f);
+      maxStop = (gain > maxStop) ? gain : maxStop;
+    }
+    CHECK(maxStop < sets[s].stop);
+    printf("%s: cutoff gain %.3f, stop band gain %.4f\n", filterSetGet(sets[s].set)->name, cutoff,
+           maxStop);
+  }
+}
+
+/* The FIR delays by half its length, linear phase */
+static void testFirDelay(void)
+{
+  dspFirQ31_t fir;
+  const filterSet_t *set = filterSetGet(SET_FIR15);
+  int32_t y, peak = 0;
+  uint32_t i, peakAt = 0;
+
+  dspFirQ31Init(&fir, set->numTaps, set->coeffs);
+  for (i = 0; i < 20; i++)
+  {
+    y = dspFirQ31(&fir, (i == 0) ? INT32_MAX : 0);
+    if (i < set->numTaps)
+    {
+      CHECK(abs(y - set->coeffs[i]) <= 1);
+    }
+    else
+    {
+      CHECK_EQ(y, 0);
+    }
+    if (y > peak)
+    {
+      peak = y;
+      peakAt = i;
+    }
+  }
+  CHECK_EQ(peakAt, 7);
+
+  /* No taps pass through */
+  dspFirQ31Init(&fir, 0, NULL);
+  CHECK_EQ(dspFirQ31(&fir, 12345), 12345);
+}
+
+/* Spikes shorter than half the window vanish, steps are delayed by half the window */
+static void testMedian(void)
+{
+  dspMedian_t med;
+  uint32_t len, i, spike;
+  int32_t y;
+
+  for (len = 3; len <= DSP_MEDIAN_MAX; len += 2)
+  {
+    /* Runs of len / 2 spikes, up and down */
+    dspMedianInit(&med, len);
+    for (i = 0; i < 100; i++)
+    {
+      spike = (i % 10) < (len / 2);
+      y = dspMedian(&med, 1000 + (spike ? (((i / 10) & 1) ? -900000 : 900000) : 0));
+      if (i >= len)
+      {
+        CHECK_EQ(y, 1000);
+      }
+    }
+
+    /* Step */
+    dspMedianInit(&med, len);
+    for (i = 0; i < 20; i++)
+    {
+      y = dspMedian(&med, (i < 10) ? -5 : 5);
+      CHECK_EQ(y, (i < (10 + (len / 2))) ? -5 : 5);
+    }
+  }
+
+  /* Median of what came so far until full */
+  dspMedianInit(&med, 5);
+  CHECK_EQ(dspMedian(&med, 7), 7);
+  CHECK_EQ(dspMedian(&med, 1), 7);
+  CHECK_EQ(dspMedian(&med, 3), 3);
+
+  /* Windows made odd and limited, 0 and 1 pass through */
+  dspMedianInit(&med, 4);
+  CHECK_EQ(med.len, 5);
+  dspMedianInit(&med, 100);
+  CHECK_EQ(med.len, DSP_MEDIAN_MAX);
+  dspMedianInit(&med, 0);
+  CHECK_EQ(dspMedian(&med, -3), -3);
+  CHECK_EQ(dspMedian(&med, 8), 8);
+
+  /* Through filter.c, PA0 spikes to the rails */
+  CHECK(filterSelect(SET_MEDIAN3));
+  for (i = 0; i < 50; i++)
+  {
+    y = filterAdc(((i % 7) == 3) ? 65535 : (((i % 7) == 6) ? 0 : 20000));
+    if (i >= 2)
+    {
+      CHECK_EQ(y, 20000);
+    }
+  }
+}
+
+/* The off set passes everything through, also beyond the LDC1612 channels */
+static void testOff(void)
+{
+  uint32_t i;
+
+  CHECK(filterSelect(FILTER_SET_OFF));
+  for (i = 0; i < 65536; i += 257)
+  {
+    CHECK_EQ(filterAdc((uint16_t)i), i);
+    CHECK_EQ(filterLdc(i & 1, i << 12), i << 12);
+  }
+  CHECK(filterSelect(SET_IIR2));
+  CHECK_EQ(filterLdc(2, 0x0123456), 0x0123456);
+}
+
+int main(void)
+{
+  testCoefficients();
+  testDcGain();
+  testStopband();
+  testFirDelay();
+  testMedian();
+  testOff();
+  return checkResult("test_filter");
+}
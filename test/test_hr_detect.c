@@ -0,0 +1,202 @@
+/*
+ * test_hr_detect.c
+ *
+ *  hr_detect.h on synthetic pulse signals at the 25 and 100 Hz PA0 rates,
+ *  45 to 150 BPM: rate and RR interval error once locked, the
+ *  autocorrelation rate of pulses too small for the peak detector, and
+ *  loss of contact when the pulse stops.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hr_detect.h"
+#include "check.h"
+
+#define PI              3.14159265358979
+/* Filter settling and relocking after a start on the dicrotic wave, in s */
+#define SETTLE_S        10
+
+static uint32_t rngState = 1;
+
+static uint32_t rng(void)
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+/* Pulse wave: systolic peak and a smaller dicrotic wave 0.4 periods later, on a baseline drifting
+ * as far as the pulse is high, with noise of +-noise LSBs. t and period in s. */
+static uint16_t pulse(double t, double period, double amp, uint32_t noise)
+{
+  double s = fmod(t, period);
+  double v = 30000.0 + (amp * sin(2 * PI * 0.05 * t));
+
+  v += amp * exp(-pow((s - 0.1) / 0.07, 2));
+  v += 0.3 * amp * exp(-pow((s - 0.1 - (0.4 * period)) / 0.08, 2));
+  if (noise != 0)
+  {
+    v += (double)(rng() % (2 * noise + 1)) - noise;
+  }
+  return (uint16_t)v;
+}
+
+/* Once settled, reports every beat of clean pulses with its RR interval */
+static void testBeats(void)
+{
+  static const uint32_t rates[] = { 25, 100 };
+  hrDetect_t det;
+  uint32_t r, bpm, i, n, settled, events, beats, count;
+  uint16_t rr[HR_DETECT_RR_MAX];
+  double period, bpmError, rrError, maxBpmError = 0, maxRrError = 0;
+
+  for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+  {
+    for (bpm = 45; bpm <= 150; bpm += 15)
+    {
+      period = 60.0 / bpm;
+      hrDetectInit(&det, rates[r]);
+      beats = 0;
+      settled = SETTLE_S * rates[r];
+      n = settled + (20 * rates[r]);
+      for (i = 0; i < n; i++)
+      {
+        events = hrDetectPush(&det, pulse((double)i / rates[r], period, 3000.0, 20));
+        if (i < settled)
+        {
+          hrDetectTakeRr(&det, rr, HR_DETECT_RR_MAX);
+          continue;
+        }
+        CHECK((events & HR_DETECT_EVT_LOST) == 0);
+        if ((events & HR_DETECT_EVT_BEAT) == 0)
+        {
+          continue;
+        }
+        beats++;
+        bpmError = fabs(det.bpm - (double)bpm);
+        maxBpmError = (bpmError > maxBpmError) ? bpmError : maxBpmError;
+        CHECK(bpmError <= 2);
+        CHECK(det.locked);
+        CHECK(det.contact);
+
+        count = hrDetectTakeRr(&det, rr, HR_DETECT_RR_MAX);
+        CHECK_EQ(count, 1);
+        rrError = fabs(rr[0] - (1024.0 * period));
+        maxRrError = (rrError > maxRrError) ? rrError : maxRrError;
+        CHECK(rrError <= (256.0 / rates[r]));
+      }
+      /* None missed */
+      CHECK(beats + 1 >= (uint32_t)(20 / period));
+    }
+  }
+  printf("beats: max error %.1f BPM, RR %.1f / 1024 s\n", maxBpmError, maxRrError);
+}
+
+/* Pulses below HR_DETECT_MIN_AMP never lock, the rate comes from the autocorrelation */
+static void testAutocorrelation(void)
+{
+  static const uint32_t rates[] = { 25, 100 };
+  hrDetect_t det;
+  uint32_t r, bpm, i, events, estimates;
+  double error, maxError = 0;
+
+  for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+  {
+    for (bpm = 45; bpm <= 150; bpm += 15)
+    {
+      hrDetectInit(&det, rates[r]);
+      estimates = 0;
+      for (i = 0; i < 20 * rates[r]; i++)
+      {
+        events = hrDetectPush(&det, pulse((double)i / rates[r], 60.0 / bpm, 100.0, 4));
+        CHECK((events & HR_DETECT_EVT_BEAT) == 0);
+        if ((events & HR_DETECT_EVT_RATE) == 0)
+        {
+          continue;
+        }
+        estimates++;
+        error = fabs(det.bpm - (double)bpm) / bpm;
+        maxError = (error > maxError) ? error : maxError;
+        CHECK(error <= 0.05);
+        CHECK(det.contact);
+        CHECK(!det.locked);
+      }
+      /* Once per second after the 10 s history is full */
+      CHECK(estimates >= 9);
+    }
+  }
+  printf("autocorrelation: max error %.1f %%\n", 100 * maxError);
+}
+
+/* A flat signal after the pulse loses the lock and the contact, once */
+static void testLost(void)
+{
+  static const uint32_t rates[] = { 25, 100 };
+  hrDetect_t det;
+  uint32_t r, i, events, lostAt, lost;
+  uint16_t rr[HR_DETECT_RR_MAX];
+
+  for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+  {
+    hrDetectInit(&det, rates[r]);
+    for (i = 0; i < 20 * rates[r]; i++)
+    {
+      hrDetectPush(&det, pulse((double)i / rates[r], 0.8, 3000.0, 20));
+    }
+    CHECK(det.locked);
+    CHECK_EQ(det.bpm, 75);
+    hrDetectTakeRr(&det, rr, HR_DETECT_RR_MAX);
+
+    lostAt = 0;
+    lost = 0;
+    for (i = 0; i < 20 * rates[r]; i++)
+    {
+      events = hrDetectPush(&det, 30000 + (rng() % 41) - 20);
+      CHECK((events & (HR_DETECT_EVT_BEAT | HR_DETECT_EVT_RATE)) == 0);
+      if (events & HR_DETECT_EVT_LOST)
+      {
+        lostAt = (lost == 0) ? i : lostAt;
+        lost++;
+      }
+    }
+    CHECK_EQ(lost, 1);
+    CHECK(lostAt <= ((HR_DETECT_LOST_S + 1) * rates[r]));
+    CHECK(!det.locked);
+    CHECK(!det.contact);
+    CHECK_EQ(det.bpm, 0);
+    CHECK_EQ(hrDetectTakeRr(&det, rr, HR_DETECT_RR_MAX), 0);
+  }
+}
+
+/* RR intervals queue up until taken, the oldest are dropped for lack of room */
+static void testTakeRr(void)
+{
+  hrDetect_t det;
+  uint16_t rr[HR_DETECT_RR_MAX];
+  uint32_t i, count = 0, events;
+
+  hrDetectInit(&det, 100);
+  for (i = 0; i < 3000; i++)
+  {
+    events = hrDetectPush(&det, pulse(i / 100.0, 0.5, 3000.0, 0));
+    count += (events & HR_DETECT_EVT_BEAT) ? 1 : 0;
+  }
+  CHECK(count > HR_DETECT_RR_MAX);
+  CHECK_EQ(det.rrCount, HR_DETECT_RR_MAX);
+  memset(rr, 0, sizeof(rr));
+  CHECK_EQ(hrDetectTakeRr(&det, rr, 2), 2);
+  CHECK(abs((int)rr[0] - 512) <= 10);
+  CHECK(abs((int)rr[1] - 512) <= 10);
+  CHECK_EQ(hrDetectTakeRr(&det, rr, HR_DETECT_RR_MAX), 0);
+}
+
+int main(void)
+{
+  testBeats();
+  testAutocorrelation();
+  testLost();
+  testTakeRr();
+  return checkResult("test_hr_detect");
+}
@@ -0,0 +1,515 @@
+/*
+ * test_ldc.c
+ *
+ *  The LDC1612 read sequence of ldc1612_async.c against a register model
+ *  of the sensor: ldcSmStart(), ldcSmFeed() and ldcSmTake() directly, then
+ *  the INTB driven acquisition over a simulated I2C queue, including its
+ *  recovery from NACKs and a full queue.
+ */
+
+#include <string.h>
+#include "ldc1612_async.h"
+#include "i2c_async.h"
+#include "app_signal.h"
+#include "si7013.h"
+#include "stub.h"
+#include "check.h"
+
+/* LDC1612 registers as far as the reads see them */
+static struct
+{
+  uint32_t data[LDC1612_CHANNELS];      /* 28 bit results */
+  uint8_t err[LDC1612_CHANNELS];        /* ERR_UR, ERR_OR, ERR_WD, ERR_AE of each result */
+  uint16_t lsb[LDC1612_CHANNELS];       /* LSB latched by the MSB read */
+  uint16_t status;
+  uint16_t errorConfig;
+  uint32_t reads;
+  uint8_t readLog[16];                  /* First registers read since modelReset() */
+  uint32_t convertAt;                   /* Complete a sequence after this many reads, 0 for never */
+  uint32_t convertData;
+} model;
+
+static void modelReset(void)
+{
+  memset(&model, 0, sizeof(model));
+  stubGpioIn |= (1UL << LDC1612_INTB_PIN);
+}
+
+/* A conversion of channel ch completed; INTB goes low */
+static void modelConvert(uint32_t ch, uint32_t data, uint8_t err)
+{
+  model.data[ch] = data & 0x0FFFFFFF;
+  model.err[ch] = err;
+  model.status |= LDC1612_STATUS_DRDY | (LDC1612_STATUS_UNREADCONV0 >> ch);
+  stubGpioIn &= ~(1UL << LDC1612_INTB_PIN);
+}
+
+static uint16_t modelRead(uint8_t reg)
+{
+  uint16_t value = 0;
+  uint32_t ch;
+
+  if (model.reads < sizeof(model.readLog))
+  {
+    model.readLog[model.reads] = reg;
+  }
+  model.reads++;
+
+  if (reg == LDC1612_REG_STATUS)
+  {
+    /* Reading STATUS releases INTB */
+    value = model.status;
+    model.status &= ~LDC1612_STATUS_DRDY;
+    stubGpioIn |= (1UL << LDC1612_INTB_PIN);
+  }
+  else if (reg <= LDC1612_REG_DATA1_LSB)
+  {
+    ch = reg / 2;
+    if ((reg & 1) == 0)
+    {
+      value = (uint16_t)((model.err[ch] << LDC1612_DATA_ERR_SHIFT) | (model.data[ch] >> 16));
+      model.lsb[ch] = (uint16_t)model.data[ch];
+      model.status &= ~(LDC1612_STATUS_UNREADCONV0 >> ch);
+    }
+    else
+    {
+      value = model.lsb[ch];
+    }
+  }
+
+  if (model.reads == model.convertAt)
+  {
+    modelConvert(0, model.convertData, 0);
+    modelConvert(1, model.convertData, 0);
+  }
+  return value;
+}
+
+/* Run the reads of one data ready edge, as the I2C completions would */
+static uint32_t smEdge(ldcSm_t *sm, uint8_t channelMask, uint32_t timestamp)
+{
+  uint8_t reg = ldcSmStart(sm, channelMask, timestamp);
+  uint32_t reads = 0;
+
+  do
+  {
+    reads++;
+    CHECK(reads <= LDC_SM_MAX_READS);
+  } while (ldcSmFeed(sm, modelRead(reg), &reg) && (reads <= LDC_SM_MAX_READS));
+  return reads;
+}
+
+static void testSmSequence(void)
+{
+  static const uint8_t order[] =
+  {
+    LDC1612_REG_STATUS, LDC1612_REG_DATA0_MSB, LDC1612_REG_DATA0_LSB, LDC1612_REG_DATA1_MSB,
+    LDC1612_REG_DATA1_LSB
+  };
+  ldcSm_t sm;
+  ldcSample_t sample;
+  uint32_t i;
+
+  /* Autoscan of both channels: one edge, MSB before LSB of each */
+  memset(&sm, 0, sizeof(sm));
+  modelReset();
+  modelConvert(0, 0x0ABCDEF1, 0);
+  modelConvert(1, 0x01234567, 0);
+  CHECK_EQ(smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 1234), 5);
+  for (i = 0; i < sizeof(order); i++)
+  {
+    CHECK_EQ(model.readLog[i], order[i]);
+  }
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.timestamp, 1234);
+  CHECK_EQ(sample.channelMask, LDC1612_CH0 | LDC1612_CH1);
+  CHECK_EQ(sample.data[0], 0x0ABCDEF1);
+  CHECK_EQ(sample.data[1], 0x01234567);
+  CHECK_EQ(sample.errors, 0);
+  CHECK_EQ(sample.status & LDC1612_STATUS_DRDY, LDC1612_STATUS_DRDY);
+  CHECK_EQ(model.status, 0);
+
+  /* Taken once only */
+  CHECK(!ldcSmTake(&sm, &sample));
+
+  /* Single channel: STATUS and CH1 only */
+  modelReset();
+  modelConvert(1, 0x0FFFFFFF, 0);
+  CHECK_EQ(smEdge(&sm, LDC1612_CH1, 99), 3);
+  CHECK_EQ(model.readLog[1], LDC1612_REG_DATA1_MSB);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.data[1], 0x0FFFFFFF);
+  CHECK_EQ(sample.data[0], 0);
+}
+
+static void testSmSplit(void)
+{
+  ldcSm_t sm;
+  ldcSample_t sample;
+
+  /* CH0 on the first edge, CH1 on the second: one sample with the time of the second */
+  memset(&sm, 0, sizeof(sm));
+  modelReset();
+  modelConvert(0, 0x00111111, 0);
+  CHECK_EQ(smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 10), 3);
+  CHECK(!ldcSmTake(&sm, &sample));
+  modelConvert(1, 0x00222222, 0);
+  CHECK_EQ(smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 20), 3);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.timestamp, 20);
+  CHECK_EQ(sample.data[0], 0x00111111);
+  CHECK_EQ(sample.data[1], 0x00222222);
+
+  /* A channel mask change drops the half collected sequence */
+  modelConvert(0, 0x00333333, 0);
+  CHECK_EQ(smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 30), 3);
+  modelConvert(1, 0x00444444, 0);
+  CHECK_EQ(smEdge(&sm, LDC1612_CH1, 40), 3);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.channelMask, LDC1612_CH1);
+  CHECK_EQ(sample.data[0], 0);
+  CHECK_EQ(sample.data[1], 0x00444444);
+}
+
+static void testSmNoFlags(void)
+{
+  ldcSm_t sm;
+  ldcSample_t sample;
+
+  /* No unread flags, e.g. cleared by an earlier read: every wanted channel is read */
+  memset(&sm, 0, sizeof(sm));
+  modelReset();
+  model.data[0] = 0x00000555;
+  model.data[1] = 0x00000AAA;
+  CHECK_EQ(smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 7), 5);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.data[0], 0x00000555);
+  CHECK_EQ(sample.data[1], 0x00000AAA);
+
+  /* Unread flags of channels that are not wanted are ignored */
+  modelReset();
+  modelConvert(1, 0x00000777, 0);
+  model.data[0] = 0x00000888;
+  CHECK_EQ(smEdge(&sm, LDC1612_CH0, 8), 3);
+  CHECK_EQ(model.readLog[1], LDC1612_REG_DATA0_MSB);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.data[0], 0x00000888);
+}
+
+static void testSmErrors(void)
+{
+  ldcSm_t sm;
+  ldcSample_t sample;
+
+  /* Error bits of both channels are ORed and do not leak into the data */
+  memset(&sm, 0, sizeof(sm));
+  modelReset();
+  modelConvert(0, 0x0FFFFFFF, 0x8);     /* ERR_UR */
+  modelConvert(1, 0x00000001, 0x2);     /* ERR_WD */
+  smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 0);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.errors, 0xA);
+  CHECK_EQ(sample.data[0], 0x0FFFFFFF);
+  CHECK_EQ(sample.data[1], 0x00000001);
+
+  /* The next sequence starts without them */
+  modelConvert(0, 0x00000010, 0);
+  modelConvert(1, 0x00000020, 0);
+  smEdge(&sm, LDC1612_CH0 | LDC1612_CH1, 1);
+  CHECK(ldcSmTake(&sm, &sample));
+  CHECK_EQ(sample.errors, 0);
+}
+
+static void testConvTime(void)
+{
+  const ldcProfile_t *profile;
+  uint32_t i, ch, channels, us;
+  double cycles, ref;
+
+  /* Against the datasheet timing in double: per channel (RCOUNT * 16 + 4) fREF cycles
+   * conversion, SETTLECOUNT * 16 settling and 5 cycles plus 692 ns channel switch */
+  for (i = 0; i < LDC_PROFILES; i++)
+  {
+    profile = ldcProfileGet(i);
+    CHECK(profile != NULL);
+    CHECK_EQ(profile->clockDividers & LDC1612_CLOCK_DIVIDERS_FREF_MASK, 1);
+    for (ch = LDC1612_CH0; ch <= (LDC1612_CH0 | LDC1612_CH1); ch++)
+    {
+      channels = (ch == (LDC1612_CH0 | LDC1612_CH1)) ? 2 : 1;
+      cycles = (profile->rcount * 16.0) + 4 + (profile->settleCount * 16.0) + 5;
+      ref = channels * ((cycles * 1e6 / LDC1612_FCLK_HZ) + 0.692);
+      us = ldcProfileConvTimeUs(profile, (uint8_t)ch);
+
+      /* Rounded up, never shorter */
+      CHECK(us >= ref);
+      CHECK(us < ref + 1.0);
+    }
+  }
+  CHECK(ldcProfileGet(LDC_PROFILES) == NULL);
+
+  /* The default profile converts CH0 and CH1 in about 10 ms */
+  us = ldcProfileConvTimeUs(ldcProfileGet(LDC_PROFILE_DEFAULT), LDC1612_CH0 | LDC1612_CH1);
+  CHECK((us > 9900) && (us < 10100));
+}
+
+/* Simulated I2C queue: transfers wait until busRun() */
+static i2cAsyncXfer_t *busQueue[I2C_ASYNC_QUEUE_SIZE];
+static uint32_t busQueued;
+static uint32_t busTransfers;
+static uint32_t busNackFrom;            /* First transfer NACKed, 0 for the next one */
+static uint32_t busNacks;               /* Transfers still to be NACKed */
+static uint32_t busRejects;             /* Submits still to find the queue full */
+
+bool i2cAsyncSubmit(i2cAsyncXfer_t *xfer)
+{
+  if ((busQueued >= I2C_ASYNC_QUEUE_SIZE) || (busRejects > 0))
+  {
+    busRejects -= (busRejects > 0) ? 1 : 0;
+    return false;
+  }
+  busQueue[busQueued++] = xfer;
+  return true;
+}
+
+static void busReset(void)
+{
+  busQueued = 0;
+  busTransfers = 0;
+  busNackFrom = 0;
+  busNacks = 0;
+  busRejects = 0;
+}
+
+/* Complete the queued transfers in order, including those their callbacks submit */
+static void busRun(void)
+{
+  i2cAsyncXfer_t *xfer;
+  uint16_t value;
+
+  while (busQueued > 0)
+  {
+    xfer = busQueue[0];
+    busQueued--;
+    memmove(&busQueue[0], &busQueue[1], busQueued * sizeof(busQueue[0]));
+    busTransfers++;
+
+    /* The sensor did not answer: nothing is read */
+    if ((busNacks > 0) && (busTransfers >= busNackFrom))
+    {
+      busNacks--;
+      xfer->cb(i2cTransferNack, xfer->ctx);
+      continue;
+    }
+
+    CHECK_EQ(xfer->seq.addr, LDC1612_ADDR);
+    if (xfer->seq.flags == I2C_FLAG_WRITE_READ)
+    {
+      CHECK_EQ(xfer->seq.buf[0].len, 1);
+      CHECK_EQ(xfer->seq.buf[1].len, 2);
+      value = modelRead(xfer->seq.buf[0].data[0]);
+      xfer->seq.buf[1].data[0] = (uint8_t)(value >> 8);
+      xfer->seq.buf[1].data[1] = (uint8_t)value;
+    }
+    else
+    {
+      CHECK_EQ(xfer->seq.flags, I2C_FLAG_WRITE);
+      CHECK_EQ(xfer->seq.buf[0].len, 3);
+      if (xfer->seq.buf[0].data[0] == LDC1612_REG_ERROR_CONFIG)
+      {
+        model.errorConfig = (uint16_t)((xfer->seq.buf[0].data[1] << 8) | xfer->seq.buf[0].data[2]);
+      }
+    }
+    xfer->cb(i2cTransferDone, xfer->ctx);
+  }
+}
+
+/* Falling edge on INTB */
+static void intbEdge(void)
+{
+  if ((stubGpioIntEnabled & (1UL << LDC1612_INTB_PIN))
+      && (stubGpioIntCallback[LDC1612_INTB_PIN] != NULL))
+  {
+    stubGpioIntCallback[LDC1612_INTB_PIN](LDC1612_INTB_PIN);
+  }
+}
+
+static void testAsync(void)
+{
+  ldcSample_t sample;
+  uint32_t i;
+
+  stubReset();
+  modelReset();
+  busReset();
+  CHECK(ldcAsyncStart(LDC1612_CH0 | LDC1612_CH1));
+
+  /* Data ready is routed to INTB before the edge interrupt is enabled */
+  CHECK_EQ(stubGpioIntEnabled, 0);
+  busRun();
+  CHECK_EQ(model.errorConfig, LDC1612_ERROR_CONFIG_DRDY_2INT);
+  CHECK(stubGpioIntEnabled & (1UL << LDC1612_INTB_PIN));
+  CHECK(!ldcAsyncGetSample(&sample));
+
+  /* One sequence, one sample, one signal */
+  stubRtccCounter = 5000;
+  modelConvert(0, 0x00ABCDEF, 0);
+  modelConvert(1, 0x00FEDCBA, 0);
+  intbEdge();
+  busRun();
+  CHECK_EQ(busTransfers, 1 + 5);
+  CHECK(stubSignals & APP_SIGNAL_LDC_DATA);
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.timestamp, 5000);
+  CHECK_EQ(sample.data[0], 0x00ABCDEF);
+  CHECK_EQ(sample.data[1], 0x00FEDCBA);
+  CHECK(!ldcAsyncGetSample(&sample));
+
+  /* Edges while a read is queued start nothing; the next sequence, finished during the last
+   * read, is picked up from the INTB level without an edge */
+  modelConvert(0, 1, 0);
+  modelConvert(1, 2, 0);
+  model.convertAt = model.reads + 5;
+  model.convertData = 3;
+  intbEdge();
+  intbEdge();
+  CHECK_EQ(busQueued, 1);
+  busRun();
+  model.convertAt = 0;
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.data[0], 1);
+  CHECK_EQ(sample.data[1], 2);
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.data[0], 3);
+  CHECK_EQ(sample.data[1], 3);
+  CHECK(!ldcAsyncGetSample(&sample));
+
+  /* A full queue drops the newest samples and counts them */
+  CHECK_EQ(ldcAsyncGetDrops(), 0);
+  for (i = 0; i < LDC_SAMPLE_QUEUE_SIZE + 2; i++)
+  {
+    modelConvert(0, i, 0);
+    modelConvert(1, i, 0);
+    intbEdge();
+    busRun();
+  }
+  CHECK_EQ(ldcAsyncGetDrops(), 2);
+  for (i = 0; i < LDC_SAMPLE_QUEUE_SIZE; i++)
+  {
+    CHECK(ldcAsyncGetSample(&sample));
+    CHECK_EQ(sample.data[0], i);
+  }
+  CHECK(!ldcAsyncGetSample(&sample));
+  CHECK_EQ(ldcAsyncGetBusErrors(), 0);
+
+  /* Stopped: no interrupt and a read still queued is not turned into a sample */
+  modelConvert(0, 9, 0);
+  modelConvert(1, 9, 0);
+  intbEdge();
+  ldcAsyncStop();
+  CHECK_EQ(stubGpioIntEnabled & (1UL << LDC1612_INTB_PIN), 0);
+  busRun();
+  CHECK(!ldcAsyncGetSample(&sample));
+}
+
+static void testAsyncNack(void)
+{
+  ldcSample_t sample;
+  uint32_t errors;
+
+  stubReset();
+  modelReset();
+  busReset();
+  CHECK(ldcAsyncStart(LDC1612_CH0 | LDC1612_CH1));
+  busRun();
+
+  /* A NACKed STATUS read is repeated and the sample keeps the time of its edge */
+  stubRtccCounter = 100;
+  modelConvert(0, 0x00000011, 0);
+  modelConvert(1, 0x00000022, 0);
+  busNacks = 1;
+  intbEdge();
+  stubRtccCounter = 200;
+  busRun();
+  CHECK_EQ(ldcAsyncGetBusErrors(), 1);
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.timestamp, 100);
+  CHECK_EQ(sample.data[0], 0x00000011);
+  CHECK_EQ(sample.data[1], 0x00000022);
+  CHECK(!(stubSignals & APP_SIGNAL_LDC_STALL));
+
+  /* A NACK halfway restarts from STATUS, CH0 is kept and only CH1 is read again */
+  modelReset();
+  modelConvert(0, 0x00000033, 0);
+  modelConvert(1, 0x00000044, 0);
+  busNackFrom = busTransfers + 4;
+  busNacks = 1;
+  intbEdge();
+  busRun();
+  CHECK_EQ(model.reads, 3 + 3);
+  CHECK_EQ(model.readLog[3], LDC1612_REG_STATUS);
+  CHECK_EQ(model.readLog[4], LDC1612_REG_DATA1_MSB);
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.data[0], 0x00000033);
+  CHECK_EQ(sample.data[1], 0x00000044);
+  CHECK_EQ(ldcAsyncGetBusErrors(), 2);
+
+  /* Still NACKed after every restart: abandoned with INTB low, the main loop resumes it */
+  modelConvert(0, 0x00000055, 0);
+  modelConvert(1, 0x00000066, 0);
+  busNacks = 1 + LDC_READ_RETRIES;
+  intbEdge();
+  busRun();
+  CHECK_EQ(ldcAsyncGetBusErrors(), 2 + 1 + LDC_READ_RETRIES);
+  CHECK(stubSignals & APP_SIGNAL_LDC_STALL);
+  CHECK(!ldcAsyncGetSample(&sample));
+  CHECK_EQ(stubGpioIn & (1UL << LDC1612_INTB_PIN), 0);
+  ldcAsyncResume();
+  busRun();
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.data[0], 0x00000055);
+  CHECK_EQ(sample.data[1], 0x00000066);
+
+  /* A full I2C queue is retried the same way, then left to the main loop */
+  stubSignals = 0;
+  errors = ldcAsyncGetBusErrors();
+  modelConvert(0, 0x00000077, 0);
+  modelConvert(1, 0x00000088, 0);
+  busRejects = 1 + LDC_READ_RETRIES;
+  intbEdge();
+  CHECK_EQ(busQueued, 0);
+  CHECK_EQ(ldcAsyncGetBusErrors(), errors + 1 + LDC_READ_RETRIES);
+  CHECK(stubSignals & APP_SIGNAL_LDC_STALL);
+  ldcAsyncResume();
+  busRun();
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK_EQ(sample.data[0], 0x00000077);
+
+  /* Nothing to resume while INTB is high */
+  ldcAsyncResume();
+  CHECK_EQ(busQueued, 0);
+  CHECK(!ldcAsyncGetSample(&sample));
+
+  /* Nor while a sequence is being read */
+  modelConvert(0, 0x00000099, 0);
+  modelConvert(1, 0x000000AA, 0);
+  intbEdge();
+  ldcAsyncResume();
+  CHECK_EQ(busQueued, 1);
+  busRun();
+  CHECK(ldcAsyncGetSample(&sample));
+  CHECK(!ldcAsyncGetSample(&sample));
+  ldcAsyncStop();
+}
+
+int main(void)
+{
+  stubReset();
+  testSmSequence();
+  testSmSplit();
+  testSmNoFlags();
+  testSmErrors();
+  testConvTime();
+  testAsync();
+  testAsyncNack();
+  return checkResult("test_ldc");
+}
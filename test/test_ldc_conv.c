@@ -0,0 +1,100 @@
+/*
+ * test_ldc_conv.c
+ *
+ *  Integer frequency and inductance conversion of ldc_conv.h against a
+ *  double reference.
+ */
+
+#include <math.h>
+#include "ldc_conv.h"
+#include "check.h"
+
+/* Sensor frequency of a code in Hz, in double */
+static double refHz(uint32_t code)
+{
+  return (double)LDC_CONV_FREF_HZ * LDC_CONV_FIN_DIVIDER * code / (double)(1UL << LDC_CONV_CODE_BITS);
+}
+
+/* Inductance in nH at a frequency, in double */
+static double refNanoHenry(double hz)
+{
+  return 1.0e21 / (LDC_CONV_TANK_PF * 4.0 * M_PI * M_PI * hz * hz);
+}
+
+static void testFrequency(void)
+{
+  uint32_t code;
+  double hz, error, maxError = 0;
+
+  /* Whole 28 bit range, odd stride so that every low bit pattern comes up */
+  for (code = 0; code < (1UL << LDC_CONV_CODE_BITS); code += 4099)
+  {
+    hz = refHz(code);
+    error = fabs((double)ldcConvToDeciHz(code) - (hz * 10.0));
+    if (error > maxError)
+    {
+      maxError = error;
+    }
+    CHECK(error <= 0.5 + 1e-6);
+    CHECK_EQ(ldcConvToHz(code), (uint32_t)floor(hz));
+  }
+  printf("ldcConvToDeciHz: max error %.3f x 0.1 Hz\n", maxError);
+
+  /* Full scale stays within 32 bits */
+  code = (1UL << LDC_CONV_CODE_BITS) - 1;
+  CHECK_EQ(ldcConvToDeciHz(code), (uint32_t)floor((refHz(code) * 10.0) + 0.5));
+  CHECK_EQ(ldcConvToDeciHz(0), 0);
+}
+
+static void testInductance(void)
+{
+  uint32_t hz, i;
+  double ref, ppm, maxPpm = 0;
+
+  /* Table points are the rounded reference */
+  for (i = 0; i <= LDC_CONV_L_SEGMENTS; i++)
+  {
+    ref = refNanoHenry(LDC_CONV_L_FMIN_HZ + ((double)i * (1UL << LDC_CONV_L_STEP_LOG2)));
+    CHECK(fabs((double)ldcConvInductanceTable[i] - ref) <= 0.5);
+  }
+
+  /* Interpolation error peaks mid segment: 0.75 * (step / f)^2, 89 ppm at 3 MHz, plus 0.5 nH
+   * table rounding and 1 nH truncation, 53 ppm of the 28 uH there */
+  for (hz = LDC_CONV_L_FMIN_HZ; hz <= LDC_CONV_L_FMAX_HZ; hz += 97)
+  {
+    ref = refNanoHenry(hz);
+    ppm = fabs((double)ldcConvHzToNanoHenry(hz) - ref) * 1e6 / ref;
+    if (ppm > maxPpm)
+    {
+      maxPpm = ppm;
+    }
+    CHECK(ppm < 130.0);
+  }
+  printf("ldcConvHzToNanoHenry: max error %.1f ppm\n", maxPpm);
+
+  /* Monotonic, and clamped outside the table */
+  for (hz = LDC_CONV_L_FMIN_HZ; hz < LDC_CONV_L_FMAX_HZ; hz += 1021)
+  {
+    CHECK(ldcConvHzToNanoHenry(hz + 1021) <= ldcConvHzToNanoHenry(hz));
+  }
+  CHECK_EQ(ldcConvHzToNanoHenry(0), ldcConvInductanceTable[0]);
+  CHECK_EQ(ldcConvHzToNanoHenry(LDC_CONV_L_FMIN_HZ - 1), ldcConvInductanceTable[0]);
+  CHECK_EQ(ldcConvHzToNanoHenry(UINT32_MAX), ldcConvInductanceTable[LDC_CONV_L_SEGMENTS]);
+
+  /* From the code: the frequency truncation adds at most 1 Hz */
+  for (i = 0; i < 1000; i++)
+  {
+    uint32_t code = (uint32_t)(((uint64_t)(LDC_CONV_L_FMIN_HZ + (i * 2000)) << LDC_CONV_CODE_BITS)
+                               / (LDC_CONV_FREF_HZ * LDC_CONV_FIN_DIVIDER));
+
+    ref = refNanoHenry(refHz(code));
+    CHECK(fabs((double)ldcConvToNanoHenry(code) - ref) * 1e6 / ref < 130.0);
+  }
+}
+
+int main(void)
+{
+  testFrequency();
+  testInductance();
+  return checkResult("test_ldc_conv");
+}
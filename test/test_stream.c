@@ -0,0 +1,144 @@
+/*
+ * test_stream.c
+ *
+ *  Deadline handling of stream.c: partly filled frames are closed by
+ *  streamFlush() once due, streamNextDeadline() reports the wait for the
+ *  oldest one, also with several subscribers and a link out of TX buffers.
+ */
+
+#include <string.h>
+#include "stream.h"
+#include "check.h"
+
+/* STREAM_DEFAULT_DEADLINE_MS in RTCC ticks */
+#define DEADLINE        ((STREAM_DEFAULT_DEADLINE_MS * 32768) / 1000)
+
+static bool linkFull;
+static unsigned int sent[3];
+static uint8_t lastCount[3];
+static uint32_t lastTime[3];
+
+static bool send(uint8_t connection, const uint8_t *frame, uint16_t len)
+{
+  if (linkFull)
+  {
+    return false;
+  }
+  sent[connection]++;
+  lastTime[connection] = frame[2] | (frame[3] << 8) | (frame[4] << 16) | ((uint32_t)frame[5] << 24);
+  lastCount[connection] = frame[6] & STREAM_COUNT_MASK;
+  return true;
+}
+
+static void add(uint32_t timestamp)
+{
+  uint8_t sample[STREAM_SAMPLE_LEN];
+
+  memset(sample, (uint8_t)timestamp, sizeof(sample));
+  streamAdd(timestamp, sample);
+  streamService(send);
+}
+
+static void reset(void)
+{
+  streamInit();
+  streamSetDeadline(STREAM_DEFAULT_DEADLINE_MS);
+  linkFull = false;
+  memset(sent, 0, sizeof(sent));
+}
+
+/* The frame goes out when its deadline passes, without another sample */
+static void testFlush(void)
+{
+  uint32_t ticks;
+
+  reset();
+  CHECK(streamSubscribe(1, STREAM_MAX_PAYLOAD));
+  CHECK(!streamNextDeadline(0, &ticks));
+
+  add(1000);
+  add(1100);
+  add(1200);
+  CHECK_EQ(sent[1], 0);
+  CHECK(streamNextDeadline(1200, &ticks));
+  CHECK_EQ(ticks, DEADLINE - 200);
+
+  streamFlush(1000 + DEADLINE - 1, send);
+  CHECK_EQ(sent[1], 0);
+  CHECK(streamNextDeadline(1000 + DEADLINE - 1, &ticks));
+  CHECK_EQ(ticks, 1);
+
+  streamFlush(1000 + DEADLINE, send);
+  CHECK_EQ(sent[1], 1);
+  CHECK_EQ(lastCount[1], 3);
+  CHECK_EQ(lastTime[1], 1000);
+  CHECK(!streamNextDeadline(1000 + DEADLINE, &ticks));
+
+  /* Overdue by the time it is asked, the wait is still at least one tick */
+  add(5000);
+  CHECK(streamNextDeadline(5000 + 2 * DEADLINE, &ticks));
+  CHECK_EQ(ticks, 1);
+
+  /* A flush across the RTCC wrap */
+  reset();
+  CHECK(streamSubscribe(1, STREAM_MAX_PAYLOAD));
+  add(0xFFFFFF00);
+  streamFlush(0xFFFFFF00 + DEADLINE, send);
+  CHECK_EQ(sent[1], 1);
+  CHECK_EQ(lastTime[1], 0xFFFFFF00);
+}
+
+/* Each subscriber is due DEADLINE after its own first sample */
+static void testSubscribers(void)
+{
+  uint32_t ticks;
+
+  reset();
+  CHECK(streamSubscribe(1, STREAM_MAX_PAYLOAD));
+  add(1000);
+  CHECK(streamSubscribe(2, STREAM_MAX_PAYLOAD));
+  add(1400);
+
+  CHECK(streamNextDeadline(1400, &ticks));
+  CHECK_EQ(ticks, DEADLINE - 400);
+
+  streamFlush(1000 + DEADLINE, send);
+  CHECK_EQ(sent[1], 1);
+  CHECK_EQ(lastCount[1], 2);
+  CHECK_EQ(sent[2], 0);
+  CHECK(streamNextDeadline(1000 + DEADLINE, &ticks));
+  CHECK_EQ(ticks, 400);
+
+  streamFlush(1400 + DEADLINE, send);
+  CHECK_EQ(sent[2], 1);
+  CHECK_EQ(lastCount[2], 1);
+  CHECK_EQ(lastTime[2], 1400);
+  CHECK(!streamNextDeadline(1400 + DEADLINE, &ticks));
+}
+
+/* A closed frame waiting for a TX buffer has no deadline left and goes out with the next service */
+static void testLinkFull(void)
+{
+  uint32_t ticks;
+
+  reset();
+  CHECK(streamSubscribe(1, STREAM_MAX_PAYLOAD));
+  add(1000);
+  linkFull = true;
+  streamFlush(1000 + DEADLINE, send);
+  CHECK_EQ(sent[1], 0);
+  CHECK(!streamNextDeadline(1000 + DEADLINE, &ticks));
+
+  linkFull = false;
+  streamService(send);
+  CHECK_EQ(sent[1], 1);
+  CHECK_EQ(lastCount[1], 1);
+}
+
+int main(void)
+{
+  testFlush();
+  testSubscribers();
+  testLinkFull();
+  return checkResult("test_stream");
+}
@@ -0,0 +1,197 @@
+/*
+ * test_stream_codec.c
+ *
+ *  Round trips of stream_codec.h over slow, noisy, stepping and full range
+ *  signals, truncated frames, and a benchmark of encoding and decoding
+ *  full size frames.
+ */
+
+#include <math.h>
+#include "stream_codec.h"
+#include "check.h"
+
+/* Codec bytes in the largest frame, STREAM_MAX_PAYLOAD - STREAM_HEADER_LEN */
+#define FRAME_LEN       237
+#define MAX_SAMPLES     ((FRAME_LEN * 8) / 4)
+
+typedef void (*signal_t)(uint32_t i, uint32_t *v);
+
+static uint32_t rngState = 1;
+
+static uint32_t rng(void)
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+/* Slowly moving coils and PA0 with a little noise, regular sampling */
+static void signalSlow(uint32_t i, uint32_t *v)
+{
+  v[0] = 0x02000000 + (uint32_t)(20000.0 * sin(i * 0.05)) + (rng() & 0x1F);
+  v[1] = 0x01800000 + (uint32_t)(15000.0 * cos(i * 0.03)) + (rng() & 0x1F);
+  v[2] = (uint32_t)(32768 + (int32_t)(8000.0 * sin(i * 0.2))) & 0xFFF0;
+  v[3] = 328;
+}
+
+/* Every bit random, the worst case for the Rice code */
+static void signalRandom(uint32_t i, uint32_t *v)
+{
+  (void)i;
+  v[0] = rng() & 0x0FFFFFFF;
+  v[1] = rng() & 0x0FFFFFFF;
+  v[2] = rng() & 0xFFFF;
+  v[3] = rng() & 0xFFFF;
+}
+
+/* Long flat stretches and full scale steps, including wrap around */
+static void signalSteps(uint32_t i, uint32_t *v)
+{
+  v[0] = ((i / 7) & 1) ? 0x0FFFFFFF : 0;
+  v[1] = ((i / 3) & 1) ? 0x00000001 : 0x0FFFFFFE;
+  v[2] = ((i / 5) & 1) ? 0xFFF0 : 0x0000;
+  v[3] = (i % 11 == 0) ? 0xFFFF : 327;
+}
+
+/* Fill one frame, decode it and compare; returns the samples in it */
+static uint32_t roundTrip(signal_t signal, uint32_t start, uint32_t len, uint8_t adcShift)
+{
+  static uint32_t in[MAX_SAMPLES][STREAM_CODEC_CHANNELS];
+  static uint32_t out[MAX_SAMPLES][STREAM_CODEC_CHANNELS];
+  uint8_t buf[FRAME_LEN];
+  streamCodec_t c;
+  uint32_t n, i, ch, decoded, mismatches = 0;
+
+  streamCodecBegin(&c, buf, len, adcShift);
+  for (n = 0; n < MAX_SAMPLES; n++)
+  {
+    signal(start + n, in[n]);
+    if (!streamCodecAdd(&c, in[n]))
+    {
+      break;
+    }
+  }
+  CHECK(n > 0);
+  CHECK(streamCodecBytes(&c) <= len);
+  CHECK(!streamCodecRoom(&c) || (n == MAX_SAMPLES));
+
+  decoded = streamCodecDecode(buf, streamCodecBytes(&c), n, out);
+  CHECK_EQ(decoded, n);
+  for (i = 0; i < decoded; i++)
+  {
+    for (ch = 0; ch < STREAM_CODEC_CHANNELS; ch++)
+    {
+      if (out[i][ch] != ((ch == 2) ? (in[i][ch] & (0xFFFFUL << adcShift) & 0xFFFF)
+                         : (in[i][ch] & ((1UL << c.width[ch]) - 1))))
+      {
+        mismatches++;
+      }
+    }
+  }
+  CHECK_EQ(mismatches, 0);
+  return n;
+}
+
+static void testRoundTrip(void)
+{
+  static const signal_t signals[] = { signalSlow, signalRandom, signalSteps };
+  uint32_t s, start, len, n;
+
+  for (s = 0; s < sizeof(signals) / sizeof(signals[0]); s++)
+  {
+    for (start = 0; start < 2000; start += 97)
+    {
+      /* Default MTU payload up to the largest one */
+      for (len = 20; len <= FRAME_LEN; len += 107)
+      {
+        roundTrip(signals[s], start, len, 4);
+        roundTrip(signals[s], start, len, 0);
+      }
+    }
+  }
+
+  /* Even random samples fit once the frame has room for the worst case */
+  n = roundTrip(signalRandom, 0, FRAME_LEN, 0);
+  CHECK(n >= ((FRAME_LEN * 8) - 8 - (4 * 28)) / STREAM_CODEC_WORST_BITS);
+
+  /* The first sample is bit-packed */
+  n = roundTrip(signalSlow, 0, 1 + ((28 + 28 + 12 + 16) / 8) + 1, 4);
+  CHECK_EQ(n, 1);
+}
+
+static void testTruncated(void)
+{
+  static uint32_t in[MAX_SAMPLES][STREAM_CODEC_CHANNELS];
+  static uint32_t out[MAX_SAMPLES][STREAM_CODEC_CHANNELS];
+  uint8_t buf[FRAME_LEN];
+  streamCodec_t c;
+  uint32_t n, len, decoded, i;
+
+  streamCodecBegin(&c, buf, FRAME_LEN, 4);
+  for (n = 0; n < MAX_SAMPLES; n++)
+  {
+    signalSlow(n, in[n]);
+    if (!streamCodecAdd(&c, in[n]))
+    {
+      break;
+    }
+  }
+
+  /* A short payload decodes the samples it holds completely and nothing more */
+  for (len = 0; len <= streamCodecBytes(&c); len++)
+  {
+    decoded = streamCodecDecode(buf, len, n, out);
+    CHECK(decoded <= n);
+    for (i = 0; i < decoded; i++)
+    {
+      CHECK_EQ(out[i][0], in[i][0]);
+      CHECK_EQ(out[i][3], in[i][3]);
+    }
+  }
+  CHECK_EQ(streamCodecDecode(buf, 0, n, out), 0);
+}
+
+static void benchmark(void)
+{
+  static uint32_t in[MAX_SAMPLES][STREAM_CODEC_CHANNELS];
+  static uint32_t out[MAX_SAMPLES][STREAM_CODEC_CHANNELS];
+  uint8_t buf[FRAME_LEN];
+  streamCodec_t c;
+  uint32_t frame, n, samples = 0, bytes = 0;
+  uint64_t t0, encNs = 0, decNs = 0;
+
+  for (frame = 0; frame < 2000; frame++)
+  {
+    for (n = 0; n < MAX_SAMPLES; n++)
+    {
+      signalSlow((frame * MAX_SAMPLES) + n, in[n]);
+    }
+
+    t0 = checkNowNs();
+    streamCodecBegin(&c, buf, FRAME_LEN, 4);
+    for (n = 0; (n < MAX_SAMPLES) && streamCodecAdd(&c, in[n]); n++)
+    {
+    }
+    encNs += checkNowNs() - t0;
+
+    t0 = checkNowNs();
+    CHECK_EQ(streamCodecDecode(buf, streamCodecBytes(&c), n, out), n);
+    decNs += checkNowNs() - t0;
+
+    samples += n;
+    bytes += streamCodecBytes(&c);
+  }
+  printf("stream codec: %.2f samples per %u byte frame, %.1fx against 11 byte packed samples, "
+         "encode %.0f ns, decode %.0f ns per sample\n",
+         (double)samples / frame, FRAME_LEN, (samples * 11.0) / bytes,
+         (double)encNs / samples, (double)decNs / samples);
+}
+
+int main(void)
+{
+  testRoundTrip();
+  testTruncated();
+  benchmark();
+  return checkResult("test_stream_codec");
+}
@@ -0,0 +1,128 @@
+/*
+ * tick_sched.h
+ *
+ *  Exact millisecond periods on the 32768 Hz RTCC and jitter statistics of
+ *  scheduled events. A period that is not a whole number of ticks, 10 ms is
+ *  327.68, alternates between the neighbouring tick counts so that the
+ *  average rate is exact. Plain C without device headers, like adc_conv.h.
+ */
+
+#ifndef TICK_SCHED_H_
+#define TICK_SCHED_H_
+#include <stdint.h>
+
+#define TICK_SCHED_HZ           32768UL                 /* RTCC ticks per second */
+
+typedef struct
+{
+  uint32_t step;                /* Whole ticks per period */
+  uint32_t frac;                /* Remaining ticks per period, in 1/1000 */
+  uint32_t acc;                 /* Accumulated fraction, in 1/1000 */
+} tickSched_t;
+
+/* Deviation of events from their schedule in ticks */
+typedef struct
+{
+  uint32_t count;               /* Events measured */
+  int32_t min;                  /* Earliest event */
+  int32_t max;                  /* Latest event */
+  uint32_t sumAbs;              /* Sum of the absolute deviations */
+  uint32_t skipped;             /* Events dropped because they were already over */
+} tickJitter_t;
+
+/**************************************************************************//**
+ * @brief Set the period of a schedule.
+ * @param[in] ms
+ *   Period in ms.
+ *****************************************************************************/
+static inline void tickSchedInit(tickSched_t *sched, uint32_t ms)
+{
+  uint32_t ticks1000 = TICK_SCHED_HZ * ms;
+
+  sched->step = ticks1000 / 1000;
+  sched->frac = ticks1000 % 1000;
+  sched->acc = 0;
+}
+
+/**************************************************************************//**
+ * @brief Ticks to the next event.
+ * @return
+ *   step or step + 1, averaging to exactly the period.
+ *****************************************************************************/
+static inline uint32_t tickSchedNext(tickSched_t *sched)
+{
+  sched->acc += sched->frac;
+  if (sched->acc >= 1000)
+  {
+    sched->acc -= 1000;
+    return sched->step + 1;
+  }
+  return sched->step;
+}
+
+/**************************************************************************//**
+ * @brief First event of a schedule that is still ahead.
+ *
+ * After a stall longer than a period the next event may already be over;
+ * arming a compare to a passed time would wait for the counter to wrap.
+ * Whole periods are skipped instead, so the schedule keeps its phase.
+ * @param[in] due
+ *   Time of the event that just happened.
+ * @param[in] now
+ *   Current time.
+ * @return
+ *   Time of the next event, after now.
+ *****************************************************************************/
+static inline uint32_t tickSchedAfter(tickSched_t *sched, tickJitter_t *jitter, uint32_t due,
+                                      uint32_t now)
+{
+  uint32_t next = due + tickSchedNext(sched);
+
+  while ((int32_t)(next - now) <= 0)
+  {
+    next += tickSchedNext(sched);
+    jitter->skipped++;
+  }
+  return next;
+}
+
+/**************************************************************************//**
+ * @brief Clear jitter statistics.
+ *****************************************************************************/
+static inline void tickJitterReset(tickJitter_t *jitter)
+{
+  jitter->count = 0;
+  jitter->min = INT32_MAX;
+  jitter->max = INT32_MIN;
+  jitter->sumAbs = 0;
+  jitter->skipped = 0;
+}
+
+/**************************************************************************//**
+ * @brief Account one event.
+ * @param[in] deviation
+ *   Actual minus scheduled time in ticks.
+ *****************************************************************************/
+static inline void tickJitterUpdate(tickJitter_t *jitter, int32_t deviation)
+{
+  if (deviation < jitter->min)
+  {
+    jitter->min = deviation;
+  }
+  if (deviation > jitter->max)
+  {
+    jitter->max = deviation;
+  }
+  jitter->sumAbs += (uint32_t)((deviation < 0) ? -deviation : deviation);
+  jitter->count++;
+}
+
+/**************************************************************************//**
+ * @brief Ticks to microseconds, for display.
+ *****************************************************************************/
+static inline int32_t tickToMicroSec(int32_t ticks)
+{
+  return (int32_t)(((int64_t)ticks * 1000000) / (int32_t)TICK_SCHED_HZ);
+}
+
+#endif /* TICK_SCHED_H_ */